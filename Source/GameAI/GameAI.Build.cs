@@ -9,5 +9,9 @@ public class GameAI : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "ProceduralMeshComponent", "NavigationSystem" });
+
+		// Memory layout of per-cell grid data, see Grid/GAGridLayout.h
+		// 0 = row-major (default), 1 = 8x8 tiles, 2 = Morton order within 8x8 tiles
+		//PublicDefinitions.Add("GA_GRID_LAYOUT=1");
 	}
 }
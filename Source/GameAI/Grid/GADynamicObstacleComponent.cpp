@@ -0,0 +1,113 @@
+#include "GADynamicObstacleComponent.h"
+#include "GAGridActor.h"
+#include "GAGridSubsystem.h"
+
+
+UGADynamicObstacleComponent::UGADynamicObstacleComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Shape = EGAObstacleShape::Circle;
+	BoxExtents = FVector2D(50.0f, 50.0f);
+	Radius = 50.0f;
+	bBlocking = true;
+}
+
+
+AGAGridActor* UGADynamicObstacleComponent::GetGridActor() const
+{
+	AGAGridActor* Result = GridActor.Get();
+	if (Result)
+	{
+		return Result;
+	}
+	else
+	{
+		// With several grids around, the one that matters is the one we're standing on
+		UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+		if (GridSubsystem)
+		{
+			Result = GridSubsystem->FindGridAt(GetComponentLocation());
+			if (!Result)
+			{
+				Result = GridSubsystem->GetDefaultGrid();
+			}
+
+			if (Result)
+			{
+				// Cache the result
+				// Note, GridActor is marked as mutable in the header, which is why this is allowed in a const method
+				GridActor = Result;
+			}
+		}
+
+		return Result;
+	}
+}
+
+
+void UGADynamicObstacleComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AGAGridActor* Grid = GetGridActor();
+	if (Grid)
+	{
+		Grid->RegisterDynamicObstacle(this);
+	}
+}
+
+
+void UGADynamicObstacleComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AGAGridActor* Grid = GridActor.Get();
+	if (Grid)
+	{
+		Grid->UnregisterDynamicObstacle(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UGADynamicObstacleComponent::SetBlocking(bool bNewBlocking)
+{
+	// The grid notices the change next time it updates its obstacles
+	bBlocking = bNewBlocking;
+}
+
+
+void UGADynamicObstacleComponent::GetFootprint(const AGAGridActor* Grid, FGAObstacleFootprint& FootprintOut) const
+{
+	const FGAGridAffine& Affine = Grid->GetGridAffine();
+	FTransform Transform = GetComponentTransform();
+
+	FootprintOut.Shape = Shape;
+	FootprintOut.Center = Affine.WorldToGrid(Transform.GetLocation());
+
+	if (Shape == EGAObstacleShape::Circle)
+	{
+		FootprintOut.Radius = Radius * Transform.GetMaximumAxisScale() / Grid->CellScale;
+		FootprintOut.Bounds = FBox2D(FootprintOut.Center - FVector2D(FootprintOut.Radius), FootprintOut.Center + FVector2D(FootprintOut.Radius));
+	}
+	else
+	{
+		// Take the box axes into grid space. Anything out of the grid plane gets flattened away.
+		FVector WorldAxisX = Transform.TransformVectorNoScale(FVector::XAxisVector);
+		FVector WorldAxisY = Transform.TransformVectorNoScale(FVector::YAxisVector);
+
+		FootprintOut.AxisX = FVector2D(WorldAxisX | Affine.WorldToGridX, WorldAxisX | Affine.WorldToGridY).GetSafeNormal();
+		FootprintOut.AxisY = FVector2D(-FootprintOut.AxisX.Y, FootprintOut.AxisX.X);
+		if ((FVector2D(WorldAxisY | Affine.WorldToGridX, WorldAxisY | Affine.WorldToGridY) | FootprintOut.AxisY) < 0.0f)
+		{
+			FootprintOut.AxisY = -FootprintOut.AxisY;
+		}
+
+		FVector Scale = Transform.GetScale3D().GetAbs();
+		FootprintOut.HalfExtents = FVector2D(BoxExtents.X * Scale.X, BoxExtents.Y * Scale.Y) / Grid->CellScale;
+
+		FVector2D BoundsExtents(
+			FMath::Abs(FootprintOut.AxisX.X) * FootprintOut.HalfExtents.X + FMath::Abs(FootprintOut.AxisY.X) * FootprintOut.HalfExtents.Y,
+			FMath::Abs(FootprintOut.AxisX.Y) * FootprintOut.HalfExtents.X + FMath::Abs(FootprintOut.AxisY.Y) * FootprintOut.HalfExtents.Y);
+		FootprintOut.Bounds = FBox2D(FootprintOut.Center - BoundsExtents, FootprintOut.Center + BoundsExtents);
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "GADynamicObstacleComponent.generated.h"
+
+
+class AGAGridActor;
+
+UENUM(BlueprintType)
+enum class EGAObstacleShape : uint8
+{
+	Box				UMETA(DisplayName = "Box"),			// BoxExtents around the component, rotated with it (yaw only)
+	Circle			UMETA(DisplayName = "Circle"),		// Radius around the component
+};
+
+
+// An obstacle's footprint, flattened into normalized grid space (where a cell is 1.0 units wide)
+struct FGAObstacleFootprint
+{
+	EGAObstacleShape Shape = EGAObstacleShape::Circle;
+
+	FVector2D Center = FVector2D::ZeroVector;
+
+	// Unit axes of the box, in grid space
+	FVector2D AxisX = FVector2D(1.0f, 0.0f);
+	FVector2D AxisY = FVector2D(0.0f, 1.0f);
+
+	// Box half size or circle radius, in cells
+	FVector2D HalfExtents = FVector2D::ZeroVector;
+	float Radius = 0.0f;
+
+	// Conservative bounds of the footprint
+	FBox2D Bounds = FBox2D(EForceInit::ForceInit);
+
+	bool operator==(const FGAObstacleFootprint& Other) const
+	{
+		return (Shape == Other.Shape) && (Center == Other.Center) && (AxisX == Other.AxisX) && (AxisY == Other.AxisY) && (HalfExtents == Other.HalfExtents) && (Radius == Other.Radius);
+	}
+
+	FORCEINLINE bool Contains(const FVector2D& GridPoint) const
+	{
+		FVector2D Delta = GridPoint - Center;
+		if (Shape == EGAObstacleShape::Circle)
+		{
+			return Delta.SizeSquared() <= Radius * Radius;
+		}
+		return (FMath::Abs(Delta | AxisX) <= HalfExtents.X) && (FMath::Abs(Delta | AxisY) <= HalfExtents.Y);
+	}
+};
+
+
+// Something that moves around and blocks grid cells while it's there -- a crate, a door, another pawn.
+// While registered, the grid actor stamps its 2D footprint into its dynamic-blocked layer every frame it moves.
+// A cell counts as covered if its center is inside the footprint.
+UCLASS(BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
+class UGADynamicObstacleComponent : public USceneComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	EGAObstacleShape Shape;
+
+	// Half size of the footprint along the component's X and Y axes, for Box obstacles
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FVector2D BoxExtents;
+
+	// For Circle obstacles
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float Radius;
+
+	// Whether we are currently blocking. Turn off for e.g. an open door.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bBlocking;
+
+	// Cached pointer to the grid actor we're registered with: the one under us when we were first asked
+	// (see UGAGridSubsystem::FindGridAt), or the default grid if there isn't one
+	UPROPERTY()
+	mutable TSoftObjectPtr<AGAGridActor> GridActor;
+
+	UFUNCTION(BlueprintCallable)
+	AGAGridActor* GetGridActor() const;
+
+	UFUNCTION(BlueprintCallable)
+	void SetBlocking(bool bNewBlocking);
+
+	// Work out where our footprint currently falls on the given grid
+	void GetFootprint(const AGAGridActor* Grid, FGAObstacleFootprint& FootprintOut) const;
+
+	// Registers us with the grid actor
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -5,23 +5,72 @@
 #include "ProceduralMeshComponent.h"
 #include "NavigationSystem.h"
 #include "NavMesh/RecastNavMesh.h"
+#include "NavAreas/NavArea.h"
 #include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+#include "Math/VectorRegister.h"
+#include "EngineUtils.h"
+#include "GAGridChunkActor.h"
+#include "GAGridSubsystem.h"
 
 
 FCellRef FCellRef::Invalid(INDEX_NONE, INDEX_NONE);
 
 
+void FGAGridChunk::Compact()
+{
+	if ((State == EGAGridChunkState::Dense) && (Cells.Num() > 0))
+	{
+		ECellData FirstValue = Cells[0];
+		for (ECellData Value : Cells)
+		{
+			if (Value != FirstValue)
+			{
+				return;
+			}
+		}
+
+		State = EGAGridChunkState::Uniform;
+		UniformValue = FirstValue;
+		Cells.Empty();
+	}
+}
+
+
+const FIntPoint AGAGridActor::NeighborOffsets[8] =
+{
+	FIntPoint(-1, -1), FIntPoint(0, -1), FIntPoint(1, -1),
+	FIntPoint(-1, 0),                    FIntPoint(1, 0),
+	FIntPoint(-1, 1),  FIntPoint(0, 1),  FIntPoint(1, 1)
+};
+
+
 AGAGridActor::AGAGridActor(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
 {
 	XCount = 100;
 	YCount = 100;
 	CellScale = 100.0f;
+	bChunkedStorage = false;
+	GridVersion = 0;
+	bBakeCover = false;
+	CoverTraceHeight = 60.0f;
+	CoverTraceChannel = ECollisionChannel::ECC_Visibility;
+
+	// We only tick while there are dynamic obstacles to keep up with
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 	RefreshDerivedValues();
 
 	SceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
 	RootComponent = SceneComponent;
 
+	// Any time we move, the cached world <-> grid mapping goes stale
+	bCachedAffineDirty = true;
+	SceneComponent->TransformUpdated.AddUObject(this, &AGAGridActor::OnRootTransformUpdated);
+
 #if WITH_EDITORONLY_DATA
 	BoxComponent = CreateDefaultSubobject<UBoxComponent>(TEXT("Box"));
 	BoxComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -37,6 +86,14 @@ AGAGridActor::AGAGridActor(const FObjectInitializer& ObjectInitializer)
 	DebugMeshComponent->SetVisibility(false);
 
 	DebugMeshZOffset = 30.0f;
+	DebugMeshMode = EGADebugMeshMode::SingleQuad;
+	DebugMeshTileSize = 16;
+	DebugMeshBuildSerial = 0;
+	DebugTextureGridVersion = INDEX_NONE;
+	DebugTextureValueScale = 0.0f;
+	bDebugTextureFillInFlight = false;
+	bDebugTextureRefreshPending = false;
+	TraversableSumTableVersion = INDEX_NONE;
 
 }
 
@@ -47,9 +104,72 @@ void AGAGridActor::PostLoad()
 #endif //WITH_EDITORONLY_DATA
 
 	RefreshDerivedValues();
+	RefreshCachedCellDataInRect(GetGridRect());
 	Super::PostLoad();
 }
 
+void AGAGridActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Pick up any chunk actors that were streamed in before we were
+	if (bChunkedStorage)
+	{
+		for (TActorIterator<AGAGridChunkActor> It(GetWorld()); It; ++It)
+		{
+			AGAGridChunkActor* ChunkActor = *It;
+			if (ChunkActor->HasActorBegunPlay() && (ChunkActor->GridActor.Get() == this))
+			{
+				LoadChunk(ChunkActor->ChunkCoord, ChunkActor->Chunk);
+			}
+		}
+	}
+}
+
+void AGAGridActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateDynamicObstacles();
+}
+
+void AGAGridActor::PostRegisterAllComponents()
+{
+	Super::PostRegisterAllComponents();
+
+	// The root's world transform is only known once it's registered
+	bCachedAffineDirty = true;
+
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+	if (GridSubsystem)
+	{
+		GridSubsystem->RegisterGrid(this);
+	}
+}
+
+void AGAGridActor::PostUnregisterAllComponents()
+{
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+	if (GridSubsystem)
+	{
+		GridSubsystem->UnregisterGrid(this);
+	}
+
+	Super::PostUnregisterAllComponents();
+}
+
+void AGAGridActor::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	bCachedAffineDirty = true;
+
+	// Our bounds moved with us
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+	if (GridSubsystem)
+	{
+		GridSubsystem->UpdateGrid(this);
+	}
+}
+
 
 #if WITH_EDITORONLY_DATA
 void AGAGridActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
@@ -86,12 +206,77 @@ void AGAGridActor::RefreshDerivedValues()
 	// Refresh HalfExtents
 	HalfExtents.X = 0.5f * CellScale * float(XCount);
 	HalfExtents.Y = 0.5f * CellScale * float(YCount);
+
+	// Round up, so partial chunks along the far edges are still covered
+	ChunkXCount = (XCount + FGAGridChunk::SizeMask) >> FGAGridChunk::SizeShift;
+	ChunkYCount = (YCount + FGAGridChunk::SizeMask) >> FGAGridChunk::SizeShift;
+
+	// Cell scale and extents feed into the cached grid mapping
+	bCachedAffineDirty = true;
+
+	// And our bounds
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+	if (GridSubsystem)
+	{
+		GridSubsystem->UpdateGrid(this);
+	}
+}
+
+
+const FGAGridAffine& AGAGridActor::GetGridAffine() const
+{
+	if (bCachedAffineDirty)
+	{
+		FTransform GridTransform = GetActorTransform();
+
+		CachedAffine.GridOrigin = GridTransform.TransformPosition(FVector(-HalfExtents.X, -HalfExtents.Y, 0.0f));
+		CachedAffine.GridAxisX = GridTransform.TransformVector(FVector(CellScale, 0.0f, 0.0f));
+		CachedAffine.GridAxisY = GridTransform.TransformVector(FVector(0.0f, CellScale, 0.0f));
+		CachedAffine.GridAxisZ = GridTransform.TransformVector(FVector::ZAxisVector);
+
+		// Column N of the inverse linear part is the inverse transform of basis vector N.
+		// We only care about the X and Y rows, since we drop Z going into grid space.
+		FVector InvX = GridTransform.InverseTransformVector(FVector::XAxisVector);
+		FVector InvY = GridTransform.InverseTransformVector(FVector::YAxisVector);
+		FVector InvZ = GridTransform.InverseTransformVector(FVector::ZAxisVector);
+
+		CachedAffine.WorldToGridX = FVector(InvX.X, InvY.X, InvZ.X) / CellScale;
+		CachedAffine.WorldToGridY = FVector(InvX.Y, InvY.Y, InvZ.Y) / CellScale;
+
+		bCachedAffineDirty = false;
+	}
+
+	return CachedAffine;
 }
 
 
 bool AGAGridActor::ResetData()
 {
 	bool Result = false;
+
+	ResetDataInternal();
+	NotifyCellsChanged(GetGridRect());
+
+	return Result;
+}
+
+
+void AGAGridActor::SetDimensions(int32 InXCount, int32 InYCount)
+{
+	XCount = FMath::Max(InXCount, 1);
+	YCount = FMath::Max(InYCount, 1);
+
+#if WITH_EDITORONLY_DATA
+	RefreshBoxComponent();
+#endif // WITH_EDITORONLY_DATA
+
+	RefreshDerivedValues();
+	ResetData();
+}
+
+
+void AGAGridActor::ResetDataInternal()
+{
 	Data.SetNum(GetCellCount());
 
 	ECellData* GridData = GetData();
@@ -100,168 +285,704 @@ bool AGAGridActor::ResetData()
 		memset(GridData, 0, GetCellCount() * sizeof(ECellData));
 	}
 
-	return Result;
+	// The extra channels get (re)baked along with Data, if at all
+	TraversalCosts.Reset();
+	CoverDirections.Reset();
+	CellHeights.Reset();
+
+	if (bChunkedStorage)
+	{
+		// Data is the staging area while we (re)build. Clear the chunks too, so the two don't disagree.
+		Chunks.Reset();
+		Chunks.SetNum(ChunkXCount * ChunkYCount);
+		for (FGAGridChunk& Chunk : Chunks)
+		{
+			Chunk.State = EGAGridChunkState::Uniform;
+		}
+	}
 }
 
-// Return the cell the given point is inside of
-// If bClamp = true, then any point outside of the grid will be clamped to the bounds of the grid
-// Otherwise, if the point is outside the grid, it will return FCellRef::Invalid
 
-FCellRef AGAGridActor::GetCellRef(const FVector& Point, bool bClamp) const
+bool AGAGridActor::ClipRectToGrid(FIntRect& Rect) const
 {
-	// First, transform the point into grid-local space
-	// note, we drop the Z dimension at this point, by casting to a FVector2D
-	FTransform GridTransform = GetActorTransform();
-	FVector2D LocalPoint = FVector2D(GridTransform.InverseTransformPosition(Point));
+	Rect.Min.X = FMath::Max(Rect.Min.X, 0);
+	Rect.Min.Y = FMath::Max(Rect.Min.Y, 0);
+	Rect.Max.X = FMath::Min(Rect.Max.X, XCount - 1);
+	Rect.Max.Y = FMath::Min(Rect.Max.Y, YCount - 1);
 
-	if (bClamp)
+	return (Rect.Min.X <= Rect.Max.X) && (Rect.Min.Y <= Rect.Max.Y);
+}
+
+
+// Change tracking --------------------------------
+
+void AGAGridActor::NotifyCellsChanged(const FIntRect& Rect)
+{
+	FIntRect ChangedRect = Rect;
+	if (!ClipRectToGrid(ChangedRect))
 	{
-		LocalPoint.X = FMath::Clamp(LocalPoint.X, -HalfExtents.X, HalfExtents.X);
-		LocalPoint.Y = FMath::Clamp(LocalPoint.Y, -HalfExtents.Y, HalfExtents.Y);
+		return;
 	}
-	else if (FMath::Abs(LocalPoint.X) > HalfExtents.X || FMath::Abs(LocalPoint.Y) > HalfExtents.Y)
+
+	// The dimensions changed since we last saw a write. We can't say what changed where, so treat every chunk as current.
+	if (ChunkVersions.Num() != ChunkXCount * ChunkYCount)
 	{
-		return FCellRef::Invalid;
+		ChunkVersions.Init(GridVersion, ChunkXCount * ChunkYCount);
 	}
 
-	LocalPoint += HalfExtents;		// Now LocalPoint is relative the to the (0, 0) corner of grid
+	GridVersion++;
 
-	// Discretize by dividing by scale and flooring
-	// Out of an abundance of caution we also clamp the result to a valid index, to avoid any floating-point issues
+	for (int32 ChunkY = ChangedRect.Min.Y >> FGAGridChunk::SizeShift; ChunkY <= (ChangedRect.Max.Y >> FGAGridChunk::SizeShift); ChunkY++)
+	{
+		for (int32 ChunkX = ChangedRect.Min.X >> FGAGridChunk::SizeShift; ChunkX <= (ChangedRect.Max.X >> FGAGridChunk::SizeShift); ChunkX++)
+		{
+			ChunkVersions[ChunkY * ChunkXCount + ChunkX] = GridVersion;
+		}
+	}
 
-	FCellRef Result(
-		FMath::Clamp(FMath::FloorToInt32(LocalPoint.X / CellScale), 0, XCount - 1),
-		FMath::Clamp(FMath::FloorToInt32(LocalPoint.Y / CellScale), 0, YCount - 1)
-	);
-	return Result;
+	RefreshCachedCellDataInRect(ChangedRect);
+
+	OnCellsChanged.Broadcast(this, ChangedRect);
 }
 
-FVector AGAGridActor::GetCellPosition(const FCellRef& CellRef) const
-{
-	float HalfScale = 0.5f * CellScale;
 
-	// Grab the center of the cell, then offset by -HalfExtents, so that it is relative to the center of the grid
-	FVector LocalResult;
-	LocalResult.X = CellRef.X * CellScale + HalfScale - HalfExtents.X;
-	LocalResult.Y = CellRef.Y * CellScale + HalfScale - HalfExtents.Y;
-	LocalResult.Z = 0.0f;
+int32 AGAGridActor::GetChunkVersion(const FIntPoint& ChunkCoord) const
+{
+	if (IsValidChunk(ChunkCoord) && (ChunkVersions.Num() == ChunkXCount * ChunkYCount))
+	{
+		return ChunkVersions[ChunkCoord.Y * ChunkXCount + ChunkCoord.X];
+	}
 
-	FTransform ActorTransform = GetActorTransform();
-	FVector Result = ActorTransform.TransformPosition(LocalResult);
-	return Result;
+	return GridVersion;
 }
 
-FVector2D AGAGridActor::GetCellGridSpacePosition(const FCellRef& CellRef) const
+
+int32 AGAGridActor::GetRegionVersion(const FIntRect& Rect) const
 {
-	float HalfScale = 0.5f * CellScale;
+	FIntRect ClippedRect = Rect;
+	if (!ClipRectToGrid(ClippedRect))
+	{
+		return 0;
+	}
 
-	// Grab the center of the cell, then offset by -HalfExtents, so that it is relative to the center of the grid
-	FVector2D LocalResult;
-	LocalResult.X = CellRef.X * CellScale + HalfScale;
-	LocalResult.Y = CellRef.Y * CellScale + HalfScale;
+	if (ChunkVersions.Num() != ChunkXCount * ChunkYCount)
+	{
+		return GridVersion;
+	}
 
-	return LocalResult;
+	int32 Version = 0;
+	for (int32 ChunkY = ClippedRect.Min.Y >> FGAGridChunk::SizeShift; ChunkY <= (ClippedRect.Max.Y >> FGAGridChunk::SizeShift); ChunkY++)
+	{
+		for (int32 ChunkX = ClippedRect.Min.X >> FGAGridChunk::SizeShift; ChunkX <= (ClippedRect.Max.X >> FGAGridChunk::SizeShift); ChunkX++)
+		{
+			Version = FMath::Max(Version, ChunkVersions[ChunkY * ChunkXCount + ChunkX]);
+		}
+	}
+
+	return Version;
 }
 
 
+bool AGAGridActor::SetCellData(const FCellRef& CellRef, ECellData Value)
+{
+	if (!IsValidCell(CellRef))
+	{
+		return false;
+	}
+
+	if (Data.Num() == GetCellCount())
+	{
+		ECellData& CellData = Data[CellRefToIndex(CellRef)];
+		if (CellData == Value)
+		{
+			return true;
+		}
+		CellData = Value;
+	}
+	else if (bChunkedStorage && (Chunks.Num() == ChunkXCount * ChunkYCount))
+	{
+		FGAGridChunk& Chunk = Chunks[GetChunkCoord(CellRef).Y * ChunkXCount + GetChunkCoord(CellRef).X];
+		int32 LocalX = CellRef.X & FGAGridChunk::SizeMask;
+		int32 LocalY = CellRef.Y & FGAGridChunk::SizeMask;
 
-ECellData AGAGridActor::GetCellData(const FCellRef &CellRef) const
+		if (Chunk.State == EGAGridChunkState::Unloaded)
+		{
+			// Nowhere to put it. Whatever streams the chunk in will bring its own data.
+			return false;
+		}
+		if (Chunk.GetCellData(LocalX, LocalY) == Value)
+		{
+			return true;
+		}
+		if (Chunk.State == EGAGridChunkState::Uniform)
+		{
+			Chunk.Cells.Init(Chunk.UniformValue, FGAGridChunk::Size * FGAGridChunk::Size);
+			Chunk.State = EGAGridChunkState::Dense;
+		}
+		Chunk.Cells[(LocalY << FGAGridChunk::SizeShift) + LocalX] = Value;
+	}
+	else
+	{
+		return false;
+	}
+
+	NotifyCellsChanged(FIntRect(CellRef.X, CellRef.Y, CellRef.X, CellRef.Y));
+	return true;
+}
+
+
+void AGAGridActor::RefreshCachedCellData()
 {
-	int32 CellIndex = CellRefToIndex(CellRef);
-	return Data[CellIndex];
+	// Data may have been written from anywhere, so assume all of it changed
+	NotifyCellsChanged(GetGridRect());
 }
 
 
-bool AGAGridActor::GridSpaceBoundsToRect2D(const FBox2D& Box, FIntRect &RectOut) const
+void AGAGridActor::RefreshCachedCellDataInRect(const FIntRect& Rect)
 {
-	float HalfScale = 0.5f * CellScale;
+	if (Data.Num() != GetCellCount())
+	{
+		// Data hasn't been built for the current dimensions yet. The accessors will fall back to reading Data directly.
+		NeighborMasks.Empty();
+		TraversableBits.Empty();
+		ClearanceMap.Empty();
+		return;
+	}
 
-	RectOut.Min.X = FMath::Max(int32((Box.Min.X + HalfScale) / CellScale), 0);
-	RectOut.Max.X = FMath::Min(int32((Box.Max.X - HalfScale) / CellScale), XCount - 1);	
-	RectOut.Min.Y = FMath::Max(int32((Box.Min.Y + HalfScale) / CellScale), 0);
-	RectOut.Max.Y = FMath::Min(int32((Box.Max.Y - HalfScale) / CellScale), YCount - 1);
+	FIntRect DirtyRect = Rect;
 
-	return (RectOut.Min.X <= RectOut.Max.X) && (RectOut.Min.Y <= RectOut.Max.Y);
-}
+	// Nothing to patch yet, so build the lot
+	if ((TraversableBits.Num() != (GetCellCount() + 63) / 64) || (NeighborMasks.Num() != GetCellCount()) || (ClearanceMap.Num() != GetCellCount()))
+	{
+		TraversableBits.Reset();
+		TraversableBits.SetNumZeroed((GetCellCount() + 63) / 64);
+		NeighborMasks.Reset();
+		NeighborMasks.SetNumZeroed(GetCellCount());
+		ClearanceMap.Reset();
+		ClearanceMap.SetNumZeroed(GetCellCount());
+
+		DirtyRect = GetGridRect();
+	}
+
+	if (!ClipRectToGrid(DirtyRect))
+	{
+		return;
+	}
 
+	// Traversability bitset
+	for (int32 Y = DirtyRect.Min.Y; Y <= DirtyRect.Max.Y; Y++)
+	{
+		for (int32 X = DirtyRect.Min.X; X <= DirtyRect.Max.X; X++)
+		{
+			int32 CellIndex = CellRefToIndex(FCellRef(X, Y));
+			uint64 Bit = uint64(1) << (CellIndex & 63);
 
-void AGAGridActor::GetNeighbors(const FCellRef& Cell, bool OnlyTraversable, TArray<FCellRef> &Neighbors) const
-{
-	for (int32 Y = Cell.Y -1; Y <= Cell.Y + 1; Y++)
+			if (EnumHasAllFlags(Data[CellIndex], ECellData::CellDataTraversable) && !IsCellDynamicBlocked(CellIndex))
+			{
+				TraversableBits[CellIndex >> 6] |= Bit;
+			}
+			else
+			{
+				TraversableBits[CellIndex >> 6] &= ~Bit;
+			}
+		}
+	}
+
+	// Neighbor masks
+	// Baking these once means GetNeighbors doesn't have to do eight bounds checks and eight data lookups per call
+	// A cell's mask depends on its neighbors, so the ring of cells around the dirty rect needs redoing too.
+	FIntRect MaskRect(DirtyRect.Min - FIntPoint(1, 1), DirtyRect.Max + FIntPoint(1, 1));
+	ClipRectToGrid(MaskRect);
+
+	for (int32 Y = MaskRect.Min.Y; Y <= MaskRect.Max.Y; Y++)
 	{
-		for (int32 X = Cell.X - 1; X <= Cell.X + 1; X++)
+		for (int32 X = MaskRect.Min.X; X <= MaskRect.Max.X; X++)
 		{
-			if ((X != 0) || (Y != 0))
+			uint8 Mask = 0;
+
+			for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
 			{
-				FCellRef NCell(X, Y);
-				if (IsValidCell(NCell))
+				FCellRef NCell(X + NeighborOffsets[NeighborIndex].X, Y + NeighborOffsets[NeighborIndex].Y);
+				if (IsCellTraversable(NCell))
 				{
-					if (!OnlyTraversable || EnumHasAllFlags(GetCellData(NCell), ECellData::CellDataTraversable))
-					{
-						Neighbors.Add(NCell);
-					}
+					Mask |= (1 << NeighborIndex);
 				}
 			}
+
+			NeighborMasks[CellRefToIndex(FCellRef(X, Y))] = Mask;
 		}
 	}
+
+	// Clearance is capped, so a change can't be felt any further away than that
+	int32 ClearanceReach = FMath::CeilToInt32(MaxClearanceCells) + 1;
+	FIntRect ClearanceRect(DirtyRect.Min - FIntPoint(ClearanceReach, ClearanceReach), DirtyRect.Max + FIntPoint(ClearanceReach, ClearanceReach));
+	ClipRectToGrid(ClearanceRect);
+
+	RefreshClearanceMap(ClearanceRect);
 }
 
 
-void AGAGridActor::TransformPointToNormalizedGridSpace(const FVector& WorldPosition, FVector2D& UniformGridSpacePosition) const
+void AGAGridActor::RefreshClearanceMap(const FIntRect& Window)
 {
-	// First, transform the point into grid-local space
-	// note, we drop the Z dimension at this point, by casting to a FVector2D
-	FTransform GridTransform = GetActorTransform();
-	FVector2D LocalPoint = FVector2D(GridTransform.InverseTransformPosition(WorldPosition));
+	// Two-pass chamfer distance transform (weights 1 and sqrt(2)) from every blocked cell.
+	// Cells off the edge of the grid count as blocked, since a trace leaving the grid is a hit.
+	// The first pass sweeps down and right, pulling distances from the up/left neighbors, and the second
+	// sweeps back up and left, pulling from the down/right neighbors. After both, each cell holds
+	// (approximately) the distance from its center to the nearest blocked cell center.
+	// Only the cells in Window are recomputed. The ones around it keep their values and act as the boundary.
 
-	LocalPoint += HalfExtents;		// Now LocalPoint is relative the to the (0, 0) corner of grid
-
-	UniformGridSpacePosition.Set(LocalPoint.X / CellScale, LocalPoint.Y / CellScale);
-}
+	const float Unreached = MaxClearanceCells + 1.0f;
 
+	for (int32 Y = Window.Min.Y; Y <= Window.Max.Y; Y++)
+	{
+		for (int32 X = Window.Min.X; X <= Window.Max.X; X++)
+		{
+			FCellRef Cell(X, Y);
+			ClearanceMap[CellRefToIndex(Cell)] = IsCellTraversable(Cell) ? Unreached : 0.0f;
+		}
+	}
 
-void AGAGridActor::TransformNormalizedGridSpaceToWorld(const FVector2D& UniformGridSpacePosition, FVector& WorldPosition) const
-{
-	FVector2D GridSpacePoint = UniformGridSpacePosition * CellScale;
+	auto Relax = [this, &Window](int32 X, int32 Y, int32 DX, int32 DY, float& Distance)
+	{
+		FCellRef NCell(X + DX, Y + DY);
+		float StepDistance = ((DX != 0) && (DY != 0)) ? UE_SQRT_2 : 1.0f;
+		float NDistance = 0.0f;
+		if (IsValidCell(NCell))
+		{
+			NDistance = ClearanceMap[CellRefToIndex(NCell)];
 
-	GridSpacePoint -= HalfExtents;
+			// Outside the window the values are already converted to edge distances (see below), so undo that
+			bool bInWindow = (NCell.X >= Window.Min.X) && (NCell.X <= Window.Max.X) && (NCell.Y >= Window.Min.Y) && (NCell.Y <= Window.Max.Y);
+			if (!bInWindow && (NDistance > 0.0f))
+			{
+				NDistance += 0.5f;
+			}
+		}
+		Distance = FMath::Min(Distance, NDistance + StepDistance);
+	};
 
-	// First, transform the point into grid-local space
-	// note, we drop the Z dimension at this point, by casting to a FVector2D
-	FTransform GridTransform = GetActorTransform();
+	for (int32 Y = Window.Min.Y; Y <= Window.Max.Y; Y++)
+	{
+		for (int32 X = Window.Min.X; X <= Window.Max.X; X++)
+		{
+			float& Distance = ClearanceMap[CellRefToIndex(FCellRef(X, Y))];
+			if (Distance > 0.0f)
+			{
+				Relax(X, Y, -1, -1, Distance);
+				Relax(X, Y, 0, -1, Distance);
+				Relax(X, Y, 1, -1, Distance);
+				Relax(X, Y, -1, 0, Distance);
+			}
+		}
+	}
 
-	FVector LocalPoint3D(GridSpacePoint, 0.0f);
+	for (int32 Y = Window.Max.Y; Y >= Window.Min.Y; Y--)
+	{
+		for (int32 X = Window.Max.X; X >= Window.Min.X; X--)
+		{
+			float& Distance = ClearanceMap[CellRefToIndex(FCellRef(X, Y))];
+			if (Distance > 0.0f)
+			{
+				Relax(X, Y, 1, 0, Distance);
+				Relax(X, Y, -1, 1, Distance);
+				Relax(X, Y, 0, 1, Distance);
+				Relax(X, Y, 1, 1, Distance);
+			}
+		}
+	}
 
-	WorldPosition = GridTransform.TransformPosition(LocalPoint3D);
+	// Convert center-to-center distance into distance from this cell's center to the edge of the blocked cell
+	for (int32 Y = Window.Min.Y; Y <= Window.Max.Y; Y++)
+	{
+		for (int32 X = Window.Min.X; X <= Window.Max.X; X++)
+		{
+			float& Distance = ClearanceMap[CellRefToIndex(FCellRef(X, Y))];
+			Distance = (Distance > 0.0f) ? FMath::Min(Distance - 0.5f, MaxClearanceCells) : 0.0f;
+		}
+	}
 }
 
 
-// Spatial Queries --------------------------------
+float AGAGridActor::GetCellClearance(const FCellRef& Cell) const
+{
+	if (!IsValidCell(Cell))
+	{
+		return 0.0f;
+	}
 
+	if (ClearanceMap.Num() == GetCellCount())
+	{
+		return ClearanceMap[CellRefToIndex(Cell)] * CellScale;
+	}
 
-bool AGAGridActor::TraceLine(const FVector& Start, const FVector& End, FVector& HitLocationOut) const
+	return IsCellTraversable(Cell) ? 0.5f * CellScale : 0.0f;
+}
+
+const FGASummedAreaTable& AGAGridActor::GetTraversableSumTable() const
 {
-	FCellRef StartCell = GetCellRef(Start);
-	FCellRef EndCell = GetCellRef(End);
+	check(IsInGameThread());
 
-	if (StartCell.IsValid())
+	if ((TraversableSumTableVersion != GridVersion) || !TraversableSumTable.IsValid() ||
+		(TraversableSumTable.Bounds != FGridBox(0, XCount - 1, 0, YCount - 1)))
 	{
-		FCellRef CurrentCell = StartCell;
-		FVector2D P0, P1, V;
-		TransformPointToNormalizedGridSpace(Start, P0);
-		TransformPointToNormalizedGridSpace(End, P1);
+		TraversableSumTable.BuildTraversability(this);
+		TraversableSumTableVersion = GridVersion;
+	}
+	return TraversableSumTable;
+}
 
-		V = P1 - P0;
-		float L = V.Size();
-		V.Normalize();
+// Return the cell the given point is inside of
+// If bClamp = true, then any point outside of the grid will be clamped to the bounds of the grid
+// Otherwise, if the point is outside the grid, it will return FCellRef::Invalid
 
-		if (L > UE_KINDA_SMALL_NUMBER)
-		{
-			int32 DX = (V.X >= 0) ? 1 : 0;
-			int32 DY = (V.Y >= 0) ? 1 : 0;
+FCellRef AGAGridActor::GetCellRef(const FVector& Point, bool bClamp) const
+{
+	// First, transform the point into normalized grid space
+	// note, we drop the Z dimension at this point
+	FVector2D GridPoint = GetGridAffine().WorldToGrid(Point);
 
-			while (true)
-			{
+	if (bClamp)
+	{
+		GridPoint.X = FMath::Clamp(GridPoint.X, 0.0, double(XCount));
+		GridPoint.Y = FMath::Clamp(GridPoint.Y, 0.0, double(YCount));
+	}
+	else if ((GridPoint.X < 0.0) || (GridPoint.X > XCount) || (GridPoint.Y < 0.0) || (GridPoint.Y > YCount))
+	{
+		return FCellRef::Invalid;
+	}
+
+	// Discretize by flooring
+	// Out of an abundance of caution we also clamp the result to a valid index, to avoid any floating-point issues
+
+	FCellRef Result(
+		FMath::Clamp(FMath::FloorToInt32(GridPoint.X), 0, XCount - 1),
+		FMath::Clamp(FMath::FloorToInt32(GridPoint.Y), 0, YCount - 1)
+	);
+	return Result;
+}
+
+FVector AGAGridActor::GetCellPosition(const FCellRef& CellRef) const
+{
+	// The center of the cell in normalized grid space
+	return GetGridAffine().GridToWorld(FVector2D(CellRef.X + 0.5f, CellRef.Y + 0.5f));
+}
+
+FVector2D AGAGridActor::GetCellGridSpacePosition(const FCellRef& CellRef) const
+{
+	float HalfScale = 0.5f * CellScale;
+
+	// Grab the center of the cell, then offset by -HalfExtents, so that it is relative to the center of the grid
+	FVector2D LocalResult;
+	LocalResult.X = CellRef.X * CellScale + HalfScale;
+	LocalResult.Y = CellRef.Y * CellScale + HalfScale;
+
+	return LocalResult;
+}
+
+
+
+ECellData AGAGridActor::GetCellData(const FCellRef &CellRef) const
+{
+	if (bChunkedStorage && (Data.Num() != GetCellCount()))
+	{
+		return GetChunkedCellData(CellRef);
+	}
+
+	int32 CellIndex = CellRefToIndex(CellRef);
+	return Data[CellIndex];
+}
+
+
+float AGAGridActor::GetCellTraversalCost(const FCellRef& CellRef) const
+{
+	if (IsValidCell(CellRef) && HasTraversalCosts())
+	{
+		return GetTraversalCostMultiplier(CellRefToIndex(CellRef));
+	}
+
+	return 1.0f;
+}
+
+
+uint8 AGAGridActor::GetCellCoverDirections(const FCellRef& CellRef) const
+{
+	if (IsValidCell(CellRef) && (CoverDirections.Num() == GetCellCount()))
+	{
+		return CoverDirections[CellRefToIndex(CellRef)];
+	}
+
+	return 0;
+}
+
+
+float AGAGridActor::GetCellHeight(const FCellRef& CellRef) const
+{
+	if (IsValidCell(CellRef) && (CellHeights.Num() == GetCellCount()))
+	{
+		FFloat16 Height;
+		Height.Encoded = CellHeights[CellRefToIndex(CellRef)];
+		return Height.GetFloat();
+	}
+
+	return 0.0f;
+}
+
+
+FVector AGAGridActor::GetCellFloorPosition(const FCellRef& CellRef) const
+{
+	// Same as transforming (cell center, height) by the actor transform, without building the transform every call
+	return GetGridAffine().GridToWorld(FVector2D(CellRef.X + 0.5f, CellRef.Y + 0.5f), GetCellHeight(CellRef));
+}
+
+
+bool AGAGridActor::GridSpaceBoundsToRect2D(const FBox2D& Box, FIntRect &RectOut) const
+{
+	float HalfScale = 0.5f * CellScale;
+
+	RectOut.Min.X = FMath::Max(int32((Box.Min.X + HalfScale) / CellScale), 0);
+	RectOut.Max.X = FMath::Min(int32((Box.Max.X - HalfScale) / CellScale), XCount - 1);	
+	RectOut.Min.Y = FMath::Max(int32((Box.Min.Y + HalfScale) / CellScale), 0);
+	RectOut.Max.Y = FMath::Min(int32((Box.Max.Y - HalfScale) / CellScale), YCount - 1);
+
+	return (RectOut.Min.X <= RectOut.Max.X) && (RectOut.Min.Y <= RectOut.Max.Y);
+}
+
+
+uint8 AGAGridActor::GetNeighborMask(const FCellRef& Cell, bool OnlyTraversable) const
+{
+	if (OnlyTraversable && (NeighborMasks.Num() == GetCellCount()) && IsValidCell(Cell))
+	{
+		return NeighborMasks[CellRefToIndex(Cell)];
+	}
+
+	// No baked mask (or we want all on-grid neighbors), so work it out the slow way
+	uint8 Mask = 0;
+
+	for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
+	{
+		FCellRef NCell = GetNeighborCell(Cell, NeighborIndex);
+		if (IsValidCell(NCell))
+		{
+			if (!OnlyTraversable || IsCellTraversable(NCell))
+			{
+				Mask |= (1 << NeighborIndex);
+			}
+		}
+	}
+
+	return Mask;
+}
+
+
+int32 AGAGridActor::GetNeighborIndexForDirection(const FVector2D& GridDirection)
+{
+	// Snap to the nearest of the eight compass directions
+	float Angle = FMath::Atan2(GridDirection.Y, GridDirection.X);
+	int32 Octant = FMath::RoundToInt32(Angle / (0.25f * UE_PI));
+	FIntPoint Offset(FMath::RoundToInt32(FMath::Cos(Octant * 0.25f * UE_PI)), FMath::RoundToInt32(FMath::Sin(Octant * 0.25f * UE_PI)));
+
+	for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
+	{
+		if (NeighborOffsets[NeighborIndex] == Offset)
+		{
+			return NeighborIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+
+void AGAGridActor::GetNeighbors(const FCellRef& Cell, bool OnlyTraversable, TArray<FCellRef> &Neighbors) const
+{
+	uint8 Mask = GetNeighborMask(Cell, OnlyTraversable);
+
+	for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
+	{
+		if (Mask & (1 << NeighborIndex))
+		{
+			Neighbors.Add(GetNeighborCell(Cell, NeighborIndex));
+		}
+	}
+}
+
+
+void AGAGridActor::GetNeighbors(const FCellRef& Cell, bool OnlyTraversable, FCellNeighbors& Neighbors) const
+{
+	uint8 Mask = GetNeighborMask(Cell, OnlyTraversable);
+
+	Neighbors.Reset();
+
+	for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
+	{
+		if (Mask & (1 << NeighborIndex))
+		{
+			Neighbors.Add(GetNeighborCell(Cell, NeighborIndex));
+		}
+	}
+}
+
+
+void AGAGridActor::TransformPointToNormalizedGridSpace(const FVector& WorldPosition, FVector2D& UniformGridSpacePosition) const
+{
+	// note, we drop the Z dimension at this point
+	UniformGridSpacePosition = GetGridAffine().WorldToGrid(WorldPosition);
+}
+
+
+void AGAGridActor::TransformNormalizedGridSpaceToWorld(const FVector2D& UniformGridSpacePosition, FVector& WorldPosition) const
+{
+	WorldPosition = GetGridAffine().GridToWorld(UniformGridSpacePosition);
+}
+
+
+void AGAGridActor::GetCellRefs(TConstArrayView<FVector> Points, TArrayView<FCellRef> CellsOut, bool bClamp) const
+{
+	check(Points.Num() == CellsOut.Num());
+
+	const FGAGridAffine& Affine = GetGridAffine();
+	const int32 Count = Points.Num();
+
+	// The origin subtraction is done in double precision per point, so large world coordinates don't lose
+	// precision. Everything after that is float SIMD, four points at a time.
+	const VectorRegister4Float RowXX = VectorSetFloat1(float(Affine.WorldToGridX.X));
+	const VectorRegister4Float RowXY = VectorSetFloat1(float(Affine.WorldToGridX.Y));
+	const VectorRegister4Float RowXZ = VectorSetFloat1(float(Affine.WorldToGridX.Z));
+	const VectorRegister4Float RowYX = VectorSetFloat1(float(Affine.WorldToGridY.X));
+	const VectorRegister4Float RowYY = VectorSetFloat1(float(Affine.WorldToGridY.Y));
+	const VectorRegister4Float RowYZ = VectorSetFloat1(float(Affine.WorldToGridY.Z));
+	const VectorRegister4Float GridMaxX = VectorSetFloat1(float(XCount));
+	const VectorRegister4Float GridMaxY = VectorSetFloat1(float(YCount));
+	const VectorRegister4Float CellMaxX = VectorSetFloat1(float(XCount - 1));
+	const VectorRegister4Float CellMaxY = VectorSetFloat1(float(YCount - 1));
+	const VectorRegister4Float Zero = VectorZeroFloat();
+
+	int32 Index = 0;
+	for (; Index + 4 <= Count; Index += 4)
+	{
+		FVector D0 = Points[Index] - Affine.GridOrigin;
+		FVector D1 = Points[Index + 1] - Affine.GridOrigin;
+		FVector D2 = Points[Index + 2] - Affine.GridOrigin;
+		FVector D3 = Points[Index + 3] - Affine.GridOrigin;
+
+		VectorRegister4Float DX = MakeVectorRegisterFloat(float(D0.X), float(D1.X), float(D2.X), float(D3.X));
+		VectorRegister4Float DY = MakeVectorRegisterFloat(float(D0.Y), float(D1.Y), float(D2.Y), float(D3.Y));
+		VectorRegister4Float DZ = MakeVectorRegisterFloat(float(D0.Z), float(D1.Z), float(D2.Z), float(D3.Z));
+
+		VectorRegister4Float GX = VectorMultiplyAdd(DZ, RowXZ, VectorMultiplyAdd(DY, RowXY, VectorMultiply(DX, RowXX)));
+		VectorRegister4Float GY = VectorMultiplyAdd(DZ, RowYZ, VectorMultiplyAdd(DY, RowYY, VectorMultiply(DX, RowYX)));
+
+		// Lanes that fall outside of the grid (only matters if we're not clamping)
+		int32 InsideMask = 0xF;
+		if (!bClamp)
+		{
+			VectorRegister4Float Inside = VectorBitwiseAnd(
+				VectorBitwiseAnd(VectorCompareGE(GX, Zero), VectorCompareLE(GX, GridMaxX)),
+				VectorBitwiseAnd(VectorCompareGE(GY, Zero), VectorCompareLE(GY, GridMaxY)));
+			InsideMask = VectorMaskBits(Inside);
+		}
+
+		// Floor and clamp to a valid cell, then truncate to int
+		GX = VectorMin(VectorMax(VectorFloor(GX), Zero), CellMaxX);
+		GY = VectorMin(VectorMax(VectorFloor(GY), Zero), CellMaxY);
+
+		alignas(16) int32 CellX[4];
+		alignas(16) int32 CellY[4];
+		VectorIntStoreAligned(VectorFloatToInt(GX), CellX);
+		VectorIntStoreAligned(VectorFloatToInt(GY), CellY);
+
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			CellsOut[Index + Lane] = (InsideMask & (1 << Lane)) ? FCellRef(CellX[Lane], CellY[Lane]) : FCellRef::Invalid;
+		}
+	}
+
+	// Leftovers
+	for (; Index < Count; Index++)
+	{
+		CellsOut[Index] = GetCellRef(Points[Index], bClamp);
+	}
+}
+
+
+void AGAGridActor::GetCellPositions(TConstArrayView<FCellRef> Cells, TArrayView<FVector> PositionsOut) const
+{
+	check(Cells.Num() == PositionsOut.Num());
+
+	const FGAGridAffine& Affine = GetGridAffine();
+	const int32 Count = Cells.Num();
+
+	// Offsets from GridOrigin are computed in float SIMD, then added to the double-precision origin per point
+	const VectorRegister4Float AxisXX = VectorSetFloat1(float(Affine.GridAxisX.X));
+	const VectorRegister4Float AxisXY = VectorSetFloat1(float(Affine.GridAxisX.Y));
+	const VectorRegister4Float AxisXZ = VectorSetFloat1(float(Affine.GridAxisX.Z));
+	const VectorRegister4Float AxisYX = VectorSetFloat1(float(Affine.GridAxisY.X));
+	const VectorRegister4Float AxisYY = VectorSetFloat1(float(Affine.GridAxisY.Y));
+	const VectorRegister4Float AxisYZ = VectorSetFloat1(float(Affine.GridAxisY.Z));
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+
+	int32 Index = 0;
+	for (; Index + 4 <= Count; Index += 4)
+	{
+		// Cell centers in normalized grid space
+		VectorRegister4Float GX = VectorAdd(MakeVectorRegisterFloat(float(Cells[Index].X), float(Cells[Index + 1].X), float(Cells[Index + 2].X), float(Cells[Index + 3].X)), Half);
+		VectorRegister4Float GY = VectorAdd(MakeVectorRegisterFloat(float(Cells[Index].Y), float(Cells[Index + 1].Y), float(Cells[Index + 2].Y), float(Cells[Index + 3].Y)), Half);
+
+		alignas(16) float WX[4];
+		alignas(16) float WY[4];
+		alignas(16) float WZ[4];
+		VectorStoreAligned(VectorMultiplyAdd(GY, AxisYX, VectorMultiply(GX, AxisXX)), WX);
+		VectorStoreAligned(VectorMultiplyAdd(GY, AxisYY, VectorMultiply(GX, AxisXY)), WY);
+		VectorStoreAligned(VectorMultiplyAdd(GY, AxisYZ, VectorMultiply(GX, AxisXZ)), WZ);
+
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			PositionsOut[Index + Lane] = Affine.GridOrigin + FVector(WX[Lane], WY[Lane], WZ[Lane]);
+		}
+	}
+
+	// Leftovers
+	for (; Index < Count; Index++)
+	{
+		PositionsOut[Index] = GetCellPosition(Cells[Index]);
+	}
+}
+
+
+// Spatial Queries --------------------------------
+
+
+// The DDA behind TraceLine and TraceLineWithRadius
+// IsCellClear(Cell, Offset) decides whether the ray is allowed to pass through a given cell. Offset is the furthest
+// the ray gets from the cell's center (in cells) while it's inside the cell. The start cell is only tested if
+// bTestStartCell is set.
+template<typename CellTestType>
+bool AGAGridActor::TraceLineInternal(const FVector& Start, const FVector& End, FVector& HitLocationOut, bool bTestStartCell, CellTestType IsCellClear) const
+{
+	FCellRef StartCell = GetCellRef(Start);
+
+	if (StartCell.IsValid())
+	{
+		FCellRef CurrentCell = StartCell;
+		FVector2D P0, P1, V;
+		TransformPointToNormalizedGridSpace(Start, P0);
+		TransformPointToNormalizedGridSpace(End, P1);
+
+		V = P1 - P0;
+		float L = V.Size();
+		V.Normalize();
+
+		if (L > UE_KINDA_SMALL_NUMBER)
+		{
+			int32 DX = (V.X >= 0) ? 1 : 0;
+			int32 DY = (V.Y >= 0) ? 1 : 0;
+
+			// Where along the ray we entered CurrentCell
+			float TEnter = 0.0f;
+			bool bTestCell = bTestStartCell;
+
+			while (true)
+			{
 				float XPlaneToBreak = float(CurrentCell.X + DX);
 				float YPlaneToBreak = float(CurrentCell.Y + DY);
 
@@ -274,75 +995,635 @@ bool AGAGridActor::TraceLine(const FVector& Start, const FVector& End, FVector&
 				// P0x + VxT = Xp		==>		T = (Xp - P0x) / Vx
 				// P0y + VyT = Yp		==>		T = (Yp - P0y) / Vy
 
-				if (FMath::Abs(V.X) > UE_KINDA_SMALL_NUMBER)
-				{
-					TX = (XPlaneToBreak - P0.X) / V.X;
-				}
-				else
-				{
-					TX = FLT_MAX;
-				}
+				if (FMath::Abs(V.X) > UE_KINDA_SMALL_NUMBER)
+				{
+					TX = (XPlaneToBreak - P0.X) / V.X;
+				}
+				else
+				{
+					TX = FLT_MAX;
+				}
+
+				if (FMath::Abs(V.Y) > UE_KINDA_SMALL_NUMBER)
+				{
+					TY = (YPlaneToBreak - P0.Y) / V.Y;
+				}
+				else
+				{
+					TY = FLT_MAX;
+				}
+
+				float T = FMath::Min(TX, TY);
+
+				if (bTestCell)
+				{
+					// The part of the ray inside the cell is a straight segment, so it's furthest from the center
+					// at one of its ends
+					const FVector2D Center(CurrentCell.X + 0.5, CurrentCell.Y + 0.5);
+					const float Offset = FMath::Max(FVector2D::Distance(P0 + V * TEnter, Center), FVector2D::Distance(P0 + V * FMath::Min(T, L), Center));
+					if (!IsCellClear(CurrentCell, Offset))
+					{
+						// nope we hit
+						FVector2D HitLocationLocal = P0 + V * TEnter;
+						TransformNormalizedGridSpaceToWorld(HitLocationLocal, HitLocationOut);
+						return true;
+					}
+				}
+				bTestCell = true;
+
+				if (T >= L)
+				{
+					// We got to the destination!
+					return false;
+				}
+
+				if (FMath::Abs(TX - TY) < UE_SMALL_NUMBER)
+				{
+					// advance both
+					CurrentCell.X = (V.X > 0) ? CurrentCell.X + 1 : CurrentCell.X - 1;
+					CurrentCell.Y = (V.Y > 0) ? CurrentCell.Y + 1 : CurrentCell.Y - 1;
+				}
+				else if (TX <= TY)
+				{
+					// advance X
+					CurrentCell.X = (V.X > 0) ? CurrentCell.X + 1 : CurrentCell.X - 1;
+				}
+				else
+				{
+					// advance Y
+					CurrentCell.Y = (V.Y > 0) ? CurrentCell.Y + 1 : CurrentCell.Y - 1;
+				}
+				TEnter = T;
+			}
+		}
+		else
+		{
+			// Close enough, there's no hit
+			return false;
+		}
+	}
+	else
+	{
+		HitLocationOut = Start;
+		return true;
+	}
+}
+
+
+bool AGAGridActor::TraceLine(const FVector& Start, const FVector& End, FVector& HitLocationOut) const
+{
+	return TraceLineInternal(Start, End, HitLocationOut, false, [this](const FCellRef& Cell, float Offset)
+	{
+		return IsCellTraversable(Cell);
+	});
+}
+
+
+bool AGAGridActor::TraceLineWithRadius(const FVector& Start, const FVector& End, float Radius, FVector& HitLocationOut) const
+{
+	// Clearance is baked in cells, so compare in cell units
+	// Note the clearance map tops out at MaxClearanceCells, so bigger radii will always hit
+	float RadiusCells = Radius / CellScale;
+
+	// Clearance is measured from cell centers, but the circle's center is wherever the ray is, which can be up to
+	// half a diagonal away. So each cell needs the radius plus however far off center the ray passes. The start cell
+	// counts too: the circle is already there at the start.
+	if (ClearanceMap.Num() != GetCellCount())
+	{
+		// No clearance map (e.g. we're using chunked storage), so search around each cell instead
+		return TraceLineInternal(Start, End, HitLocationOut, true, [this, RadiusCells](const FCellRef& Cell, float Offset)
+		{
+			return HasClearance(Cell, RadiusCells + Offset);
+		});
+	}
+
+	return TraceLineInternal(Start, End, HitLocationOut, true, [this, RadiusCells](const FCellRef& Cell, float Offset)
+	{
+		return IsValidCell(Cell) && (ClearanceMap[CellRefToIndex(Cell)] >= RadiusCells + Offset);
+	});
+}
+
+
+bool AGAGridActor::HasClearance(const FCellRef& Cell, float RadiusCells) const
+{
+	// Same definition as the clearance map: fail if any blocked cell's center is closer than RadiusCells + 0.5
+	float Reach = RadiusCells + 0.5f;
+	int32 Extent = FMath::CeilToInt32(Reach);
+
+	for (int32 DY = -Extent; DY <= Extent; DY++)
+	{
+		for (int32 DX = -Extent; DX <= Extent; DX++)
+		{
+			if ((float(DX * DX + DY * DY) < Reach * Reach) && !IsCellTraversable(FCellRef(Cell.X + DX, Cell.Y + DY)))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void AGAGridActor::TraceLines(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<bool> HitsOut, TArrayView<FVector> HitLocationsOut) const
+{
+	check(Starts.Num() == Ends.Num());
+	check(Starts.Num() == HitsOut.Num());
+	check(Starts.Num() == HitLocationsOut.Num());
+
+	// This is the same DDA as TraceLine, but in incremental form: rather than re-deriving the distance to
+	// the next X and Y cell boundaries every step, each ray keeps TMaxX/TMaxY (distance along the ray to the
+	// next boundary) and bumps them by TDeltaX/TDeltaY (distance between boundaries) as it steps.
+	// That turns the plane selection into a couple of compares and selects, so four rays can march in lockstep.
+	// Cell coordinates are kept as floats, which is exact for any grid we'd realistically use.
+
+	const int32 RayCount = Starts.Num();
+	const VectorRegister4Float SmallNumber = VectorSetFloat1(UE_SMALL_NUMBER);
+
+	for (int32 BaseIndex = 0; BaseIndex < RayCount; BaseIndex += 4)
+	{
+		alignas(16) float P0X[4], P0Y[4], VX[4], VY[4], Length[4];
+		alignas(16) float CellX[4], CellY[4], StepX[4], StepY[4];
+		alignas(16) float TMaxX[4], TMaxY[4], TDeltaX[4], TDeltaY[4];
+		uint32 ActiveLanes = 0;
+
+		// Set up each lane. Lanes past the end of the batch, or whose rays are trivially resolved, start inactive.
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			P0X[Lane] = P0Y[Lane] = VX[Lane] = VY[Lane] = Length[Lane] = 0.0f;
+			CellX[Lane] = CellY[Lane] = StepX[Lane] = StepY[Lane] = 0.0f;
+			TMaxX[Lane] = TMaxY[Lane] = FLT_MAX;
+			TDeltaX[Lane] = TDeltaY[Lane] = 0.0f;
+
+			int32 RayIndex = BaseIndex + Lane;
+			if (RayIndex >= RayCount)
+			{
+				continue;
+			}
+
+			HitsOut[RayIndex] = false;
+
+			FCellRef StartCell = GetCellRef(Starts[RayIndex]);
+			if (!StartCell.IsValid())
+			{
+				HitsOut[RayIndex] = true;
+				HitLocationsOut[RayIndex] = Starts[RayIndex];
+				continue;
+			}
+
+			FVector2D P0, P1;
+			TransformPointToNormalizedGridSpace(Starts[RayIndex], P0);
+			TransformPointToNormalizedGridSpace(Ends[RayIndex], P1);
+
+			FVector2D V = P1 - P0;
+			float L = V.Size();
+			if (L <= UE_KINDA_SMALL_NUMBER)
+			{
+				// Close enough, there's no hit
+				continue;
+			}
+			V /= L;
+
+			P0X[Lane] = P0.X;
+			P0Y[Lane] = P0.Y;
+			VX[Lane] = V.X;
+			VY[Lane] = V.Y;
+			Length[Lane] = L;
+			CellX[Lane] = float(StartCell.X);
+			CellY[Lane] = float(StartCell.Y);
+			StepX[Lane] = (V.X > 0) ? 1.0f : -1.0f;
+			StepY[Lane] = (V.Y > 0) ? 1.0f : -1.0f;
+
+			if (FMath::Abs(V.X) > UE_KINDA_SMALL_NUMBER)
+			{
+				float XPlaneToBreak = float(StartCell.X + ((V.X >= 0) ? 1 : 0));
+				TMaxX[Lane] = (XPlaneToBreak - P0.X) / V.X;
+				TDeltaX[Lane] = 1.0f / FMath::Abs(V.X);
+			}
+
+			if (FMath::Abs(V.Y) > UE_KINDA_SMALL_NUMBER)
+			{
+				float YPlaneToBreak = float(StartCell.Y + ((V.Y >= 0) ? 1 : 0));
+				TMaxY[Lane] = (YPlaneToBreak - P0.Y) / V.Y;
+				TDeltaY[Lane] = 1.0f / FMath::Abs(V.Y);
+			}
+
+			ActiveLanes |= (1 << Lane);
+		}
+
+		VectorRegister4Float VCellX = VectorLoadAligned(CellX);
+		VectorRegister4Float VCellY = VectorLoadAligned(CellY);
+		VectorRegister4Float VTMaxX = VectorLoadAligned(TMaxX);
+		VectorRegister4Float VTMaxY = VectorLoadAligned(TMaxY);
+		const VectorRegister4Float VTDeltaX = VectorLoadAligned(TDeltaX);
+		const VectorRegister4Float VTDeltaY = VectorLoadAligned(TDeltaY);
+		const VectorRegister4Float VStepX = VectorLoadAligned(StepX);
+		const VectorRegister4Float VStepY = VectorLoadAligned(StepY);
+		const VectorRegister4Float VLength = VectorLoadAligned(Length);
+
+		while (ActiveLanes != 0)
+		{
+			VectorRegister4Float Active = MakeVectorRegisterFloatMask(
+				(ActiveLanes & 1) ? 0xFFFFFFFF : 0, (ActiveLanes & 2) ? 0xFFFFFFFF : 0,
+				(ActiveLanes & 4) ? 0xFFFFFFFF : 0, (ActiveLanes & 8) ? 0xFFFFFFFF : 0);
+
+			// Distance to the next boundary. Lanes that get there before the next boundary are done, with no hit.
+			VectorRegister4Float T = VectorMin(VTMaxX, VTMaxY);
+			Active = VectorBitwiseAnd(Active, VectorCompareLT(T, VLength));
+
+			// Advance X, Y or both (when the ray passes right through a corner)
+			VectorRegister4Float Tie = VectorCompareLT(VectorAbs(VectorSubtract(VTMaxX, VTMaxY)), SmallNumber);
+			VectorRegister4Float AdvanceX = VectorBitwiseAnd(Active, VectorBitwiseOr(Tie, VectorCompareLE(VTMaxX, VTMaxY)));
+			VectorRegister4Float AdvanceY = VectorBitwiseAnd(Active, VectorBitwiseOr(Tie, VectorCompareLT(VTMaxY, VTMaxX)));
+
+			VCellX = VectorAdd(VCellX, VectorBitwiseAnd(AdvanceX, VStepX));
+			VCellY = VectorAdd(VCellY, VectorBitwiseAnd(AdvanceY, VStepY));
+			VTMaxX = VectorAdd(VTMaxX, VectorBitwiseAnd(AdvanceX, VTDeltaX));
+			VTMaxY = VectorAdd(VTMaxY, VectorBitwiseAnd(AdvanceY, VTDeltaY));
+
+			ActiveLanes = uint32(VectorMaskBits(Active));
+
+			// Bitset lookups are a gather, which we do per lane
+			alignas(16) float StepT[4];
+			VectorStoreAligned(VCellX, CellX);
+			VectorStoreAligned(VCellY, CellY);
+			VectorStoreAligned(T, StepT);
+
+			for (int32 Lane = 0; Lane < 4; Lane++)
+			{
+				if ((ActiveLanes & (1 << Lane)) && !IsCellTraversable(FCellRef(int32(CellX[Lane]), int32(CellY[Lane]))))
+				{
+					// nope we hit
+					int32 RayIndex = BaseIndex + Lane;
+					FVector2D HitLocationLocal(P0X[Lane] + VX[Lane] * StepT[Lane], P0Y[Lane] + VY[Lane] * StepT[Lane]);
+					TransformNormalizedGridSpaceToWorld(HitLocationLocal, HitLocationsOut[RayIndex]);
+					HitsOut[RayIndex] = true;
+					ActiveLanes &= ~(1 << Lane);
+				}
+			}
+		}
+	}
+}
+
+
+
+
+// Dynamic obstacles --------------------------------
+
+void AGAGridActor::RegisterDynamicObstacle(UGADynamicObstacleComponent* Obstacle)
+{
+	for (const FDynamicObstacleEntry& Entry : DynamicObstacles)
+	{
+		if (Entry.Obstacle.Get() == Obstacle)
+		{
+			return;
+		}
+	}
+
+	// Nothing is stamped until the next update
+	FDynamicObstacleEntry& Entry = DynamicObstacles.AddDefaulted_GetRef();
+	Entry.Obstacle = Obstacle;
+
+	SetActorTickEnabled(true);
+}
+
+
+void AGAGridActor::UnregisterDynamicObstacle(UGADynamicObstacleComponent* Obstacle)
+{
+	for (int32 EntryIndex = 0; EntryIndex < DynamicObstacles.Num(); EntryIndex++)
+	{
+		if (DynamicObstacles[EntryIndex].Obstacle.Get() == Obstacle)
+		{
+			bool bWasStamped = DynamicObstacles[EntryIndex].bStamped;
+			FIntRect StampedRect = DynamicObstacles[EntryIndex].StampedRect;
+
+			DynamicObstacles.RemoveAtSwap(EntryIndex);
+
+			if (bWasStamped)
+			{
+				RestampDynamicObstacles(StampedRect);
+				NotifyCellsChanged(StampedRect);
+			}
+			break;
+		}
+	}
+
+	if (DynamicObstacles.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+
+// True if A and B contain the same cell centers in Rect
+static bool CoversSameCells(const FGAObstacleFootprint& A, const FGAObstacleFootprint& B, const FIntRect& Rect)
+{
+	for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+	{
+		for (int32 X = Rect.Min.X; X <= Rect.Max.X; X++)
+		{
+			const FVector2D CellCenter(X + 0.5f, Y + 0.5f);
+			if (A.Contains(CellCenter) != B.Contains(CellCenter))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+void AGAGridActor::UpdateDynamicObstacles()
+{
+	TArray<FIntRect, TInlineAllocator<16>> DirtyRects;
+
+	// If the grid was resized, the old stamps mean nothing. Start over.
+	int32 WordCount = (GetCellCount() + 63) / 64;
+	if (DynamicBlockedBits.Num() != WordCount)
+	{
+		DynamicBlockedBits.Reset();
+		DynamicBlockedBits.SetNumZeroed(WordCount);
+
+		for (FDynamicObstacleEntry& Entry : DynamicObstacles)
+		{
+			Entry.bStamped = false;
+		}
+	}
+
+	for (int32 EntryIndex = DynamicObstacles.Num() - 1; EntryIndex >= 0; EntryIndex--)
+	{
+		FDynamicObstacleEntry& Entry = DynamicObstacles[EntryIndex];
+		UGADynamicObstacleComponent* Obstacle = Entry.Obstacle.Get();
+
+		if (!Obstacle)
+		{
+			// Went away without unregistering. Take back whatever it had stamped.
+			if (Entry.bStamped)
+			{
+				DirtyRects.Add(Entry.StampedRect);
+			}
+			DynamicObstacles.RemoveAtSwap(EntryIndex);
+			continue;
+		}
+
+		FGAObstacleFootprint Footprint;
+		FIntRect NewRect;
+		bool bHasFootprint = false;
+
+		if (Obstacle->bBlocking)
+		{
+			Obstacle->GetFootprint(this, Footprint);
+
+			// Only cells whose centers are inside the footprint count, so round the bounds inwards
+			NewRect = FIntRect(
+				FMath::CeilToInt32(Footprint.Bounds.Min.X - 0.5f), FMath::CeilToInt32(Footprint.Bounds.Min.Y - 0.5f),
+				FMath::FloorToInt32(Footprint.Bounds.Max.X - 0.5f), FMath::FloorToInt32(Footprint.Bounds.Max.Y - 0.5f));
+			bHasFootprint = ClipRectToGrid(NewRect);
+		}
+
+		// Nothing moved, nothing to do. This is the common case.
+		if ((bHasFootprint == Entry.bStamped) && (!bHasFootprint || (Footprint == Entry.Footprint)))
+		{
+			continue;
+		}
+
+		// Moved, but not far enough to cover or uncover any cell centers. The cells are what everyone else sees (and
+		// what bumps GridVersion), so there's nothing to tell them. Keep the new footprint, as it stamps the same cells.
+		if (bHasFootprint && Entry.bStamped && (NewRect == Entry.StampedRect) && CoversSameCells(Footprint, Entry.Footprint, NewRect))
+		{
+			Entry.Footprint = Footprint;
+			continue;
+		}
+
+		bool bOverlapsOld = Entry.bStamped && bHasFootprint &&
+			(NewRect.Min.X <= Entry.StampedRect.Max.X) && (Entry.StampedRect.Min.X <= NewRect.Max.X) &&
+			(NewRect.Min.Y <= Entry.StampedRect.Max.Y) && (Entry.StampedRect.Min.Y <= NewRect.Max.Y);
+
+		if (bOverlapsOld)
+		{
+			// Small moves overlap the old footprint, so do them as one rectangle
+			DirtyRects.Add(FIntRect(
+				FMath::Min(NewRect.Min.X, Entry.StampedRect.Min.X), FMath::Min(NewRect.Min.Y, Entry.StampedRect.Min.Y),
+				FMath::Max(NewRect.Max.X, Entry.StampedRect.Max.X), FMath::Max(NewRect.Max.Y, Entry.StampedRect.Max.Y)));
+		}
+		else
+		{
+			if (Entry.bStamped)
+			{
+				DirtyRects.Add(Entry.StampedRect);
+			}
+			if (bHasFootprint)
+			{
+				DirtyRects.Add(NewRect);
+			}
+		}
+
+		Entry.Footprint = Footprint;
+		Entry.StampedRect = NewRect;
+		Entry.bStamped = bHasFootprint;
+	}
+
+	for (const FIntRect& DirtyRect : DirtyRects)
+	{
+		RestampDynamicObstacles(DirtyRect);
+		NotifyCellsChanged(DirtyRect);
+	}
+
+	// As UnregisterDynamicObstacle does, for obstacles that never called it
+	if (DynamicObstacles.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+
+void AGAGridActor::RestampDynamicObstacles(const FIntRect& Rect)
+{
+	if (DynamicBlockedBits.Num() != (GetCellCount() + 63) / 64)
+	{
+		return;
+	}
+
+	for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+	{
+		for (int32 X = Rect.Min.X; X <= Rect.Max.X; X++)
+		{
+			int32 CellIndex = CellRefToIndex(FCellRef(X, Y));
+			DynamicBlockedBits[CellIndex >> 6] &= ~(uint64(1) << (CellIndex & 63));
+		}
+	}
+
+	// Obstacles can overlap, so everyone touching the rectangle gets redrawn, not just the one that moved
+	for (const FDynamicObstacleEntry& Entry : DynamicObstacles)
+	{
+		if (!Entry.bStamped)
+		{
+			continue;
+		}
+
+		FIntRect Overlap(
+			FMath::Max(Rect.Min.X, Entry.StampedRect.Min.X), FMath::Max(Rect.Min.Y, Entry.StampedRect.Min.Y),
+			FMath::Min(Rect.Max.X, Entry.StampedRect.Max.X), FMath::Min(Rect.Max.Y, Entry.StampedRect.Max.Y));
+
+		for (int32 Y = Overlap.Min.Y; Y <= Overlap.Max.Y; Y++)
+		{
+			for (int32 X = Overlap.Min.X; X <= Overlap.Max.X; X++)
+			{
+				if (Entry.Footprint.Contains(FVector2D(X + 0.5f, Y + 0.5f)))
+				{
+					int32 CellIndex = CellRefToIndex(FCellRef(X, Y));
+					DynamicBlockedBits[CellIndex >> 6] |= (uint64(1) << (CellIndex & 63));
+				}
+			}
+		}
+	}
+}
+
+
+// Chunked storage --------------------------------
+
+bool AGAGridActor::BuildChunksFromData()
+{
+	if (!bChunkedStorage || (Data.Num() != GetCellCount()))
+	{
+		return false;
+	}
+
+	Chunks.Reset();
+	Chunks.SetNum(ChunkXCount * ChunkYCount);
+
+	for (int32 ChunkY = 0; ChunkY < ChunkYCount; ChunkY++)
+	{
+		for (int32 ChunkX = 0; ChunkX < ChunkXCount; ChunkX++)
+		{
+			FGAGridChunk& Chunk = Chunks[ChunkY * ChunkXCount + ChunkX];
+			Chunk.State = EGAGridChunkState::Dense;
+			Chunk.Cells.SetNumZeroed(FGAGridChunk::Size * FGAGridChunk::Size);
+
+			// Note: cells past the edge of the grid stay CellDataNone
+			int32 MinX = ChunkX << FGAGridChunk::SizeShift;
+			int32 MinY = ChunkY << FGAGridChunk::SizeShift;
+			int32 MaxX = FMath::Min(MinX + FGAGridChunk::Size, XCount);
+			int32 MaxY = FMath::Min(MinY + FGAGridChunk::Size, YCount);
+
+			for (int32 Y = MinY; Y < MaxY; Y++)
+			{
+				for (int32 X = MinX; X < MaxX; X++)
+				{
+					Chunk.Cells[((Y - MinY) << FGAGridChunk::SizeShift) + (X - MinX)] = Data[CellRefToIndex(FCellRef(X, Y))];
+				}
+			}
+
+			Chunk.Compact();
+		}
+	}
+
+	// The chunks are the data now. The cells themselves haven't changed, so there's nothing to notify.
+	Data.Empty();
+	TraversalCosts.Empty();
+	CoverDirections.Empty();
+	CellHeights.Empty();
+	RefreshCachedCellDataInRect(GetGridRect());
+
+	return true;
+}
+
+
+bool AGAGridActor::LoadChunk(const FIntPoint& ChunkCoord, const FGAGridChunk& Chunk)
+{
+	if (!bChunkedStorage || !IsValidChunk(ChunkCoord) || (Chunks.Num() != ChunkXCount * ChunkYCount))
+	{
+		return false;
+	}
+
+	Chunks[ChunkCoord.Y * ChunkXCount + ChunkCoord.X] = Chunk;
+	NotifyCellsChanged(GetChunkRect(ChunkCoord));
+	return true;
+}
+
+
+bool AGAGridActor::UnloadChunk(const FIntPoint& ChunkCoord)
+{
+	if (!bChunkedStorage || !IsValidChunk(ChunkCoord) || (Chunks.Num() != ChunkXCount * ChunkYCount))
+	{
+		return false;
+	}
+
+	Chunks[ChunkCoord.Y * ChunkXCount + ChunkCoord.X] = FGAGridChunk();
+	NotifyCellsChanged(GetChunkRect(ChunkCoord));
+	return true;
+}
+
+
+FVector AGAGridActor::GetChunkPosition(const FIntPoint& ChunkCoord) const
+{
+	FVector2D ChunkCenter(
+		(float(ChunkCoord.X) + 0.5f) * FGAGridChunk::Size,
+		(float(ChunkCoord.Y) + 0.5f) * FGAGridChunk::Size);
+
+	return GetGridAffine().GridToWorld(ChunkCenter);
+}
+
+
+#if WITH_EDITOR
+void AGAGridActor::CreateChunkActors()
+{
+	UWorld* World = GetWorld();
+	if (!World || !bChunkedStorage)
+	{
+		return;
+	}
+
+	Modify();
 
-				if (FMath::Abs(V.Y) > UE_KINDA_SMALL_NUMBER)
-				{
-					TY = (YPlaneToBreak - P0.Y) / V.Y;
-				}
-				else
-				{
-					TY = FLT_MAX;
-				}
+	// Make sure we have chunks to hand out
+	if (Data.Num() == GetCellCount())
+	{
+		BuildChunksFromData();
+	}
 
-				float T = FMath::Min(TX, TY);
-				if (T >= L)
+	// Clear out any old chunk actors, taking their data back first
+	for (TActorIterator<AGAGridChunkActor> It(World); It; ++It)
+	{
+		AGAGridChunkActor* ChunkActor = *It;
+		if (ChunkActor->GridActor.Get() == this)
+		{
+			if (IsValidChunk(ChunkActor->ChunkCoord))
+			{
+				FGAGridChunk& Chunk = Chunks[ChunkActor->ChunkCoord.Y * ChunkXCount + ChunkActor->ChunkCoord.X];
+				if (Chunk.State == EGAGridChunkState::Unloaded)
 				{
-					// We got to the destination!
-					return false;
+					Chunk = ChunkActor->Chunk;
 				}
+			}
+			World->EditorDestroyActor(ChunkActor, true);
+		}
+	}
 
-				if (FMath::Abs(TX - TY) < UE_SMALL_NUMBER)
-				{
-					// advance both
-					CurrentCell.X = (V.X > 0) ? CurrentCell.X + 1 : CurrentCell.X - 1;
-					CurrentCell.Y = (V.Y > 0) ? CurrentCell.Y + 1 : CurrentCell.Y - 1;
-				}
-				else if (TX <= TY)
-				{
-					// advance X
-					CurrentCell.X = (V.X > 0) ? CurrentCell.X + 1 : CurrentCell.X - 1;
-				}
-				else
+	// Uniform chunks stay here (they're tiny). Dense ones each get an actor.
+	for (int32 ChunkY = 0; ChunkY < ChunkYCount; ChunkY++)
+	{
+		for (int32 ChunkX = 0; ChunkX < ChunkXCount; ChunkX++)
+		{
+			FGAGridChunk& Chunk = Chunks[ChunkY * ChunkXCount + ChunkX];
+			if (Chunk.State == EGAGridChunkState::Dense)
+			{
+				FIntPoint ChunkCoord(ChunkX, ChunkY);
+				AGAGridChunkActor* ChunkActor = World->SpawnActor<AGAGridChunkActor>(GetChunkPosition(ChunkCoord), GetActorRotation());
+				if (ChunkActor)
 				{
-					// advance Y
-					CurrentCell.Y = (V.Y > 0) ? CurrentCell.Y + 1 : CurrentCell.Y - 1;
-				}
+					ChunkActor->GridActor = this;
+					ChunkActor->ChunkCoord = ChunkCoord;
+					ChunkActor->Chunk = MoveTemp(Chunk);
+					ChunkActor->SetActorLabel(FString::Printf(TEXT("%s_Chunk_%d_%d"), *GetActorLabel(), ChunkX, ChunkY));
 
-				if (IsValidCell(CurrentCell) && EnumHasAllFlags(GetCellData(CurrentCell), ECellData::CellDataTraversable))
-				{
-					// we're good, iterate
-				}
-				else
-				{
-					// nope we hit
-					FVector2D HitLocationLocal = P0 + V * T;
-					TransformNormalizedGridSpaceToWorld(HitLocationLocal, HitLocationOut);
-					return true;
+					Chunk = FGAGridChunk();
 				}
 			}
 		}
-		else
-		{
-			// Close enough, there's no hit
-			return false;
-		}
-	}
-	else
-	{
-		HitLocationOut = Start;
-		return true;
 	}
 }
-
-
+#endif // WITH_EDITOR
 
 
 // Data from NavSystem --------------------------------
@@ -358,10 +1639,15 @@ bool AGAGridActor::RefreshDataFromNav()
 		FTransform ActorTransform = GetActorTransform();
 
 		// Allocate the array and set to 0
-		ResetData();
+		// Listeners hear about the whole rebuild once, at the end
+		ResetDataInternal();
 
 		ECellData* CellData = GetData();
 
+		TraversalCosts.SetNumZeroed(GetCellCount());
+		CellHeights.SetNumZeroed(GetCellCount());
+		bool bAnyTraversalCost = false;
+
 		// Code for extracting nav polys taken from here:
 		// https://nerivec.github.io/old-ue4-wiki/pages/ai-navigation-in-c-customize-path-following-every-tick.html
 
@@ -383,6 +1669,32 @@ bool AGAGridActor::RefreshDataFromNav()
 						NavMesh->GetPolyVerts(Ref, PolyVerts);
 						PolyVerts2D.SetNum(PolyVerts.Num());
 
+						// The poly's area cost goes into the cost channel
+						uint8 PolyCost = 0;
+						const UClass* AreaClass = NavMesh->GetAreaClass(NavMesh->GetPolyAreaID(Ref));
+						if (AreaClass)
+						{
+							float AreaCost = AreaClass->GetDefaultObject<UNavArea>()->DefaultCost;
+							PolyCost = uint8(FMath::Clamp(FMath::RoundToInt32((AreaCost - 1.0f) * TraversalCostScale), 0, 255));
+						}
+						bAnyTraversalCost |= (PolyCost != 0);
+
+						// And the poly's plane gives the floor height. Nav polys are convex and planar, so any three verts will do.
+						FVector PlaneOrigin = FVector::ZeroVector;
+						FVector PlaneNormal = FVector::ZAxisVector;
+						if (PolyVerts.Num() >= 3)
+						{
+							FVector LocalV0 = ActorTransform.InverseTransformPosition(PolyVerts[0]);
+							FVector LocalV1 = ActorTransform.InverseTransformPosition(PolyVerts[1]);
+							FVector LocalV2 = ActorTransform.InverseTransformPosition(PolyVerts[2]);
+							PlaneOrigin = LocalV0;
+							PlaneNormal = ((LocalV1 - LocalV0) ^ (LocalV2 - LocalV0)).GetSafeNormal();
+							if (FMath::Abs(PlaneNormal.Z) < UE_KINDA_SMALL_NUMBER)
+							{
+								PlaneNormal = FVector::ZAxisVector;
+							}
+						}
+
 						// transform verts to local space
 						for (int32 VertexIndex = 0; VertexIndex < PolyVerts.Num(); VertexIndex++)
 						{
@@ -450,6 +1762,12 @@ bool AGAGridActor::RefreshDataFromNav()
 										{
 											// turn on the traversable bit
 											EnumAddFlags(CellData[CellIndex], ECellData::CellDataTraversable);
+
+											FVector2D LocalCenter = CellCenter - HalfExtents;
+											float Height = PlaneOrigin.Z - (PlaneNormal.X * (LocalCenter.X - PlaneOrigin.X) + PlaneNormal.Y * (LocalCenter.Y - PlaneOrigin.Y)) / PlaneNormal.Z;
+
+											TraversalCosts[CellIndex] = PolyCost;
+											CellHeights[CellIndex] = FFloat16(Height).Encoded;
 										}
 									}
 								}
@@ -459,16 +1777,98 @@ bool AGAGridActor::RefreshDataFromNav()
 				}
 			}
 		}
+
+		// Uniform cost is the common case, and pathfinding is faster without the channel
+		if (!bAnyTraversalCost)
+		{
+			TraversalCosts.Empty();
+		}
+
+		if (bBakeCover)
+		{
+			BakeCoverDirections();
+		}
+
+		// Data was just the staging area, if we're chunked
+		BuildChunksFromData();
+
+		NotifyCellsChanged(GetGridRect());
 	}
 
 	return Result;
 }
 
 
+bool AGAGridActor::RefreshCoverData()
+{
+	if (!BakeCoverDirections())
+	{
+		return false;
+	}
+
+	NotifyCellsChanged(GetGridRect());
+	return true;
+}
+
+
+bool AGAGridActor::BakeCoverDirections()
+{
+	UWorld* World = GetWorld();
+	if (!World || (Data.Num() != GetCellCount()))
+	{
+		return false;
+	}
+
+	FTransform ActorTransform = GetActorTransform();
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GAGridCover), false, this);
+	bool bAnyCover = false;
+
+	CoverDirections.Reset();
+	CoverDirections.SetNumZeroed(GetCellCount());
+
+	for (int32 Y = 0; Y < YCount; Y++)
+	{
+		for (int32 X = 0; X < XCount; X++)
+		{
+			FCellRef Cell(X, Y);
+			int32 CellIndex = CellRefToIndex(Cell);
+			if (!EnumHasAllFlags(Data[CellIndex], ECellData::CellDataTraversable))
+			{
+				continue;
+			}
+
+			FVector LocalStart(GetCellGridSpacePosition(Cell) - HalfExtents, GetCellHeight(Cell) + CoverTraceHeight);
+			FVector Start = ActorTransform.TransformPosition(LocalStart);
+			uint8 Mask = 0;
+
+			for (int32 NeighborIndex = 0; NeighborIndex < 8; NeighborIndex++)
+			{
+				FVector LocalEnd = LocalStart + FVector(NeighborOffsets[NeighborIndex].X * CellScale, NeighborOffsets[NeighborIndex].Y * CellScale, 0.0f);
+				if (World->LineTraceTestByChannel(Start, ActorTransform.TransformPosition(LocalEnd), CoverTraceChannel, QueryParams))
+				{
+					Mask |= (1 << NeighborIndex);
+				}
+			}
+
+			CoverDirections[CellIndex] = Mask;
+			bAnyCover |= (Mask != 0);
+		}
+	}
+
+	if (!bAnyCover)
+	{
+		CoverDirections.Empty();
+	}
+
+	return true;
+}
+
+
 // Debugging and Visualization --------------------------------
 
 
-bool AGAGridActor::RefreshDebugMesh()
+// The arrays that go into UProceduralMeshComponent::CreateMeshSection
+struct FGADebugMeshBuffers
 {
 	TArray<FVector> Vertices;
 	TArray<int32> Triangles;
@@ -476,123 +1876,329 @@ bool AGAGridActor::RefreshDebugMesh()
 	TArray<FVector2D> UV0;
 	TArray<FColor> VertexColors;			// can safely leave empty
 	TArray<FProcMeshTangent> Tangents;		// can safely leave empty
+};
+
 
-	int32 VertexCount = (XCount + 1) * (YCount + 1);
+// Build a mesh covering an XCount x YCount grid, with one quad per CellsPerQuad x CellsPerQuad cells
+// (the quads along the far edges are cut short to fit). Heights holds the actor-space Z of each vertex.
+// This only touches its arguments, so it's safe to run off the game thread.
+static void BuildDebugMeshBuffers(int32 XCount, int32 YCount, float CellScale, int32 CellsPerQuad, const TArray<float>& Heights, FGADebugMeshBuffers& Out)
+{
+	int32 QuadXCount = (XCount + CellsPerQuad - 1) / CellsPerQuad;
+	int32 QuadYCount = (YCount + CellsPerQuad - 1) / CellsPerQuad;
+	int32 VertexXCount = QuadXCount + 1;
+	int32 VertexCount = VertexXCount * (QuadYCount + 1);
+
+	check(Heights.Num() == VertexCount);
+
+	FVector2D ZeroZeroCorner(
+		-float(XCount) * CellScale * 0.5f,
+		-float(YCount) * CellScale * 0.5f);
+
+	// Vertices, UVs and normals
+	// note, the use of the <= means we will have ONE MORE row and column or verts than quads
+	Out.Vertices.SetNumUninitialized(VertexCount);
+	Out.UV0.SetNumUninitialized(VertexCount);
+	Out.Normals.SetNumUninitialized(VertexCount);
 
-	// Generate the vertices array
-	// TODO: do a raycast to to figure out where the ground actually is
+	int32 Index = 0;
+	for (int32 Y = 0; Y <= QuadYCount; Y++)
 	{
-		Vertices.SetNumUninitialized(VertexCount);
+		for (int32 X = 0; X <= QuadXCount; X++)
+		{
+			int32 CellX = FMath::Min(X * CellsPerQuad, XCount);
+			int32 CellY = FMath::Min(Y * CellsPerQuad, YCount);
 
-		FVector2D ZeroZeroCorner(
-			-float(XCount) * CellScale * 0.5f, 
-			-float(YCount) * CellScale * 0.5f);
+			Out.Vertices[Index] = FVector(
+				float(CellX) * CellScale + ZeroZeroCorner.X,
+				float(CellY) * CellScale + ZeroZeroCorner.Y,
+				Heights[Index]);
 
-		int32 Index = 0;
+			Out.UV0[Index] = FVector2D(float(CellX) / float(XCount), float(CellY) / float(YCount));
+
+			// Normal from the slope to the neighboring vertices (straight up on flat meshes)
+			int32 X0 = FMath::Max(X - 1, 0), X1 = FMath::Min(X + 1, QuadXCount);
+			int32 Y0 = FMath::Max(Y - 1, 0), Y1 = FMath::Min(Y + 1, QuadYCount);
+			float SlopeX = (Heights[Y * VertexXCount + X1] - Heights[Y * VertexXCount + X0]) / (float((X1 - X0) * CellsPerQuad) * CellScale);
+			float SlopeY = (Heights[Y1 * VertexXCount + X] - Heights[Y0 * VertexXCount + X]) / (float((Y1 - Y0) * CellsPerQuad) * CellScale);
+			Out.Normals[Index] = FVector(-SlopeX, -SlopeY, 1.0f).GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector);
+
+			Index++;
+		}
+	}
 
-		for (int32 Y = 0; Y <= YCount; Y++)				// note, the use of the <= means we will have ONE MORE row and column or verts than cells
+	// Triangles, with counter-clockwise winding
+	Out.Triangles.SetNumUninitialized(QuadXCount * QuadYCount * 6);		// two triangles per quad
+	Index = 0;
+
+	for (int32 Y = 0; Y < QuadYCount; Y++)
+	{
+		for (int32 X = 0; X < QuadXCount; X++)
 		{
-			for (int32 X = 0; X <= XCount; X++)
-			{
-				FVector VertexPoint;
-				VertexPoint.X = float(X) * CellScale + ZeroZeroCorner.X;
-				VertexPoint.Y = float(Y) * CellScale + ZeroZeroCorner.Y;
-				VertexPoint.Z = DebugMeshZOffset;
-				Vertices[Index] = VertexPoint;
-				Index++;
-			}
+			// First figure out the four vertices of this quad (in counter-clockwise order)
+			// Note: personally, this breaks my brain a bit, but the labels of "bottom" and "left" etc. below are using
+			// UE's weird left-hand coordinate system, whereby X is the "right" direction and Y is the "down" direction
+
+			int32 Index0 = Y * VertexXCount + X;		// Top left
+			int32 Index1 = Index0 + VertexXCount;		// Bottom left
+			int32 Index2 = Index1 + 1;					// Bottom right
+			int32 Index3 = Index0 + 1;					// Top right
+
+			// First triangle - bottom right half of the quad
+			Out.Triangles[Index] = Index0;
+			Out.Triangles[Index + 1] = Index1;
+			Out.Triangles[Index + 2] = Index2;
+
+			// Second triangle - top left half of the quad
+			Out.Triangles[Index + 3] = Index0;
+			Out.Triangles[Index + 4] = Index2;
+			Out.Triangles[Index + 5] = Index3;
+
+			Index += 6;
 		}
 	}
+}
 
-	// Generate the triangles array with counter-clockwise winding
+
+bool AGAGridActor::RefreshDebugMesh()
+{
+	if (!DebugMeshComponent)
 	{
-		int32 TriangleCount = GetCellCount() * 6;		// two triangles per cell
-		Triangles.SetNumUninitialized(TriangleCount);
+		return false;
+	}
 
-		int32 VertexXCount = XCount + 1;
-		int32 Index = 0;
+	int32 CellsPerQuad = 1;
+	switch (DebugMeshMode)
+	{
+	case EGADebugMeshMode::PerCell:		CellsPerQuad = 1;								break;
+	case EGADebugMeshMode::SingleQuad:	CellsPerQuad = FMath::Max(XCount, YCount);		break;
+	case EGADebugMeshMode::TileQuads:	CellsPerQuad = FMath::Max(DebugMeshTileSize, 1);	break;
+	}
 
-		for (int32 Y = 0; Y < YCount; Y++)
-		{
-			for (int32 X = 0; X < XCount; X++)
-			{
-				// First figure out the four vertices of this cell (in counter-clockwise order)
-				// Note: personally, this breaks my brain a bit, but the labels of "bottom" and "left" etc. below are using
-				// UE's weird left-hand coordinate system, whereby X is the "right" direction and Y is the "down" direction
+	int32 QuadXCount = (XCount + CellsPerQuad - 1) / CellsPerQuad;
+	int32 QuadYCount = (YCount + CellsPerQuad - 1) / CellsPerQuad;
 
-				int32 Index0 = Y * VertexXCount + X;		// Top left
-				int32 Index1 = Index0 + VertexXCount;		// Bottom left
-				int32 Index2 = Index1 + 1;					// Bottom right
-				int32 Index3 = Index0 + 1;					// Top right
+	TArray<float> Heights;
+	Heights.Init(DebugMeshZOffset, (QuadXCount + 1) * (QuadYCount + 1));
 
-				// First triangle - bottom right half of the cell
-				Triangles[Index] = Index0;
-				Triangles[Index + 1] = Index1;
-				Triangles[Index + 2] = Index2;
+	// Drape the tiles over whatever is underneath. Traces have to happen here on the game thread, but there's
+	// only one per tile corner.
+	if (DebugMeshMode == EGADebugMeshMode::TileQuads)
+	{
+		const float TraceHalfHeight = 5000.0f;
+		FTransform ActorTransform = GetActorTransform();
+		FCollisionQueryParams QueryParams;
+		QueryParams.AddIgnoredActor(this);
 
-				// Second triangle - top left half of the cell
-				Triangles[Index + 3] = Index0;
-				Triangles[Index + 4] = Index2;
-				Triangles[Index + 5] = Index3;
+		int32 Index = 0;
+		for (int32 Y = 0; Y <= QuadYCount; Y++)
+		{
+			for (int32 X = 0; X <= QuadXCount; X++)
+			{
+				FVector2D GridPoint(FMath::Min(X * CellsPerQuad, XCount), FMath::Min(Y * CellsPerQuad, YCount));
+				FVector VertexWorld;
+				TransformNormalizedGridSpaceToWorld(GridPoint, VertexWorld);
 
-				Index += 6;
+				FHitResult Hit;
+				FVector Up = GetActorUpVector() * TraceHalfHeight;
+				if (GetWorld()->LineTraceSingleByChannel(Hit, VertexWorld + Up, VertexWorld - Up, ECC_WorldStatic, QueryParams))
+				{
+					Heights[Index] = ActorTransform.InverseTransformPosition(Hit.ImpactPoint).Z + DebugMeshZOffset;
+				}
+				Index++;
 			}
 		}
 	}
 
-	// Generate the UV coordinates for each vertex
-	{
-		UV0.SetNumUninitialized(VertexCount);
-		float DeltaX = 1.0f / float(XCount);
-		float DeltaY = 1.0f / float(YCount);
+	// Build the mesh on a worker, then hand it back to the game thread
+	int32 BuildSerial = ++DebugMeshBuildSerial;
+	TWeakObjectPtr<AGAGridActor> WeakThis(this);
+	int32 LocalXCount = XCount;
+	int32 LocalYCount = YCount;
+	float LocalCellScale = CellScale;
 
-		int32 Index = 0; 
+	Async(EAsyncExecution::ThreadPool, [WeakThis, BuildSerial, LocalXCount, LocalYCount, LocalCellScale, CellsPerQuad, Heights = MoveTemp(Heights)]()
+	{
+		TSharedRef<FGADebugMeshBuffers, ESPMode::ThreadSafe> Buffers = MakeShared<FGADebugMeshBuffers, ESPMode::ThreadSafe>();
+		BuildDebugMeshBuffers(LocalXCount, LocalYCount, LocalCellScale, CellsPerQuad, Heights, *Buffers);
 
-		for (int32 Y = 0; Y <= YCount; Y++)
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, BuildSerial, Buffers]()
 		{
-			for (int32 X = 0; X <= XCount; X++)
+			AGAGridActor* Grid = WeakThis.Get();
+
+			// Drop this one if we've been destroyed, or a newer build has started since
+			if (Grid && Grid->DebugMeshComponent && (Grid->DebugMeshBuildSerial == BuildSerial))
 			{
-				FVector2D UV(
-					float(X) * DeltaX,
-					float(Y) * DeltaY
+				Grid->DebugMeshComponent->CreateMeshSection(
+					0,				// section index
+					Buffers->Vertices,
+					Buffers->Triangles,
+					Buffers->Normals,
+					Buffers->UV0,
+					Buffers->VertexColors,
+					Buffers->Tangents,
+					false  // create collision
 				);
-
-				UV0[Index] = UV;
-				Index++;
 			}
-		}
+		});
+	});
+
+	return true;
+}
+
+// Debug texture colors, indexed by [Traversable] (and on the map, by [value quantized to 0-255] too)
+// Note: fade from blue to red as we approach the max value in the debug map
+//		blue	Are we on the map or not?
+//		green	Are we traversable or not?
+//		red		The value
+struct FGADebugColorTables
+{
+	FColor OnMap[2][256];
+	FColor OffMap[2];
+	FColor NoMap[2];
+};
+
+// Built once by the initializer and never written after, so the fill can read it from any thread
+static const FGADebugColorTables DebugColorTables = []()
+{
+	FGADebugColorTables Tables;
+	for (int32 Value = 0; Value < 256; Value++)
+	{
+		Tables.OnMap[0][Value] = FColor(Value, 0, 255 - Value, 255);
+		Tables.OnMap[1][Value] = FColor(Value, 50, 255 - Value, 255);
 	}
+	Tables.OffMap[0] = FColor(0, 0, 0, 255);
+	Tables.OffMap[1] = FColor(0, 50, 0, 255);
+	Tables.NoMap[0] = FColor(0, 0, 0, 255);
+	Tables.NoMap[1] = FColor(255, 255, 255, 255);
+	return Tables;
+}();
+
+
+// One debug texture update. Worked out on the game thread, filled in on a worker, and uploaded back on the game
+// thread. The worker only reads what's in here: snapshots of the map and of traversability, and the texel buffer,
+// which is lent out by the grid actor until the fill is done.
+struct FGADebugTextureFill
+{
+	int32 XCount = 0;
+	int32 YCount = 0;
+	FGridBox UpdateBox;
+	bool bFullUpdate = false;
+	float ValueScale = 0.0f;
 
-	// Generate the UV coordinates for each vertex
-	// For now, assume all are straight up
+	// Null if there's no debug map
+	TSharedPtr<const FGAGridMap, ESPMode::ThreadSafe> Map;
+
+	// Laid out like AGAGridActor::TraversableBits
+	TSharedPtr<const TArray<uint64>, ESPMode::ThreadSafe> TraversableBits;
+
+	TArray<FColor> Buffer;
+
+	// Results: one region per band of rows that changed, and their texels, packed one above the other into rows
+	// as wide as the widest region (so each region's source is at (0, the rows packed before it))
+	TArray<FUpdateTextureRegion2D> Regions;
+	TArray<uint8> PackedTexels;
+	int32 PackedPitch = 0;
+};
+
+
+// Bring Fill.Buffer up to date over Fill.UpdateBox, and pack the texels that actually changed for upload
+static void FillDebugTextureBuffer(FGADebugTextureFill& Fill)
+{
+	const int32 XCount = Fill.XCount;
+	const int32 YCount = Fill.YCount;
+	const FGridBox UpdateBox = Fill.UpdateBox;
+	const bool bFullUpdate = Fill.bFullUpdate;
+	const float ValueScale = Fill.ValueScale;
+	const FGAGridMap* Map = Fill.Map.Get();
+	const TArray<uint64>& TraversableBits = *Fill.TraversableBits;
+	TArray<FColor>& Buffer = Fill.Buffer;
+
+	if (bFullUpdate)
 	{
-		Normals.SetNumUninitialized(VertexCount);
-		int32 Index = 0;
+		Buffer.SetNumUninitialized(XCount * YCount);
+	}
 
-		for (int32 Y = 0; Y <= YCount; Y++)
+	// A band of rows at a time. Each band also works out the bounds of the texels that actually changed, so we only
+	// upload those.
+	const int32 BandHeight = 32;
+	const int32 BandCount = (YCount + BandHeight - 1) / BandHeight;
+
+	TArray<FIntRect> BandDirtyRects;
+	BandDirtyRects.SetNum(BandCount);
+
+	ParallelFor(BandCount, [&](int32 BandIndex)
+	{
+		int32 MinY = FMath::Max(BandIndex * BandHeight, UpdateBox.MinY);
+		int32 MaxY = FMath::Min((BandIndex + 1) * BandHeight, UpdateBox.MaxY + 1);
+		FIntRect DirtyRect(XCount, YCount, -1, -1);
+
+		for (int32 Y = MinY; Y < MaxY; Y++)
 		{
-			for (int32 X = 0; X <= XCount; X++)
+			for (int32 X = UpdateBox.MinX; X <= UpdateBox.MaxX; X++)
 			{
-				Normals[Index] = FVector::UpVector;
-				Index++;
+				const int32 CellIndex = GAGridLayout::GetIndex(X, Y, XCount);
+				const int32 Traversable = int32((TraversableBits[CellIndex >> 6] >> (CellIndex & 63)) & 1);
+				FColor Color;
+
+				if (Map)
+				{
+					if (Map->GridBounds.IsValidCell(X, Y))
+					{
+						float MapValue = Map->GetValueUnchecked(X, Y);
+						int32 IntVal = FMath::Clamp(FMath::RoundToInt(MapValue * ValueScale), 0, 255);
+						Color = DebugColorTables.OnMap[Traversable][IntVal];
+					}
+					else
+					{
+						Color = DebugColorTables.OffMap[Traversable];
+					}
+				}
+				else
+				{
+					Color = DebugColorTables.NoMap[Traversable];
+				}
+
+				FColor& Texel = Buffer[Y * XCount + X];
+				if (bFullUpdate || (Texel != Color))
+				{
+					Texel = Color;
+					DirtyRect.Min.X = FMath::Min(DirtyRect.Min.X, X);
+					DirtyRect.Min.Y = FMath::Min(DirtyRect.Min.Y, Y);
+					DirtyRect.Max.X = FMath::Max(DirtyRect.Max.X, X + 1);
+					DirtyRect.Max.Y = Y + 1;
+				}
 			}
 		}
-	}
 
-	DebugMeshComponent->CreateMeshSection(
-		0,				// section index
-		Vertices,		
-		Triangles,
-		Normals,
-		UV0,
-		VertexColors,
-		Tangents,
-		false  // create collision
-	);
+		BandDirtyRects[BandIndex] = DirtyRect;
+	});
 
-	return true;
+	int32 PackedWidth = 0;
+	int32 PackedHeight = 0;
+	for (const FIntRect& DirtyRect : BandDirtyRects)
+	{
+		if (DirtyRect.Max.X > DirtyRect.Min.X)
+		{
+			Fill.Regions.Add(FUpdateTextureRegion2D(DirtyRect.Min.X, DirtyRect.Min.Y, 0, PackedHeight, DirtyRect.Width(), DirtyRect.Height()));
+			PackedWidth = FMath::Max(PackedWidth, DirtyRect.Width());
+			PackedHeight += DirtyRect.Height();
+		}
+	}
+
+	// Only the changed texels are copied, not the whole texture
+	Fill.PackedPitch = PackedWidth * sizeof(FColor);
+	Fill.PackedTexels.SetNumUninitialized(Fill.PackedPitch * PackedHeight);
+	for (const FUpdateTextureRegion2D& Region : Fill.Regions)
+	{
+		for (uint32 Row = 0; Row < Region.Height; Row++)
+		{
+			FMemory::Memcpy(Fill.PackedTexels.GetData() + (Region.SrcY + Row) * Fill.PackedPitch, Buffer.GetData() + (Region.DestY + Row) * XCount + Region.DestX, Region.Width * sizeof(FColor));
+		}
+	}
 }
 
+
 bool AGAGridActor::RefreshDebugTexture()
 {
 	bool Result = false;
@@ -614,82 +2220,171 @@ bool AGAGridActor::RefreshDebugTexture()
 
 	if (DebugMeshComponent)
 	{
-		// create a new texture
-		UTexture2D *RuntimeTexture = UTexture2D::CreateTransient(XCount, YCount);
-		FTexture2DMipMap *FirstMip = &RuntimeTexture->GetPlatformData()->Mips[0];
-		FByteBulkData *ImageData = &FirstMip->BulkData;
-		uint8* RawImageData = (uint8*)ImageData->Lock(LOCK_READ_WRITE);
-		int32 ElementCount = ImageData->GetElementCount();
-		int32 ElementSize = ImageData->GetElementSize();
+		// The fill in flight has DebugTextureBuffer. Whatever changes meanwhile (the map's dirty cells, the chunk
+		// versions) piles up until it's done, and then we go again.
+		if (bDebugTextureFillInFlight)
+		{
+			bDebugTextureRefreshPending = true;
+			return true;
+		}
 
-		check(ElementCount == 4 * XCount * YCount);
-		check(ElementSize == sizeof(uint8));
+		// (Re)create the texture only if we don't have one of the right size
+		bool bNewTexture = false;
+		if (!DebugTexture || (DebugTexture->GetSizeX() != XCount) || (DebugTexture->GetSizeY() != YCount))
+		{
+			DebugTexture = UTexture2D::CreateTransient(XCount, YCount, PF_B8G8R8A8);
+			DebugTexture->UpdateResource();
+			DebugTextureBuffer.Reset();
+			bNewTexture = true;
+		}
 
-		int32 Index = 0;
+		if (!DebugMaterialInstance || bNewTexture)
+		{
+			if (!DebugMaterialInstance)
+			{
+				DebugMaterialInstance = DebugMeshComponent->CreateDynamicMaterialInstance(0, DebugMaterial);
+			}
+
+			if (DebugMaterialInstance)
+			{
+				DebugMaterialInstance->SetTextureParameterValue("DebugTexture", DebugTexture);
+				DebugMeshComponent->SetMaterial(0, DebugMaterialInstance);
+			}
+		}
 
-		if (DebugGridMap.IsValid())
+		bool bHasMap = DebugGridMap.IsValid();
+		float ValueScale = 0.0f;
+		if (bHasMap)
 		{
 			float MaxValue;
 			DebugGridMap.GetMaxValue(MaxValue);
+			ValueScale = (MaxValue > 0.0f) ? 255.0f / MaxValue : 0.0f;
+		}
 
-			for (int32 Y = 0; Y < YCount; Y++)
+		// A texel's color depends on its cell, the map value and the value scale. If only map values and cells changed
+		// since last time, and the map is tracking dirty cells, only those texels need to be redone (the chunk versions
+		// say where the cells changed). Otherwise do them all.
+		const FGridBox MapDirtyBox = DebugGridMap.ConsumeDirtyBox();
+		FGridBox CellsChangedBox;
+		bool bAllCellsChanged = false;
+		if (DebugTextureGridVersion != GridVersion)
+		{
+			bAllCellsChanged = (DebugTextureGridVersion == INDEX_NONE) || (ChunkVersions.Num() != ChunkXCount * ChunkYCount);
+			for (int32 ChunkY = 0; !bAllCellsChanged && (ChunkY < ChunkYCount); ChunkY++)
 			{
-				for (int32 X = 0; X < XCount; X++)
+				for (int32 ChunkX = 0; ChunkX < ChunkXCount; ChunkX++)
 				{
-					FCellRef CellRef(X, Y);
-					ECellData CellData = GetCellData(CellRef);
-					bool Traversable = EnumHasAllFlags(CellData, ECellData::CellDataTraversable);
-
-					float MapValue;
-					bool IsOnMap = DebugGridMap.GetValue(CellRef, MapValue);
-					int32 IntVal = 0;
-					if (IsOnMap)
+					if (ChunkVersions[ChunkY * ChunkXCount + ChunkX] > DebugTextureGridVersion)
 					{
-						IntVal = FMath::RoundToInt(255.0f * (MapValue / MaxValue));
+						CellsChangedBox = CellsChangedBox.GetUnion(FGridBox(ChunkX << FGAGridChunk::SizeShift, ((ChunkX + 1) << FGAGridChunk::SizeShift) - 1,
+							ChunkY << FGAGridChunk::SizeShift, ((ChunkY + 1) << FGAGridChunk::SizeShift) - 1));
 					}
-
-					// Note: fade from blue to red as we approach the max value in the debug map
-
-					RawImageData[Index] = IsOnMap ? 255 - IntVal : 0;		// blue		Are we on the map or not?
-					RawImageData[Index + 1] = Traversable ? 50 : 0;			// green	Are we traversable or not?
-					RawImageData[Index + 2] = IntVal;						// red		The value
-					RawImageData[Index + 3] = 255;							// alpha
-
-					Index += 4;
 				}
 			}
-
 		}
-		else
+
+		const bool bFullUpdate = (DebugTextureBuffer.Num() != XCount * YCount) || !bHasMap || !DebugGridMap.IsTrackingDirty() ||
+			bAllCellsChanged || (DebugTextureValueScale != ValueScale) || (DebugTextureMapBounds != DebugGridMap.GridBounds);
+
+		// Traversability only changes with the grid version (or size), so the copy of it that fills read is only
+		// redone then
+		if (!DebugTextureTraversableBits.IsValid() || (DebugTextureGridVersion != GridVersion) ||
+			(DebugTextureTraversableBits->Num() * 64 < GetCellCount()))
 		{
-			for (int32 Y = 0; Y < YCount; Y++)
+			TSharedRef<TArray<uint64>, ESPMode::ThreadSafe> Bits = MakeShared<TArray<uint64>, ESPMode::ThreadSafe>();
+			if (TraversableBits.Num() > 0)
 			{
-				for (int32 X = 0; X < XCount; X++)
+				*Bits = TraversableBits;
+			}
+			else
+			{
+				// Not built (e.g. chunked storage), so ask cell by cell
+				Bits->SetNumZeroed((GetCellCount() + 63) / 64);
+				for (int32 Y = 0; Y < YCount; Y++)
 				{
-					ECellData CellData = GetCellData(FCellRef(X, Y));
-					bool Traversable = EnumHasAllFlags(CellData, ECellData::CellDataTraversable);
-					uint8 Val = Traversable ? 255 : 0;
-
-					RawImageData[Index] = Val;			// blue 
-					RawImageData[Index + 1] = Val;		// green
-					RawImageData[Index + 2] = Val;		// red
-					RawImageData[Index + 3] = 255;		// alpha
-
-					Index += 4;
+					for (int32 X = 0; X < XCount; X++)
+					{
+						FCellRef CellRef(X, Y);
+						if (IsCellTraversable(CellRef))
+						{
+							int32 CellIndex = CellRefToIndex(CellRef);
+							(*Bits)[CellIndex >> 6] |= uint64(1) << (CellIndex & 63);
+						}
+					}
 				}
 			}
+			DebugTextureTraversableBits = Bits;
 		}
 
-		ImageData->Unlock();
-		RuntimeTexture->UpdateResource();
+		DebugTextureGridVersion = GridVersion;
+		DebugTextureValueScale = ValueScale;
+		DebugTextureMapBounds = DebugGridMap.GridBounds;
 
-		UMaterialInstanceDynamic* DynamicMaterial = DebugMeshComponent->CreateDynamicMaterialInstance(0, DebugMaterial);
-		if (DynamicMaterial)
+		const FGridBox UpdateBox = bFullUpdate ? FGridBox(0, XCount - 1, 0, YCount - 1) : MapDirtyBox.GetUnion(CellsChangedBox).GetOverlap(FGridBox(0, XCount - 1, 0, YCount - 1));
+		if (!UpdateBox.IsValid())
 		{
-			DynamicMaterial->SetTextureParameterValue("DebugTexture", RuntimeTexture);
-			DebugMeshComponent->SetMaterial(0, DynamicMaterial);
+			// Nothing changed
+			return true;
 		}
 
+		// Fill the texels on a worker. It reads a snapshot of the debug map, which is only copied where it changed
+		// since the last fill, so the map can keep changing meanwhile.
+		TSharedRef<FGADebugTextureFill, ESPMode::ThreadSafe> Fill = MakeShared<FGADebugTextureFill, ESPMode::ThreadSafe>();
+		Fill->XCount = XCount;
+		Fill->YCount = YCount;
+		Fill->UpdateBox = UpdateBox;
+		Fill->bFullUpdate = bFullUpdate;
+		Fill->ValueScale = ValueScale;
+		if (bHasMap)
+		{
+			Fill->Map = DebugGridMap.GetSnapshot();
+		}
+		Fill->TraversableBits = DebugTextureTraversableBits;
+		Fill->Buffer = MoveTemp(DebugTextureBuffer);
+		bDebugTextureFillInFlight = true;
+
+		TWeakObjectPtr<AGAGridActor> WeakThis(this);
+		Async(EAsyncExecution::ThreadPool, [WeakThis, Fill]()
+		{
+			FillDebugTextureBuffer(*Fill);
+
+			// Let go of the snapshots now, so the next fill can bring the same one up to date rather than copy it all
+			Fill->Map.Reset();
+			Fill->TraversableBits.Reset();
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Fill]()
+			{
+				AGAGridActor* Grid = WeakThis.Get();
+				if (!Grid)
+				{
+					return;
+				}
+
+				Grid->bDebugTextureFillInFlight = false;
+
+				// If the grid was resized meanwhile, drop the fill; with no buffer, the next refresh redoes everything
+				if (Grid->DebugTexture && (Grid->DebugTexture->GetSizeX() == Fill->XCount) && (Grid->DebugTexture->GetSizeY() == Fill->YCount) &&
+					(Grid->XCount == Fill->XCount) && (Grid->YCount == Fill->YCount))
+				{
+					Grid->DebugTextureBuffer = MoveTemp(Fill->Buffer);
+
+					if (Fill->Regions.Num() > 0)
+					{
+						// The render thread reads the packed texels later. The cleanup function holds on to Fill
+						// (and so to them) until it's done.
+						Grid->DebugTexture->UpdateTextureRegions(0, Fill->Regions.Num(), Fill->Regions.GetData(), Fill->PackedPitch, sizeof(FColor), Fill->PackedTexels.GetData(),
+							[Fill](uint8*, const FUpdateTextureRegion2D*) {});
+					}
+				}
+
+				if (Grid->bDebugTextureRefreshPending)
+				{
+					Grid->bDebugTextureRefreshPending = false;
+					Grid->RefreshDebugTexture();
+				}
+			});
+		});
+
 		Result = true;
 	}
 
@@ -3,12 +3,16 @@
 #include "CoreMinimal.h"
 #include "Math/MathFwd.h"
 #include "GAGridMap.h"
+#include "GASummedAreaTable.h"
+#include "GAGridLayout.h"
+#include "GADynamicObstacleComponent.h"
 #include "GAGridActor.generated.h"
 
 class UBoxComponent;
 class USceneComponent;
 class UProceduralMeshComponent;
 class UTexture2D;
+class UMaterialInstanceDynamic;
 
 UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
 enum class ECellData : uint8
@@ -19,6 +23,63 @@ enum class ECellData : uint8
 ENUM_CLASS_FLAGS(ECellData);
 
 
+UENUM(BlueprintType)
+enum class EGADebugMeshMode : uint8
+{
+	PerCell			UMETA(DisplayName = "Per Cell"),		// One quad per cell. Gets very heavy on big grids.
+	SingleQuad		UMETA(DisplayName = "Single Quad"),		// One flat quad over the whole grid. All per-cell info comes from the texture anyway.
+	TileQuads		UMETA(DisplayName = "Tile Quads"),		// One quad per DebugMeshTileSize cells, draped over the ground
+};
+
+
+UENUM()
+enum class EGAGridChunkState : uint8
+{
+	Unloaded,		// Not streamed in. All cells read as CellDataNone.
+	Uniform,		// Every cell has the same value, stored once in UniformValue
+	Dense			// Cells are stored individually
+};
+
+
+// A fixed-size square tile of grid cells, used by AGAGridActor's chunked storage
+// Uniform chunks (entirely blocked or entirely open) don't store any per-cell data.
+USTRUCT()
+struct FGAGridChunk
+{
+	GENERATED_USTRUCT_BODY()
+
+	FGAGridChunk() : State(EGAGridChunkState::Unloaded), UniformValue(ECellData::CellDataNone) {}
+
+	// Chunks are Size x Size cells. Size is a power of two so cell -> chunk is a shift and a mask.
+	static constexpr int32 SizeShift = 6;
+	static constexpr int32 Size = 1 << SizeShift;
+	static constexpr int32 SizeMask = Size - 1;
+
+	UPROPERTY()
+	EGAGridChunkState State;
+
+	UPROPERTY()
+	ECellData UniformValue;
+
+	// Size * Size cells, X-major, only for Dense chunks
+	UPROPERTY()
+	TArray<ECellData> Cells;
+
+	FORCEINLINE ECellData GetCellData(int32 LocalX, int32 LocalY) const
+	{
+		switch (State)
+		{
+		case EGAGridChunkState::Uniform:	return UniformValue;
+		case EGAGridChunkState::Dense:		return Cells[(LocalY << SizeShift) + LocalX];
+		default:							return ECellData::CellDataNone;
+		}
+	}
+
+	// If every cell has the same value, drop the per-cell data and mark us Uniform
+	void Compact();
+};
+
+
 USTRUCT(BlueprintType)
 struct FCellRef
 {
@@ -62,6 +123,52 @@ struct FCellRef
 };
 
 
+// Fixed-capacity list of neighbor cells. There are never more than 8 neighbors, so the storage
+// lives inline and filling one of these never touches the heap -- handy for search inner loops.
+typedef TArray<FCellRef, TFixedAllocator<8>> FCellNeighbors;
+
+
+// Fired after cells on a grid change. ChangedCells is inclusive (Max is the last changed cell, not one past it).
+DECLARE_MULTICAST_DELEGATE_TwoParams(FGAGridCellsChanged, AGAGridActor* /*Grid*/, const FIntRect& /*ChangedCells*/);
+
+
+// The grid actor's world <-> normalized grid space mapping, flattened into a 2D affine form.
+// Normalized grid space is the space in which a cell is 1.0 units wide, with (0, 0) at the min corner of cell (0, 0).
+// Going through this instead of the actor's FTransform saves a quaternion rotation per conversion.
+struct FGAGridAffine
+{
+	// World position of normalized grid space (0, 0)
+	FVector GridOrigin = FVector::ZeroVector;
+
+	// World-space step for +1.0 in normalized grid X and Y
+	FVector GridAxisX = FVector::XAxisVector;
+	FVector GridAxisY = FVector::YAxisVector;
+
+	// World-space step for +1.0 along the grid's local Z (heights above the grid plane, as in GetCellHeight)
+	FVector GridAxisZ = FVector::ZAxisVector;
+
+	// Rows of the inverse: GridPos.X = (WorldPos - GridOrigin) | WorldToGridX, and similarly for Y
+	FVector WorldToGridX = FVector::XAxisVector;
+	FVector WorldToGridY = FVector::YAxisVector;
+
+	FORCEINLINE FVector2D WorldToGrid(const FVector& WorldPosition) const
+	{
+		FVector Delta = WorldPosition - GridOrigin;
+		return FVector2D(Delta | WorldToGridX, Delta | WorldToGridY);
+	}
+
+	FORCEINLINE FVector GridToWorld(const FVector2D& GridPosition) const
+	{
+		return GridOrigin + GridAxisX * GridPosition.X + GridAxisY * GridPosition.Y;
+	}
+
+	FORCEINLINE FVector GridToWorld(const FVector2D& GridPosition, float Height) const
+	{
+		return GridToWorld(GridPosition) + GridAxisZ * Height;
+	}
+};
+
+
 UCLASS(BlueprintType, Blueprintable)
 class AGAGridActor : public AActor 
 {
@@ -92,10 +199,65 @@ class AGAGridActor : public AActor
 	TObjectPtr<USceneComponent> SceneComponent;
 
 	// Data
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
+	// Read-only to Blueprints: writes have to go through SetCellData (or NotifyCellsChanged from C++), so the
+	// versions and derived data everything else caches from stay in step
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	TArray<ECellData> Data;
 
+	// Extra per-cell channels --------------------------------
+	// Structure-of-arrays alongside Data: same length, same ordering (see CellRefToIndex). Baked in RefreshDataFromNav.
+	// An empty channel means it isn't present. Chunked grids don't carry any of these.
+
+	// Extra cost for stepping into the cell. A step costs (1 + TraversalCost / TraversalCostScale) times its length.
+	// Baked from the nav area's DefaultCost, and left empty if every cell costs the same.
+	UPROPERTY()
+	TArray<uint8> TraversalCosts;
+
+	static constexpr float TraversalCostScale = 32.0f;
+
+	// For each cell, bit N is set if there's cover in the direction of NeighborOffsets[N]. See RefreshCoverData.
+	UPROPERTY()
+	TArray<uint8> CoverDirections;
+
+	// Floor height at the center of each cell, in actor space. These are FFloat16 bits,
+	// since UPROPERTYs can't be FFloat16 directly. Use GetCellHeight to read them.
+	UPROPERTY()
+	TArray<uint16> CellHeights;
+
+	// If set, RefreshDataFromNav also bakes CoverDirections
+	UPROPERTY(EditAnywhere)
+	bool bBakeCover;
+
+	// Cover is traced this far above the floor, out to one cell away
+	UPROPERTY(EditAnywhere)
+	float CoverTraceHeight;
+
+	UPROPERTY(EditAnywhere)
+	TEnumAsByte<ECollisionChannel> CoverTraceChannel;
+
+	// Chunked storage --------------------------------
+	// For very large grids. When set, the cell data lives in Chunks (FGAGridChunk::Size squared tiles)
+	// rather than in Data. Uniform chunks cost a couple of bytes, and dense chunks can be split out into
+	// AGAGridChunkActors (see CreateChunkActors) so they stream in and out with World Partition.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bChunkedStorage;
+
+	// ChunkXCount * ChunkYCount chunks, X-major
+	UPROPERTY()
+	TArray<FGAGridChunk> Chunks;
+
+	// Calculated
+	UPROPERTY()
+	int32 ChunkXCount;
+
+	UPROPERTY()
+	int32 ChunkYCount;
+
 	virtual void PostLoad() override;
+	virtual void PostRegisterAllComponents() override;
+	virtual void PostUnregisterAllComponents() override;
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
 
 #if WITH_EDITORONLY_DATA
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
@@ -106,15 +268,183 @@ class AGAGridActor : public AActor
 	TObjectPtr<UBoxComponent> BoxComponent;
 #endif //WITH_EDITORONLY_DATA
 
+	// Derived per-cell data, rebuilt from Data whenever it changes (see RefreshCachedCellData)
+	// Not serialized.
+
+	// For each cell, bit N is set if the neighbor at NeighborOffsets[N] is on the grid and traversable
+	TArray<uint8> NeighborMasks;
+
+	// One bit per cell (indexed by CellRefToIndex), set if the cell is traversable.
+	// 64 cells per word, so line traces stay in cache even on big grids.
+	TArray<uint64> TraversableBits;
+
+	// For each cell, the distance (in cells) from its center to the nearest blocked cell, capped at MaxClearanceCells.
+	// Blocked cells have a clearance of 0. Cells off the edge of the grid count as blocked.
+	TArray<float> ClearanceMap;
+
+	// Clearance is only tracked up to this many cells, which keeps it cheap to update locally
+	static constexpr float MaxClearanceCells = 16.0f;
+
+	// One bit per cell, laid out like TraversableBits, set if a dynamic obstacle is covering the cell.
+	// TraversableBits and NeighborMasks already have these cells taken out.
+	TArray<uint64> DynamicBlockedBits;
+
 private:
 	ECellData* GetData() { return Data.GetData(); }
-	int32 GetCellCount() { return XCount*YCount; }
+	// Number of entries in Data and the per-cell derived arrays (this includes any padding the layout needs)
+	int32 GetCellCount() const { return GAGridLayout::GetAllocatedCount(XCount, YCount); }
 
 	void RefreshDerivedValues();
 
+	// Cached world <-> grid mapping. Rebuilt on demand after the actor moves or the dimensions change.
+	mutable FGAGridAffine CachedAffine;
+	mutable bool bCachedAffineDirty;
+
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	// Patch the derived per-cell data after the cells in Rect changed. Rebuilds everything if the caches aren't built yet.
+	void RefreshCachedCellDataInRect(const FIntRect& Rect);
+
+	// Recompute the clearance of the cells in Window. Cells just outside the window are taken as they are.
+	void RefreshClearanceMap(const FIntRect& Window);
+
+	// Allocate and zero Data without telling anyone. Callers are expected to call NotifyCellsChanged once they're done.
+	void ResetDataInternal();
+
+	// The guts of RefreshCoverData, without the notification
+	bool BakeCoverDirections();
+
+	// Clip an inclusive cell rectangle to the grid. Returns false if nothing is left.
+	bool ClipRectToGrid(FIntRect& Rect) const;
+
+	struct FDynamicObstacleEntry
+	{
+		TWeakObjectPtr<UGADynamicObstacleComponent> Obstacle;
+
+		// What we last stamped for this obstacle. StampedRect is inclusive and clipped to the grid.
+		FGAObstacleFootprint Footprint;
+		FIntRect StampedRect;
+		bool bStamped = false;
+	};
+
+	TArray<FDynamicObstacleEntry> DynamicObstacles;
+
+	// Rebuild DynamicBlockedBits inside Rect from the footprints of every stamped obstacle
+	void RestampDynamicObstacles(const FIntRect& Rect);
+
+	// Built by GetTraversableSumTable, from the grid as of TraversableSumTableVersion
+	mutable FGASummedAreaTable TraversableSumTable;
+	mutable int32 TraversableSumTableVersion;
+
+	// Slow path for TraceLineWithRadius when there's no clearance map (i.e. chunked storage)
+	bool HasClearance(const FCellRef& Cell, float RadiusCells) const;
+
+	template<typename CellTestType>
+	bool TraceLineInternal(const FVector& Start, const FVector& End, FVector& HitLocationOut, bool bTestStartCell, CellTestType IsCellClear) const;
+
 public:
 	bool ResetData();
 
+	// Resize the grid to InXCount x InYCount cells, all zeroed (as ResetData). Use this rather than setting XCount
+	// and YCount directly, which leaves the chunk counts, extents and change tracking sized for the old dimensions.
+	void SetDimensions(int32 InXCount, int32 InYCount);
+
+	// Rebuild the derived per-cell data (neighbor masks, etc.) from Data
+	// Anything that writes to Data directly needs to call this (or NotifyCellsChanged, for a smaller area) afterwards
+	// Note: with chunked storage, none of the derived data is kept, and the accessors work from the chunks directly.
+	UFUNCTION(BlueprintCallable)
+	void RefreshCachedCellData();
+
+	// Change tracking --------------------------------
+	// Every write to the cells has to end up in NotifyCellsChanged. That bumps GridVersion, stamps the
+	// versions of the chunks it touched, patches the derived data and fires OnCellsChanged.
+	// Consumers can hang on to a version and compare it later, rather than recomputing every frame.
+
+	// Tell the grid (and everyone listening) that the cells in Rect changed. Rect is inclusive.
+	void NotifyCellsChanged(const FIntRect& Rect);
+
+	// Set the flags on a single cell. Works with either kind of storage (but not on unloaded chunks).
+	UFUNCTION(BlueprintCallable)
+	bool SetCellData(const FCellRef& CellRef, ECellData Value);
+
+	// Goes up by one every time any cell changes
+	UFUNCTION(BlueprintCallable)
+	int32 GetGridVersion() const { return GridVersion; }
+
+	// The GridVersion of the last change to touch the given chunk
+	// Note: versions are tracked per FGAGridChunk-sized tile whether or not bChunkedStorage is set.
+	int32 GetChunkVersion(const FIntPoint& ChunkCoord) const;
+
+	// The newest chunk version under the given (inclusive) cell rectangle.
+	// If this hasn't changed, nothing in the rectangle has either.
+	int32 GetRegionVersion(const FIntRect& Rect) const;
+
+	// Dynamic obstacles --------------------------------
+	// Things that move around and block cells on top of whatever Data says (see UGADynamicObstacleComponent).
+	// Their footprints are stamped into DynamicBlockedBits, and that's folded into the derived data, so
+	// GetNeighbors, TraceLine etc. honor them for free. Data itself (and GetCellData) only ever has the static flags.
+
+	void RegisterDynamicObstacle(UGADynamicObstacleComponent* Obstacle);
+	void UnregisterDynamicObstacle(UGADynamicObstacleComponent* Obstacle);
+
+	// Restamp any obstacles that have moved (or changed) since the last update. Only the old and new
+	// footprint rectangles of those obstacles are touched. Runs every tick while there are obstacles registered.
+	UFUNCTION(BlueprintCallable)
+	void UpdateDynamicObstacles();
+
+	FORCEINLINE bool IsCellDynamicBlocked(int32 CellIndex) const
+	{
+		return DynamicBlockedBits.IsValidIndex(CellIndex >> 6) && ((DynamicBlockedBits[CellIndex >> 6] & (uint64(1) << (CellIndex & 63))) != 0);
+	}
+
+	// The whole grid as an inclusive cell rectangle
+	FORCEINLINE FIntRect GetGridRect() const { return FIntRect(0, 0, XCount - 1, YCount - 1); }
+
+	FGAGridCellsChanged OnCellsChanged;
+
+	// Not serialized, so versions start from 0 each session
+	int32 GridVersion;
+
+	// ChunkXCount * ChunkYCount, X-major
+	TArray<int32> ChunkVersions;
+
+	// Chunked storage --------------------------------
+
+	// Split Data up into Chunks and release Data. Only does anything if bChunkedStorage is set.
+	UFUNCTION(BlueprintCallable)
+	bool BuildChunksFromData();
+
+	// Stream a chunk in or out. Cells in unloaded chunks read as CellDataNone (i.e. blocked).
+	bool LoadChunk(const FIntPoint& ChunkCoord, const FGAGridChunk& Chunk);
+	bool UnloadChunk(const FIntPoint& ChunkCoord);
+
+	FORCEINLINE FIntPoint GetChunkCoord(const FCellRef& Cell) const
+	{
+		return FIntPoint(Cell.X >> FGAGridChunk::SizeShift, Cell.Y >> FGAGridChunk::SizeShift);
+	}
+
+	FORCEINLINE bool IsValidChunk(const FIntPoint& ChunkCoord) const
+	{
+		return (ChunkCoord.X >= 0) && (ChunkCoord.X < ChunkXCount) && (ChunkCoord.Y >= 0) && (ChunkCoord.Y < ChunkYCount);
+	}
+
+	// World position of the center of a chunk
+	FVector GetChunkPosition(const FIntPoint& ChunkCoord) const;
+
+	// The cells covered by a chunk, as an inclusive rectangle. Not clipped to the grid.
+	FORCEINLINE FIntRect GetChunkRect(const FIntPoint& ChunkCoord) const
+	{
+		FIntPoint ChunkMin(ChunkCoord.X << FGAGridChunk::SizeShift, ChunkCoord.Y << FGAGridChunk::SizeShift);
+		return FIntRect(ChunkMin, ChunkMin + FIntPoint(FGAGridChunk::SizeMask, FGAGridChunk::SizeMask));
+	}
+
+#if WITH_EDITOR
+	// Move every dense chunk into its own AGAGridChunkActor, placed at the chunk's location, so that
+	// World Partition can stream it. Replaces any chunk actors previously created for this grid.
+	UFUNCTION(CallInEditor, Category = "Grid")
+	void CreateChunkActors();
+#endif // WITH_EDITOR
+
 	// Accessors --------------------------------
 
 	// Return the cell the given point is inside of
@@ -137,17 +467,51 @@ public:
 
 
 	// Return the flattened index of the cell
-	// The assumes a X-major ordering of the data array.
+	// By default this assumes a X-major ordering of the data array.
 	// i.e. if we had a three by three grid, the flattened array would have the data in this order
 	//		(0, 0), (1, 0), (2, 0), (0, 1), (1, 1), (2, 1), (0, 2), (1, 2), (2, 2)
 	// Put another way, all the values in a given X-row are stored in consecutive spans of memory
+	// The ordering can be changed at compile time though, see GAGridLayout.h
 	UFUNCTION(BlueprintCallable)
-	FORCEINLINE int32 CellRefToIndex(const FCellRef& CellRef) const { return CellRef.Y * XCount + CellRef.X; }
+	FORCEINLINE int32 CellRefToIndex(const FCellRef& CellRef) const { return GAGridLayout::GetIndex(CellRef.X, CellRef.Y, XCount); }
 
 	// Get the flags associated with the given cell reference
 	UFUNCTION(BlueprintCallable)
 	ECellData GetCellData(const FCellRef &CellRef) const;
 
+	FORCEINLINE bool HasTraversalCosts() const { return TraversalCosts.Num() == GetCellCount(); }
+
+	// Multiplier on the cost of stepping into the given cell. Assumes HasTraversalCosts() and a valid index.
+	FORCEINLINE float GetTraversalCostMultiplier(int32 CellIndex) const
+	{
+		return 1.0f + float(TraversalCosts[CellIndex]) * (1.0f / TraversalCostScale);
+	}
+
+	// Multiplier on the cost of stepping into the given cell (1 if there are no costs)
+	UFUNCTION(BlueprintCallable)
+	float GetCellTraversalCost(const FCellRef& CellRef) const;
+
+	// Bit N is set if there's cover in the direction of NeighborOffsets[N]
+	UFUNCTION(BlueprintCallable)
+	uint8 GetCellCoverDirections(const FCellRef& CellRef) const;
+
+	// Floor height of the cell, in actor space (0 if no heights were baked)
+	UFUNCTION(BlueprintCallable)
+	float GetCellHeight(const FCellRef& CellRef) const;
+
+	// Like GetCellPosition, but on the floor rather than the grid plane
+	UFUNCTION(BlueprintCallable)
+	FVector GetCellFloorPosition(const FCellRef& CellRef) const;
+
+	// Return the distance in world units from the center of the cell to the nearest blocked cell
+	// (capped at MaxClearanceCells cells). Returns 0 for blocked or invalid cells.
+	UFUNCTION(BlueprintCallable)
+	float GetCellClearance(const FCellRef& CellRef) const;
+
+	// Summed-area table of traversability (1 per traversable cell), for counting the open cells in any box in
+	// constant time. Rebuilt on demand the first time it's asked for after GridVersion changes. Game thread only.
+	const FGASummedAreaTable& GetTraversableSumTable() const;
+
 	// Returns the bounds of the given box in cell indices
 	// Note, assumes the Box is in grid-space already
 	// Returns an invalid rectangle if the Box and the grid are disjoint
@@ -158,17 +522,74 @@ public:
 		return (Cell.X >= 0) && (Cell.X < XCount) && (Cell.Y >= 0) && (Cell.Y < YCount);
 	}
 
+	// Returns true if the cell is on the grid and traversable. Reads the traversability bitset.
+	FORCEINLINE bool IsCellTraversable(const FCellRef& Cell) const
+	{
+		if (!IsValidCell(Cell))
+		{
+			return false;
+		}
+
+		int32 CellIndex = CellRefToIndex(Cell);
+		if (TraversableBits.Num() > 0)
+		{
+			return (TraversableBits[CellIndex >> 6] & (uint64(1) << (CellIndex & 63))) != 0;
+		}
+		if (bChunkedStorage && (Chunks.Num() == ChunkXCount * ChunkYCount))
+		{
+			return EnumHasAllFlags(GetChunkedCellData(Cell), ECellData::CellDataTraversable) && !IsCellDynamicBlocked(CellIndex);
+		}
+		return Data.IsValidIndex(CellIndex) && EnumHasAllFlags(Data[CellIndex], ECellData::CellDataTraversable) && !IsCellDynamicBlocked(CellIndex);
+	}
+
+	// Cell lookup for chunked storage. Assumes Cell is valid.
+	FORCEINLINE ECellData GetChunkedCellData(const FCellRef& Cell) const
+	{
+		const FGAGridChunk& Chunk = Chunks[(Cell.Y >> FGAGridChunk::SizeShift) * ChunkXCount + (Cell.X >> FGAGridChunk::SizeShift)];
+		return Chunk.GetCellData(Cell.X & FGAGridChunk::SizeMask, Cell.Y & FGAGridChunk::SizeMask);
+	}
+
 	// Return the traversable neighbors of a given cell
 	// There are a max of 8. 
 	// Return value is the number of valid neighbors
 	void GetNeighbors(const FCellRef& Cell, bool OnlyTraversable, TArray<FCellRef>& Neighbors) const;
 
+	// Same as above, but fills a fixed-capacity inline list, so it never allocates.
+	// Prefer this one in search loops.
+	void GetNeighbors(const FCellRef& Cell, bool OnlyTraversable, FCellNeighbors& Neighbors) const;
+
+	// The eight neighbor offsets, in the order used by the neighbor mask bits
+	// (row by row: (-1, -1), (0, -1), (1, -1), (-1, 0), (1, 0), (-1, 1), (0, 1), (1, 1))
+	static const FIntPoint NeighborOffsets[8];
+
+	// Return a bitmask of the neighbors of the given cell. Bit N refers to NeighborOffsets[N].
+	// If OnlyTraversable is true, only neighbors that are traversable are set, otherwise all neighbors
+	// that are on the grid are set.
+	uint8 GetNeighborMask(const FCellRef& Cell, bool OnlyTraversable = true) const;
+
+	// Return the mask bit of the neighbor that lies closest to the given direction (in grid space)
+	static int32 GetNeighborIndexForDirection(const FVector2D& GridDirection);
+
+	// Return the neighbor of Cell that corresponds to the given mask bit
+	static FORCEINLINE FCellRef GetNeighborCell(const FCellRef& Cell, int32 NeighborIndex)
+	{
+		return FCellRef(Cell.X + NeighborOffsets[NeighborIndex].X, Cell.Y + NeighborOffsets[NeighborIndex].Y);
+	}
+
 	// Transform a world-space position into normalized grid space
 	// Normalized grid space is the space in which a cell is 1.0 units wide
 	void TransformPointToNormalizedGridSpace(const FVector& WorldPosition, FVector2D& UniformGridSpacePosition) const;
 
 	void TransformNormalizedGridSpaceToWorld(const FVector2D& UniformGridSpacePosition, FVector& WorldPosition) const;
 
+	// The cached affine mapping behind all of the above
+	const FGAGridAffine& GetGridAffine() const;
+
+	// Batch versions of GetCellRef and GetCellPosition. These process four entries at a time with SIMD.
+	// The output view must be the same length as the input.
+	void GetCellRefs(TConstArrayView<FVector> Points, TArrayView<FCellRef> CellsOut, bool bClamp = false) const;
+	void GetCellPositions(TConstArrayView<FCellRef> Cells, TArrayView<FVector> PositionsOut) const;
+
 	// Spatial Queries --------------------------------
 
 	// Return true if there was a hit, false if it was clear
@@ -176,12 +597,28 @@ public:
 	UFUNCTION(BlueprintCallable)
 	bool TraceLine(const FVector &Start, const FVector &End, FVector &HitLocationOut) const;
 
+	// Batch version of TraceLine, for callers with lots of rays to cast at once.
+	// Marches four rays at a time in lockstep with SIMD, reading the traversability bitset.
+	// HitsOut[i] is the result of TraceLine(Starts[i], Ends[i]). HitLocationsOut[i] is only written when HitsOut[i] is true.
+	void TraceLines(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<bool> HitsOut, TArrayView<FVector> HitLocationsOut) const;
+
+	// Like TraceLine, but for a circle of the given radius (in world units) swept along the line.
+	// Every cell the line passes through, the start cell included, needs at least Radius clearance from blocked
+	// cells, plus however far from the cell's center the line gets.
+	// This is a grid-only alternative to a physics sweep.
+	UFUNCTION(BlueprintCallable)
+	bool TraceLineWithRadius(const FVector& Start, const FVector& End, float Radius, FVector& HitLocationOut) const;
+
 
 	// Data from NavSystem --------------------------------
 
 	UFUNCTION(BlueprintCallable)
 	bool RefreshDataFromNav();
 
+	// Trace out from each traversable cell in the eight neighbor directions and record which ones have cover
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Grid")
+	bool RefreshCoverData();
+
 	// Debugging and Visualization --------------------------------
 
 	UPROPERTY(EditAnywhere)
@@ -194,13 +631,50 @@ public:
 	UPROPERTY(EditAnywhere)
 	float DebugMeshZOffset;
 
+	// How the debug mesh is built
+	UPROPERTY(EditAnywhere)
+	EGADebugMeshMode DebugMeshMode;
+
+	// Cells per side of each quad in TileQuads mode
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "1"))
+	int32 DebugMeshTileSize;
+
+	// Bumped every time we start building a debug mesh, so that stale builds can be dropped
+	int32 DebugMeshBuildSerial;
+
 	UPROPERTY(EditAnywhere)
 	TObjectPtr<UMaterialInterface> DebugMaterial;
 
+	// Rebuild the debug mesh. The mesh itself is generated on a worker thread and handed to
+	// DebugMeshComponent when it's ready (usually a frame or so later).
 	UFUNCTION(BlueprintCallable)
 	bool RefreshDebugMesh();
 
+	// Bring the debug texture up to date with DebugGridMap and the cells. The texels are filled in on a worker thread
+	// from a snapshot of DebugGridMap, and uploaded when they're ready (usually a frame or so later).
 	UFUNCTION(BlueprintCallable)
 	bool RefreshDebugTexture();
 
+	// The debug texture and material instance are created once and then updated in place
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> DebugTexture;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMaterialInstanceDynamic> DebugMaterialInstance;
+
+	// CPU-side copy of what's in DebugTexture, so we can tell which texels actually changed
+	TArray<FColor> DebugTextureBuffer;
+
+	// What DebugTextureBuffer was last built from. If none of these change, only DebugGridMap's dirty cells need redoing.
+	int32 DebugTextureGridVersion;
+	float DebugTextureValueScale;
+	FGridBox DebugTextureMapBounds;
+
+	// Traversability as of DebugTextureGridVersion, laid out like TraversableBits, for the fills to read
+	TSharedPtr<const TArray<uint64>, ESPMode::ThreadSafe> DebugTextureTraversableBits;
+
+	// Set while a fill is running (it has DebugTextureBuffer), and if RefreshDebugTexture was called meanwhile
+	bool bDebugTextureFillInFlight;
+	bool bDebugTextureRefreshPending;
+
 };
\ No newline at end of file
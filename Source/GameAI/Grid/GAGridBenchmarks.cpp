@@ -0,0 +1,467 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "GAGridActor.h"
+#include "GAGridMap.h"
+#include "GAGridMapOps.h"
+#include "GAGridMapPool.h"
+#include "GATypedGridMap.h"
+#include "GASummedAreaTable.h"
+#include "GAGridDiffusion.h"
+
+// Developer-only timing commands for the grid code. Results go to the log.
+
+#if !UE_BUILD_SHIPPING
+
+namespace GAGridBenchmarks
+{
+	// Run Body Iterations times and return the average number of seconds per run
+	template<typename BodyType>
+	double TimeIt(int32 Iterations, BodyType Body)
+	{
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			Body();
+		}
+		return (FPlatformTime::Seconds() - StartTime) / double(Iterations);
+	}
+
+
+	// Fill an N x N grid with randomly placed blocked cells
+	AGAGridActor* SpawnRandomGrid(UWorld* World, int32 Size, float BlockedFraction)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+
+		AGAGridActor* Grid = World->SpawnActor<AGAGridActor>(SpawnParameters);
+		if (Grid)
+		{
+			Grid->SetDimensions(Size, Size);
+
+			FRandomStream Random(1234);
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					FCellRef Cell(X, Y);
+					Grid->Data[Grid->CellRefToIndex(Cell)] = (Random.FRand() < BlockedFraction) ? ECellData::CellDataNone : ECellData::CellDataTraversable;
+				}
+			}
+
+			Grid->RefreshCachedCellData();
+		}
+
+		return Grid;
+	}
+
+
+	// Cell-space Dijkstra over the whole grid from the center. Returns the number of cells expanded.
+	int32 FloodFill(const AGAGridActor* Grid, FGAGridMap& DistanceMap)
+	{
+		struct FEntry
+		{
+			float Distance;
+			FCellRef Cell;
+
+			bool operator<(const FEntry& Other) const { return Distance < Other.Distance; }
+		};
+
+		TArray<FEntry> Heap;
+		FCellNeighbors Neighbors;
+		int32 Expanded = 0;
+
+		FCellRef Start(Grid->XCount / 2, Grid->YCount / 2);
+		DistanceMap.ResetData(FLT_MAX);
+		DistanceMap.SetValue(Start, 0.0f);
+		Heap.HeapPush({ 0.0f, Start });
+
+		while (Heap.Num() > 0)
+		{
+			FEntry Current;
+			Heap.HeapPop(Current, EAllowShrinking::No);
+
+			float CurrentDistance;
+			DistanceMap.GetValue(Current.Cell, CurrentDistance);
+			if (Current.Distance > CurrentDistance)
+			{
+				continue;
+			}
+
+			Expanded++;
+			Grid->GetNeighbors(Current.Cell, true, Neighbors);
+
+			for (const FCellRef& NCell : Neighbors)
+			{
+				float StepDistance = ((NCell.X != Current.Cell.X) && (NCell.Y != Current.Cell.Y)) ? UE_SQRT_2 : 1.0f;
+				float NewDistance = Current.Distance + StepDistance;
+
+				float NDistance;
+				DistanceMap.GetValue(NCell, NDistance);
+				if (NewDistance < NDistance)
+				{
+					DistanceMap.SetValue(NCell, NewDistance);
+					Heap.HeapPush({ NewDistance, NCell });
+				}
+			}
+		}
+
+		return Expanded;
+	}
+
+
+	void BenchmarkLayout(const TArray<FString>& Args, UWorld* World)
+	{
+		int32 Size = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 1024;
+		if (!World || (Size < 3))
+		{
+			return;
+		}
+
+		// 3x3 box filter over a full map -- the same access pattern as the occupancy map diffusion
+		FGAGridMap Source(Size, Size, 1.0f);
+		FGAGridMap Dest(Size, Size, 0.0f);
+		const int32 StencilIterations = 10;
+
+		double StencilSeconds = TimeIt(StencilIterations, [&]()
+		{
+			for (int32 Y = 1; Y < Size - 1; Y++)
+			{
+				for (int32 X = 1; X < Size - 1; X++)
+				{
+					float Sum = 0.0f;
+					for (int32 DY = -1; DY <= 1; DY++)
+					{
+						for (int32 DX = -1; DX <= 1; DX++)
+						{
+							Sum += Source.Data[Source.LocalToIndex(X + DX, Y + DY)];
+						}
+					}
+					Dest.Data[Dest.LocalToIndex(X, Y)] = Sum * (1.0f / 9.0f);
+				}
+			}
+		});
+
+		// Whole-grid search with 20% of the cells blocked
+		double SearchSeconds = 0.0;
+		int32 Expanded = 0;
+
+		AGAGridActor* Grid = SpawnRandomGrid(World, Size, 0.2f);
+		if (Grid)
+		{
+			FGAGridMap DistanceMap(Size, Size, FLT_MAX);
+			SearchSeconds = TimeIt(3, [&]()
+			{
+				Expanded = FloodFill(Grid, DistanceMap);
+			});
+			Grid->Destroy();
+		}
+
+		double StencilCells = double(Size - 2) * double(Size - 2);
+
+		UE_LOG(LogTemp, Display, TEXT("Grid layout %s, %d x %d: stencil %.2f ms (%.1f Mcells/s), search %.2f ms (%d cells, %.1f Mcells/s)"),
+			GAGridLayout::GetLayoutName(), Size, Size,
+			StencilSeconds * 1000.0, StencilCells / StencilSeconds * 1e-6,
+			SearchSeconds * 1000.0, Expanded, (SearchSeconds > 0.0) ? double(Expanded) / SearchSeconds * 1e-6 : 0.0);
+	}
+
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkLayoutCommand(
+		TEXT("GameAI.Grid.BenchmarkLayout"),
+		TEXT("Time a 3x3 stencil and a whole-grid Dijkstra on an N x N grid (default 1024) using the compiled-in grid layout. ")
+		TEXT("Rebuild with a different GA_GRID_LAYOUT to compare layouts."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkLayout));
+
+	// Per-cell GetValue / SetValue loops, the way callers wrote these before GAGridMapOps, vs. the library versions
+	void BenchmarkMapOps(const TArray<FString>& Args, UWorld* World)
+	{
+		int32 Size = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 1024;
+		if (Size < 1)
+		{
+			return;
+		}
+
+		FGAGridMap A(Size, Size, 1.0f);
+		FGAGridMap B(Size, Size, 2.0f);
+		const int32 Iterations = 20;
+		double Cells = double(Size) * double(Size);
+
+		FRandomStream Random(1234);
+		for (float& Value : A.Data)
+		{
+			Value = Random.FRand();
+		}
+
+		auto ForEachCell = [&](auto Body)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					Body(FCellRef(X, Y));
+				}
+			}
+		};
+
+		auto Report = [&](const TCHAR* Name, double CellCount, double ScalarSeconds, double OpsSeconds)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %-10s scalar %7.3f ms, ops %7.3f ms (%.1f Mcells/s, %.1fx)"),
+				Name, ScalarSeconds * 1000.0, OpsSeconds * 1000.0, CellCount / OpsSeconds * 1e-6, ScalarSeconds / OpsSeconds);
+		};
+
+		UE_LOG(LogTemp, Display, TEXT("Grid map ops, layout %s, %d x %d:"), GAGridLayout::GetLayoutName(), Size, Size);
+
+		Report(TEXT("Fill"), Cells,
+			TimeIt(Iterations, [&]() { ForEachCell([&](const FCellRef& Cell) { B.SetValue(Cell, 0.5f); }); }),
+			TimeIt(Iterations, [&]() { GAGridMapOps::Fill(B, 0.5f); }));
+
+		Report(TEXT("Add"), Cells,
+			TimeIt(Iterations, [&]() { ForEachCell([&](const FCellRef& Cell) { float VA, VB; A.GetValue(Cell, VA); B.GetValue(Cell, VB); B.SetValue(Cell, VA + VB); }); }),
+			TimeIt(Iterations, [&]() { GAGridMapOps::Add(B, A); }));
+
+		// Offset bounds: a quarter-size map in the middle, which is the general (per-row) path
+		FGAGridMap Inner(Size, Size, 0.0f);
+		Inner.GridBounds = FGridBox(Size / 4, (3 * Size) / 4, Size / 4, (3 * Size) / 4);
+		Inner.ResetData(1.0f);
+		Report(TEXT("AddOffset"), double(Inner.GridBounds.GetCellCount()),
+			TimeIt(Iterations, [&]() { for (int32 Y = Inner.GridBounds.MinY; Y <= Inner.GridBounds.MaxY; Y++) for (int32 X = Inner.GridBounds.MinX; X <= Inner.GridBounds.MaxX; X++) { FCellRef Cell(X, Y); float VA, VB; Inner.GetValue(Cell, VA); B.GetValue(Cell, VB); B.SetValue(Cell, VA + VB); } }),
+			TimeIt(Iterations, [&]() { GAGridMapOps::Add(B, Inner); })));
+
+		Report(TEXT("ScaleBias"), Cells,
+			TimeIt(Iterations, [&]() { ForEachCell([&](const FCellRef& Cell) { float V; B.GetValue(Cell, V); B.SetValue(Cell, V * 0.5f + 0.25f); }); }),
+			TimeIt(Iterations, [&]() { GAGridMapOps::ScaleBias(B, 0.5f, 0.25f); }));
+
+		Report(TEXT("Clamp"), Cells,
+			TimeIt(Iterations, [&]() { ForEachCell([&](const FCellRef& Cell) { float V; B.GetValue(Cell, V); B.SetValue(Cell, FMath::Clamp(V, 0.2f, 0.8f)); }); }),
+			TimeIt(Iterations, [&]() { GAGridMapOps::Clamp(B, 0.2f, 0.8f); }));
+
+		float Sink = 0.0f;
+		FCellRef SinkCell;
+
+		Report(TEXT("ArgMax"), Cells,
+			TimeIt(Iterations, [&]() { float Best = -FLT_MAX; ForEachCell([&](const FCellRef& Cell) { float V; A.GetValue(Cell, V); if (V > Best) { Best = V; SinkCell = Cell; } }); Sink += Best; }),
+			TimeIt(Iterations, [&]() { float Best; GAGridMapOps::ArgMax(A, SinkCell, Best); Sink += Best; }));
+
+		Report(TEXT("Normalize"), Cells,
+			TimeIt(Iterations, [&]()
+			{
+				float MinValue = FLT_MAX, MaxValue = -FLT_MAX;
+				ForEachCell([&](const FCellRef& Cell) { float V; B.GetValue(Cell, V); MinValue = FMath::Min(MinValue, V); MaxValue = FMath::Max(MaxValue, V); });
+				ForEachCell([&](const FCellRef& Cell) { float V; B.GetValue(Cell, V); B.SetValue(Cell, (MaxValue > MinValue) ? (V - MinValue) / (MaxValue - MinValue) : 0.0f); });
+			}),
+			TimeIt(Iterations, [&]() { GAGridMapOps::Normalize(B); }));
+
+		// Keep the reductions from being optimized away
+		UE_LOG(LogTemp, Verbose, TEXT("  (%f, %d %d)"), Sink, SinkCell.X, SinkCell.Y);
+	}
+
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkMapOpsCommand(
+		TEXT("GameAI.Grid.BenchmarkMapOps"),
+		TEXT("Time the GAGridMapOps operations against plain per-cell loops on an N x N map (default 1024)."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkMapOps));
+
+
+	// Windowed sums around every cell: a plain loop over each window vs. building a summed-area table and querying it
+	void BenchmarkWindowSums(const TArray<FString>& Args, UWorld* World)
+	{
+		int32 Size = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 512;
+		int32 Radius = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 5;
+		if ((Size < 1) || (Radius < 0))
+		{
+			return;
+		}
+
+		FGAGridMap Source(Size, Size, 0.0f);
+		FGAGridMap Result(Size, Size, 0.0f);
+		const int32 Iterations = 5;
+		double Cells = double(Size) * double(Size);
+
+		FRandomStream Random(1234);
+		for (float& Value : Source.Data)
+		{
+			Value = Random.FRand();
+		}
+
+		double ScalarSeconds = TimeIt(Iterations, [&]()
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const FGridBox Window = FGASummedAreaTable::GetWindow(X, Y, Radius).GetOverlap(Source.GridBounds);
+					double Sum = 0.0;
+					for (int32 WindowY = Window.MinY; WindowY <= Window.MaxY; WindowY++)
+					{
+						for (int32 WindowX = Window.MinX; WindowX <= Window.MaxX; WindowX++)
+						{
+							Sum += Source.GetValueUnchecked(WindowX, WindowY);
+						}
+					}
+					Result.SetValueUnchecked(X, Y, float(Sum));
+				}
+			}
+		});
+
+		FGASummedAreaTable Table;
+		double BuildSeconds = TimeIt(Iterations, [&]() { Table.Build(Source); });
+		double QuerySeconds = TimeIt(Iterations, [&]()
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					Result.SetValueUnchecked(X, Y, float(Table.GetSum(FGASummedAreaTable::GetWindow(X, Y, Radius))));
+				}
+			}
+		});
+
+		UE_LOG(LogTemp, Display, TEXT("Window sums, %d x %d, radius %d: scalar %.2f ms, table build %.2f ms + queries %.2f ms (%.1f Mcells/s, %.1fx)"),
+			Size, Size, Radius, ScalarSeconds * 1000.0, BuildSeconds * 1000.0, QuerySeconds * 1000.0,
+			Cells / (BuildSeconds + QuerySeconds) * 1e-6, ScalarSeconds / (BuildSeconds + QuerySeconds));
+	}
+
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkWindowSumsCommand(
+		TEXT("GameAI.Grid.BenchmarkWindowSums"),
+		TEXT("Time windowed sums around every cell of an N x N map (default 512) with radius R (default 5), per-window loops vs. a summed-area table."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkWindowSums));
+
+
+	// The occupancy map diffusion (20 steps of the 3x3 stencil, i.e. one frame's worth) at a few map sizes: the old
+	// in-place loop through GetValue / SetValue vs. FGAGridDiffusion, in float and the compact precisions
+	void BenchmarkDiffusion(const TArray<FString>& Args, UWorld* World)
+	{
+		TArray<int32> Sizes;
+		for (const FString& Arg : Args)
+		{
+			Sizes.Add(FCString::Atoi(*Arg));
+		}
+		if (Sizes.Num() == 0)
+		{
+			Sizes = { 100, 512, 2048 };
+		}
+
+		const int32 Steps = 20;
+		const float DiffusionFactor = 0.4f;
+
+		UE_LOG(LogTemp, Display, TEXT("Occupancy diffusion, %d steps per frame, layout %s:"), Steps, GAGridLayout::GetLayoutName());
+
+		for (int32 Size : Sizes)
+		{
+			if (Size < 1)
+			{
+				continue;
+			}
+
+			AGAGridActor* Grid = SpawnRandomGrid(World, Size, 0.2f);
+			if (!Grid)
+			{
+				continue;
+			}
+
+			FGAGridMap Map(Grid, 0.0f);
+			Map.SetValue(FCellRef(Size / 2, Size / 2), 1.0f);
+			const int32 Frames = (Size > 1024) ? 2 : 10;
+			double Cells = double(Size) * double(Size) * double(Steps);
+
+			double ScalarSeconds = TimeIt(Frames, [&]()
+			{
+				for (int32 Step = 0; Step < Steps; Step++)
+				{
+					for (int32 X = 0; X < Size; X++)
+					{
+						for (int32 Y = 0; Y < Size; Y++)
+						{
+							float Total = 0.0f;
+							int32 Count = 0;
+							for (int32 DX = -1; DX <= 1; DX++)
+							{
+								for (int32 DY = -1; DY <= 1; DY++)
+								{
+									float Value;
+									if (Map.GetValue(FCellRef(X + DX, Y + DY), Value))
+									{
+										Total += Value;
+										Count++;
+									}
+								}
+							}
+							float Current;
+							Map.GetValue(FCellRef(X, Y), Current);
+							Map.SetValue(FCellRef(X, Y), (1.0f - DiffusionFactor) * Current + (DiffusionFactor / Count) * Total);
+						}
+					}
+				}
+			});
+
+			FGAGridDiffusion Diffusion;
+			double PrepareSeconds = TimeIt(1, [&]() { Diffusion.Prepare(Grid, Map.GridBounds, DiffusionFactor); });
+			double DiffusionSeconds = TimeIt(Frames, [&]() { Diffusion.Diffuse(Map, Steps); });
+
+			// The first frame after the target is seen: one non-zero cell, so only the box it can spread to is touched
+			double ActiveBoxSeconds = TimeIt(Frames, [&]()
+			{
+				GAGridMapOps::Fill(Map, 0.0f);
+				Map.SetValue(FCellRef(Size / 2, Size / 2), 1.0f);
+				FGridBox ActiveBox(Size / 2, Size / 2, Size / 2, Size / 2);
+				Diffusion.Diffuse(Map, Steps, ActiveBox, 1e-6f);
+			});
+
+			// The closed-form blur over the whole map, at the radius that spreads about as far as the steps above do
+			// (each step adds roughly Factor * 2/3 cells squared of variance per axis), and at a much bigger one,
+			// which should cost the same
+			const int32 BlurRadius = FMath::Max(FGAGridDiffusion::GetBlurRadius(Steps * DiffusionFactor * 2.0f / 3.0f), 1);
+			FGridBox BlurBox;
+			double BlurSeconds = TimeIt(Frames, [&]() { BlurBox = Map.GridBounds; Diffusion.Blur(Map, BlurRadius, BlurBox, -1.0f); });
+			double WideBlurSeconds = TimeIt(Frames, [&]() { BlurBox = Map.GridBounds; Diffusion.Blur(Map, 8 * BlurRadius, BlurBox, -1.0f); });
+
+			// The compact precisions, on the same mask
+			TGAGridMap<FFloat16> HalfMap(Map);
+			TGAGridMap<uint8> Unorm8Map(Map);
+			double HalfSeconds = TimeIt(Frames, [&]() { Diffusion.Diffuse(HalfMap, Steps); });
+			double Unorm8Seconds = TimeIt(Frames, [&]() { Diffusion.Diffuse(Unorm8Map, Steps); });
+
+			UE_LOG(LogTemp, Display, TEXT("  %4d x %-4d scalar %8.3f ms/frame (%6.1f Mcells/s), diffusion %7.3f ms/frame (%7.1f Mcells/s, %.1fx), ")
+				TEXT("from one cell %7.3f ms/frame, prepare %.3f ms, blur r%d %7.3f ms, r%d %7.3f ms, half %7.3f ms/frame, unorm8 %7.3f ms/frame"),
+				Size, Size, ScalarSeconds * 1000.0, Cells / ScalarSeconds * 1e-6, DiffusionSeconds * 1000.0, Cells / DiffusionSeconds * 1e-6,
+				ScalarSeconds / DiffusionSeconds, ActiveBoxSeconds * 1000.0, PrepareSeconds * 1000.0,
+				BlurRadius, BlurSeconds * 1000.0, 8 * BlurRadius, WideBlurSeconds * 1000.0, HalfSeconds * 1000.0, Unorm8Seconds * 1000.0);
+
+			Grid->Destroy();
+		}
+	}
+
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkDiffusionCommand(
+		TEXT("GameAI.Grid.BenchmarkDiffusion"),
+		TEXT("Time one frame of occupancy map diffusion (20 steps) on N x N grids with 20% of the cells blocked, ")
+		TEXT("per-cell in place vs. FGAGridDiffusion. Sizes default to 100 512 2048."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkDiffusion));
+
+
+	// How well the transient map pools are doing. Allocations should stop climbing once the game is warmed up.
+	template<typename ValueType>
+	void ReportPool(const TCHAR* Name)
+	{
+		const TGAGridMapBufferPool<ValueType>& Pool = TGAGridMapBufferPool<ValueType>::Get();
+		UE_LOG(LogTemp, Log, TEXT("  %-8s %8d allocations %10d reuses %10.1f KB pooled"),
+			Name, Pool.GetAllocationCount(), Pool.GetReuseCount(), double(Pool.GetPooledSize()) / 1024.0);
+	}
+
+	void MapPoolStats()
+	{
+		UE_LOG(LogTemp, Log, TEXT("Grid map pools:"));
+		ReportPool<float>(TEXT("float"));
+		ReportPool<FFloat16>(TEXT("half"));
+		ReportPool<uint16>(TEXT("unorm16"));
+		ReportPool<uint8>(TEXT("unorm8"));
+	}
+
+	static FAutoConsoleCommand MapPoolStatsCommand(
+		TEXT("GameAI.Grid.MapPoolStats"),
+		TEXT("Log allocation and reuse counts for the transient grid map pools."),
+		FConsoleCommandDelegate::CreateStatic(&MapPoolStats));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,38 @@
+#include "GAGridChunkActor.h"
+
+#include "Components/SceneComponent.h"
+
+
+AGAGridChunkActor::AGAGridChunkActor(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	PrimaryActorTick.bCanEverTick = false;
+	SetActorEnableCollision(false);
+}
+
+
+void AGAGridChunkActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Note, if the grid isn't around yet, it will pick us up in its own BeginPlay
+	AGAGridActor* Grid = GridActor.Get();
+	if (Grid)
+	{
+		Grid->LoadChunk(ChunkCoord, Chunk);
+	}
+}
+
+
+void AGAGridChunkActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AGAGridActor* Grid = GridActor.Get();
+	if (Grid)
+	{
+		Grid->UnloadChunk(ChunkCoord);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
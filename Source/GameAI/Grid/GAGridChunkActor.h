@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridActor.h"
+#include "GAGridChunkActor.generated.h"
+
+
+// Holds the data for one chunk of an AGAGridActor that uses chunked storage.
+// These are placed at the chunk's location (see AGAGridActor::CreateChunkActors), so World Partition
+// streams them in and out like any other spatially-loaded actor. When one begins play it hands its chunk to
+// the grid, and when it ends play the chunk goes back to being unloaded.
+
+UCLASS()
+class AGAGridChunkActor : public AActor
+{
+	GENERATED_UCLASS_BODY()
+
+	// The grid I belong to
+	UPROPERTY(VisibleAnywhere)
+	TSoftObjectPtr<AGAGridActor> GridActor;
+
+	// Which chunk of the grid I hold
+	UPROPERTY(VisibleAnywhere)
+	FIntPoint ChunkCoord;
+
+	UPROPERTY()
+	FGAGridChunk Chunk;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
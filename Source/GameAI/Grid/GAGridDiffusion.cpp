@@ -0,0 +1,586 @@
+#include "GAGridDiffusion.h"
+#include "GAGridActor.h"
+#include "GATypedGridMap.h"
+#include "GAGridMapPool.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+
+// One row of a step: Dest[X] = Keep[X] * Middle[X] + Spread[X] * (sum of the 3x3 block around X).
+// Above and Below are the neighboring rows of the source. ColumnSums needs Width + 2 floats.
+static FORCEINLINE void DiffuseRow(const float* Above, const float* Middle, const float* Below, const float* Keep, const float* Spread, float* ColumnSums, float* Dest, int32 Width)
+{
+	// Sum down each column first, with a zero either side so the first and last cells need no special case
+	ColumnSums[0] = 0.0f;
+	ColumnSums[Width + 1] = 0.0f;
+	float* Sums = ColumnSums + 1;
+
+	int32 X = 0;
+	for (; X + 4 <= Width; X += 4)
+	{
+		VectorStore(VectorAdd(VectorAdd(VectorLoad(Above + X), VectorLoad(Middle + X)), VectorLoad(Below + X)), Sums + X);
+	}
+	for (; X < Width; X++)
+	{
+		Sums[X] = Above[X] + Middle[X] + Below[X];
+	}
+
+	// Then each cell's block sum is three neighboring column sums
+	X = 0;
+	for (; X + 4 <= Width; X += 4)
+	{
+		VectorRegister4Float BlockSum = VectorAdd(VectorAdd(VectorLoad(Sums + X - 1), VectorLoad(Sums + X)), VectorLoad(Sums + X + 1));
+		VectorStore(VectorMultiplyAdd(VectorLoad(Keep + X), VectorLoad(Middle + X), VectorMultiply(VectorLoad(Spread + X), BlockSum)), Dest + X);
+	}
+	for (; X < Width; X++)
+	{
+		Dest[X] = Keep[X] * Middle[X] + Spread[X] * (Sums[X - 1] + Sums[X] + Sums[X + 1]);
+	}
+}
+
+
+// One box filter pass along a line of cells (a row, or a column with Stride = the row width).
+// Writes Dest over [OutBegin, OutEnd]. Source is only read over [InBegin, InEnd]; everything else on the line counts
+// as 0. Each open cell gets the average of the open cells within Radius of it that aren't cut off from it by a
+// blocked cell; blocked cells get 0. The running sum makes the cost per cell the same for any Radius.
+static void BoxFilterLine(const float* Source, float* Dest, const uint8* Open, int32 Stride, int32 LineLength,
+	int32 InBegin, int32 InEnd, int32 OutBegin, int32 OutEnd, int32 Radius, TArray<double>& Prefix, TArray<int32>& RunEnd)
+{
+	// The stretch of the line the outputs can see. Indices below are relative to First.
+	const int32 First = FMath::Max(OutBegin - Radius, 0);
+	const int32 Last = FMath::Min(OutEnd + Radius, LineLength - 1);
+	const int32 Count = Last - First + 1;
+
+	// Prefix[I] is the sum of the first I source values. (Doubles, so small values survive next to big ones.)
+	Prefix.SetNumUninitialized(Count + 1, EAllowShrinking::No);
+	Prefix[0] = 0.0;
+	for (int32 I = 0; I < Count; I++)
+	{
+		const int32 Index = First + I;
+		const float Value = ((Index >= InBegin) && (Index <= InEnd)) ? Source[Index * Stride] : 0.0f;
+		Prefix[I + 1] = Prefix[I] + Value;
+	}
+
+	// The last open cell of the run each cell is in
+	RunEnd.SetNumUninitialized(Count, EAllowShrinking::No);
+	int32 End = Count - 1;
+	for (int32 I = Count - 1; I >= 0; I--)
+	{
+		if (!Open[(First + I) * Stride])
+		{
+			End = I - 1;
+		}
+		RunEnd[I] = End;
+	}
+
+	int32 RunStart = 0;
+	for (int32 I = 0; I < Count; I++)
+	{
+		const int32 Index = First + I;
+		const bool bOpen = Open[Index * Stride] != 0;
+		if (!bOpen)
+		{
+			RunStart = I + 1;
+		}
+
+		if ((Index >= OutBegin) && (Index <= OutEnd))
+		{
+			if (bOpen)
+			{
+				const int32 Lo = FMath::Max(RunStart, I - Radius);
+				const int32 Hi = FMath::Min(RunEnd[I], I + Radius);
+				Dest[Index * Stride] = float((Prefix[Hi + 1] - Prefix[Lo]) / double(Hi - Lo + 1));
+			}
+			else
+			{
+				Dest[Index * Stride] = 0.0f;
+			}
+		}
+	}
+}
+
+
+// Box grown by Amount cells on every side
+static FORCEINLINE FGridBox GrowBox(const FGridBox& Box, int32 Amount)
+{
+	return FGridBox(Box.MinX - Amount, Box.MaxX + Amount, Box.MinY - Amount, Box.MaxY + Amount);
+}
+
+void FGAGridDiffusion::Reset()
+{
+	PreparedGrid = FObjectKey();
+	PreparedGridVersion = INDEX_NONE;
+	PreparedBounds = FGridBox();
+	PreparedFactor = -1.0f;
+	Width = 0;
+	Height = 0;
+	Open.Empty();
+	Keep.Empty();
+	Spread.Empty();
+	BufferA.Empty();
+	BufferB.Empty();
+	ZeroRow.Empty();
+	Scratch.Empty();
+	BlurPrefix.Empty();
+	BlurRunEnd.Empty();
+}
+
+void FGAGridDiffusion::Prepare(const AGAGridActor* Grid, const FGridBox& Bounds, float DiffusionFactor, bool bRespectTraversability)
+{
+	if (!Grid || !Bounds.IsValid())
+	{
+		Reset();
+		return;
+	}
+
+	const bool bSameSetup = (PreparedGrid == FObjectKey(Grid)) && (PreparedBounds == Bounds) && (PreparedFactor == DiffusionFactor) &&
+		(bPreparedRespectTraversability == bRespectTraversability) && (Keep.Num() == Width * Height) && (Width > 0);
+	if (bSameSetup && (PreparedGridVersion == Grid->GetGridVersion()))
+	{
+		return;
+	}
+
+	if (bSameSetup)
+	{
+		// Only the grid's cells changed. Redo the chunks they changed in, which for something like a door or a crate
+		// moving about is a chunk or two rather than the whole map.
+		TArray<FGridBox, TInlineAllocator<8>> ChangedBoxes;
+		if (bRespectTraversability)
+		{
+			for (int32 ChunkY = Bounds.MinY >> FGAGridChunk::SizeShift; ChunkY <= (Bounds.MaxY >> FGAGridChunk::SizeShift); ChunkY++)
+			{
+				for (int32 ChunkX = Bounds.MinX >> FGAGridChunk::SizeShift; ChunkX <= (Bounds.MaxX >> FGAGridChunk::SizeShift); ChunkX++)
+				{
+					if (Grid->GetChunkVersion(FIntPoint(ChunkX, ChunkY)) > PreparedGridVersion)
+					{
+						const FGridBox ChunkBox(ChunkX << FGAGridChunk::SizeShift, ((ChunkX + 1) << FGAGridChunk::SizeShift) - 1,
+							ChunkY << FGAGridChunk::SizeShift, ((ChunkY + 1) << FGAGridChunk::SizeShift) - 1);
+						const FGridBox Overlap = ChunkBox.GetOverlap(Bounds);
+						if (Overlap.IsValid())
+						{
+							ChangedBoxes.Add(FGridBox(Overlap.MinX - Bounds.MinX, Overlap.MaxX - Bounds.MinX, Overlap.MinY - Bounds.MinY, Overlap.MaxY - Bounds.MinY));
+						}
+					}
+				}
+			}
+		}
+
+		PreparedGridVersion = Grid->GetGridVersion();
+
+		// The mask first, as a cell's coefficients depend on its neighbors' mask
+		for (const FGridBox& Box : ChangedBoxes)
+		{
+			BuildOpen(Grid, Box);
+		}
+		for (const FGridBox& Box : ChangedBoxes)
+		{
+			BuildCoefficients(GrowBox(Box, 1).GetOverlap(FGridBox(0, Width - 1, 0, Height - 1)));
+		}
+		return;
+	}
+
+	PreparedGrid = FObjectKey(Grid);
+	PreparedGridVersion = Grid->GetGridVersion();
+	PreparedBounds = Bounds;
+	PreparedFactor = DiffusionFactor;
+	bPreparedRespectTraversability = bRespectTraversability;
+
+	Width = Bounds.GetWidth();
+	Height = Bounds.GetHeight();
+	const int32 CellCount = Width * Height;
+	const FGridBox LocalBounds(0, Width - 1, 0, Height - 1);
+
+	Open.SetNumUninitialized(CellCount);
+	BuildOpen(Grid, LocalBounds);
+
+	Keep.SetNumUninitialized(CellCount);
+	Spread.SetNumUninitialized(CellCount);
+	BuildCoefficients(LocalBounds);
+
+	ZeroRow.SetNumZeroed(Width);
+
+	const int32 BandCount = (FMath::Max(Height - 2, 0) + BandHeight - 1) / BandHeight;
+	Scratch.SetNumUninitialized((BandCount + 1) * (Width + 2));
+}
+
+void FGAGridDiffusion::BuildOpen(const AGAGridActor* Grid, const FGridBox& Box)
+{
+	ParallelFor(Box.GetHeight(), [&](int32 Row)
+	{
+		const int32 Y = Box.MinY + Row;
+		for (int32 X = Box.MinX; X <= Box.MaxX; X++)
+		{
+			Open[Y * Width + X] = (!bPreparedRespectTraversability || Grid->IsCellTraversable(FCellRef(PreparedBounds.MinX + X, PreparedBounds.MinY + Y))) ? 1 : 0;
+		}
+	}, (Box.GetCellCount() < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void FGAGridDiffusion::BuildCoefficients(const FGridBox& Box)
+{
+	ParallelFor(Box.GetHeight(), [&](int32 Row)
+	{
+		const int32 Y = Box.MinY + Row;
+		for (int32 X = Box.MinX; X <= Box.MaxX; X++)
+		{
+			const int32 Index = Y * Width + X;
+			if (!Open[Index])
+			{
+				Keep[Index] = 0.0f;
+				Spread[Index] = 0.0f;
+				continue;
+			}
+
+			// Always at least 1, the cell itself
+			int32 OpenCount = 0;
+			for (int32 NeighborY = FMath::Max(Y - 1, 0); NeighborY <= FMath::Min(Y + 1, Height - 1); NeighborY++)
+			{
+				for (int32 NeighborX = FMath::Max(X - 1, 0); NeighborX <= FMath::Min(X + 1, Width - 1); NeighborX++)
+				{
+					OpenCount += Open[NeighborY * Width + NeighborX];
+				}
+			}
+
+			Keep[Index] = 1.0f - PreparedFactor;
+			Spread[Index] = PreparedFactor / float(OpenCount);
+		}
+	}, (Box.GetCellCount() < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+bool FGAGridDiffusion::IsPreparedFor(const FGAGridMap& Map) const
+{
+	return Map.IsValid() && (Map.GridBounds == PreparedBounds) && (Width > 0) && (Keep.Num() == Width * Height);
+}
+
+void FGAGridDiffusion::FinishActiveBox(FGAGridMap& Map, const FGridBox& ChangedBox, float NegligibleValue, FGridBox& ActiveBox)
+{
+	Map.MarkDirty(ChangedBox);
+	ActiveBox = ChangedBox;
+
+	if (NegligibleValue >= 0.0f)
+	{
+		// Shrink the box to the cells that still matter, and zero the rest so it stays true that there's
+		// nothing outside it
+		FGridBox TightBox;
+		for (int32 Y = ChangedBox.MinY; Y <= ChangedBox.MaxY; Y++)
+		{
+			for (int32 X = ChangedBox.MinX; X <= ChangedBox.MaxX; X++)
+			{
+				if (Map.GetValueUnchecked(X, Y) > NegligibleValue)
+				{
+					TightBox = TightBox.GetUnion(FGridBox(X, X, Y, Y));
+				}
+			}
+		}
+
+		if (TightBox != ChangedBox)
+		{
+			for (int32 Y = ChangedBox.MinY; Y <= ChangedBox.MaxY; Y++)
+			{
+				for (int32 X = ChangedBox.MinX; X <= ChangedBox.MaxX; X++)
+				{
+					if (!TightBox.IsValidCell(X, Y))
+					{
+						Map.SetValueUnchecked(X, Y, 0.0f);
+					}
+				}
+			}
+		}
+		ActiveBox = TightBox;
+	}
+}
+
+bool FGAGridDiffusion::Diffuse(FGAGridMap& Map, int32 Iterations)
+{
+	FGridBox ActiveBox = Map.GridBounds;
+	return Diffuse(Map, Iterations, ActiveBox, -1.0f);
+}
+
+bool FGAGridDiffusion::Diffuse(FGAGridMap& Map, int32 Iterations, FGridBox& ActiveBox, float NegligibleValue)
+{
+	if (!IsPreparedFor(Map))
+	{
+		return false;
+	}
+
+	if (Iterations <= 0)
+	{
+		return true;
+	}
+
+	// Local coordinates from here on
+	const FGridBox LocalBounds(0, Width - 1, 0, Height - 1);
+	const FGridBox& MapBounds = Map.GridBounds;
+	FGridBox Box = ActiveBox.GetOverlap(MapBounds);
+	if (!Box.IsValid())
+	{
+		// Nothing but zeros
+		ActiveBox = FGridBox();
+		return true;
+	}
+	Box = FGridBox(Box.MinX - MapBounds.MinX, Box.MaxX - MapBounds.MinX, Box.MinY - MapBounds.MinY, Box.MaxY - MapBounds.MinY);
+
+	// Every step grows the box by the stencil radius, so this is as far as anything can get
+	const FGridBox FinalBox = GrowBox(Box, Iterations).GetOverlap(LocalBounds);
+	const int32 FinalWidth = FinalBox.GetWidth();
+
+	const int32 CellCount = Width * Height;
+	BufferB.SetNumUninitialized(CellCount, EAllowShrinking::No);
+
+	// Both buffers have to match the map over FinalBox. Outside of whatever box a step works on, the steps read
+	// zeros rather than the buffers, so nothing outside FinalBox matters.
+	float* Front;
+	if constexpr (GAGridLayout::bRowsAreContiguous)
+	{
+		// The map's data is already a row-major Width x Height block, so it can be one of the buffers
+		Front = Map.Data.GetData();
+		for (int32 Y = FinalBox.MinY; Y <= FinalBox.MaxY; Y++)
+		{
+			FMemory::Memcpy(BufferB.GetData() + Y * Width + FinalBox.MinX, Front + Y * Width + FinalBox.MinX, FinalWidth * sizeof(float));
+		}
+	}
+	else
+	{
+		BufferA.SetNumUninitialized(CellCount, EAllowShrinking::No);
+		for (int32 Y = FinalBox.MinY; Y <= FinalBox.MaxY; Y++)
+		{
+			for (int32 X = FinalBox.MinX; X <= FinalBox.MaxX; X++)
+			{
+				BufferA[Y * Width + X] = BufferB[Y * Width + X] = Map.GetLocalValueUnchecked(X, Y);
+			}
+		}
+		Front = BufferA.GetData();
+	}
+	float* Back = BufferB.GetData();
+
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		Box = GrowBox(Box, 1).GetOverlap(LocalBounds);
+		Step(Front, Back, Box);
+		Swap(Front, Back);
+	}
+
+	// Front has the result
+	if constexpr (GAGridLayout::bRowsAreContiguous)
+	{
+		if (Front != Map.Data.GetData())
+		{
+			for (int32 Y = FinalBox.MinY; Y <= FinalBox.MaxY; Y++)
+			{
+				FMemory::Memcpy(Map.Data.GetData() + Y * Width + FinalBox.MinX, Front + Y * Width + FinalBox.MinX, FinalWidth * sizeof(float));
+			}
+		}
+	}
+	else
+	{
+		for (int32 Y = FinalBox.MinY; Y <= FinalBox.MaxY; Y++)
+		{
+			for (int32 X = FinalBox.MinX; X <= FinalBox.MaxX; X++)
+			{
+				Map.GetLocalValueUnchecked(X, Y) = Front[Y * Width + X];
+			}
+		}
+	}
+
+	const FGridBox ChangedBox(FinalBox.MinX + MapBounds.MinX, FinalBox.MaxX + MapBounds.MinX, FinalBox.MinY + MapBounds.MinY, FinalBox.MaxY + MapBounds.MinY);
+	FinishActiveBox(Map, ChangedBox, NegligibleValue, ActiveBox);
+	return true;
+}
+
+template<typename ValueType>
+bool FGAGridDiffusion::Diffuse(TGAGridMap<ValueType>& Map, int32 Iterations)
+{
+	typedef TGAGridMapValueTraits<ValueType> Traits;
+
+	if (!Map.IsValid() || (Map.GridBounds != PreparedBounds) || (Width <= 0) || (Keep.Num() != Width * Height))
+	{
+		return false;
+	}
+
+	// The other ping-pong buffer, in the map's own layout. Every step writes every cell, so it needs no clearing.
+	TGAScopedGridMap<TGAGridMap<ValueType>> BackMap(Map.XCount, Map.YCount, Map.GridBounds);
+	ValueType* Front = Map.Data.GetData();
+	ValueType* Back = BackMap->Data.GetData();
+
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		ParallelFor(Height, [&](int32 Y)
+		{
+			for (int32 X = 0; X < Width; X++)
+			{
+				float BlockSum = 0.0f;
+				for (int32 NeighborY = FMath::Max(Y - 1, 0); NeighborY <= FMath::Min(Y + 1, Height - 1); NeighborY++)
+				{
+					for (int32 NeighborX = FMath::Max(X - 1, 0); NeighborX <= FMath::Min(X + 1, Width - 1); NeighborX++)
+					{
+						BlockSum += Traits::Decode(Front[Map.LocalToIndex(NeighborX, NeighborY)]);
+					}
+				}
+
+				const int32 Index = Y * Width + X;
+				const int32 MapIndex = Map.LocalToIndex(X, Y);
+				Back[MapIndex] = Traits::Encode(Keep[Index] * Traits::Decode(Front[MapIndex]) + Spread[Index] * BlockSum);
+			}
+		}, (Width * Height < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		Swap(Front, Back);
+	}
+
+	if (Front != Map.Data.GetData())
+	{
+		FMemory::Memcpy(Map.Data.GetData(), Front, Map.Data.Num() * sizeof(ValueType));
+	}
+	return true;
+}
+
+template bool FGAGridDiffusion::Diffuse<FFloat16>(TGAGridMap<FFloat16>& Map, int32 Iterations);
+template bool FGAGridDiffusion::Diffuse<uint16>(TGAGridMap<uint16>& Map, int32 Iterations);
+template bool FGAGridDiffusion::Diffuse<uint8>(TGAGridMap<uint8>& Map, int32 Iterations);
+
+void FGAGridDiffusion::Step(const float* Source, float* Dest, const FGridBox& Box) const
+{
+	const int32 BoxWidth = Box.GetWidth();
+	const int32 ScratchStride = Width + 2;
+	const int32 BandCount = (FMath::Max(Box.GetHeight() - 2, 0) + BandHeight - 1) / BandHeight;
+
+	// Interior rows have a row above and below, so there's nothing to check
+	ParallelFor(BandCount, [&](int32 BandIndex)
+	{
+		float* ColumnSums = Scratch.GetData() + BandIndex * ScratchStride;
+		const int32 StartY = Box.MinY + 1 + BandIndex * BandHeight;
+		const int32 EndY = FMath::Min(StartY + BandHeight, Box.MaxY);
+		for (int32 Y = StartY; Y < EndY; Y++)
+		{
+			const int32 Offset = Y * Width + Box.MinX;
+			const float* Middle = Source + Offset;
+			DiffuseRow(Middle - Width, Middle, Middle + Width, Keep.GetData() + Offset, Spread.GetData() + Offset, ColumnSums, Dest + Offset, BoxWidth);
+		}
+	}, (Box.GetCellCount() < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Border pass: the top and bottom rows, with zeros standing in for the row outside the box
+	float* ColumnSums = Scratch.GetData() + BandCount * ScratchStride;
+	const int32 BorderRows[2] = { Box.MinY, Box.MaxY };
+	for (int32 BorderIndex = 0; BorderIndex < ((Box.MaxY > Box.MinY) ? 2 : 1); BorderIndex++)
+	{
+		const int32 Y = BorderRows[BorderIndex];
+		const int32 Offset = Y * Width + Box.MinX;
+		const float* Above = (Y > Box.MinY) ? Source + Offset - Width : ZeroRow.GetData();
+		const float* Below = (Y < Box.MaxY) ? Source + Offset + Width : ZeroRow.GetData();
+		DiffuseRow(Above, Source + Offset, Below, Keep.GetData() + Offset, Spread.GetData() + Offset, ColumnSums, Dest + Offset, BoxWidth);
+	}
+}
+
+int32 FGAGridDiffusion::GetBlurRadius(float Variance)
+{
+	// The variance of the cascade is R (R + 1), see GetBlurVariance
+	return (Variance > 0.0f) ? FMath::FloorToInt((FMath::Sqrt(4.0f * Variance + 1.0f) - 1.0f) * 0.5f) : 0;
+}
+
+bool FGAGridDiffusion::Blur(FGAGridMap& Map, int32 Radius, FGridBox& ActiveBox, float NegligibleValue)
+{
+	if (!IsPreparedFor(Map))
+	{
+		return false;
+	}
+
+	if (Radius <= 0)
+	{
+		return true;
+	}
+
+	// Local coordinates from here on
+	const FGridBox LocalBounds(0, Width - 1, 0, Height - 1);
+	const FGridBox& MapBounds = Map.GridBounds;
+	FGridBox Box = ActiveBox.GetOverlap(MapBounds);
+	if (!Box.IsValid())
+	{
+		// Nothing but zeros
+		ActiveBox = FGridBox();
+		return true;
+	}
+	Box = FGridBox(Box.MinX - MapBounds.MinX, Box.MaxX - MapBounds.MinX, Box.MinY - MapBounds.MinY, Box.MaxY - MapBounds.MinY);
+
+	const FGridBox FinalBox = GrowBox(Box, BlurPasses * Radius).GetOverlap(LocalBounds);
+
+	const int32 CellCount = Width * Height;
+	BufferA.SetNumUninitialized(CellCount, EAllowShrinking::No);
+	BufferB.SetNumUninitialized(CellCount, EAllowShrinking::No);
+
+	// Each pass only reads the box the last one wrote, so only the active box needs copying in
+	for (int32 Y = Box.MinY; Y <= Box.MaxY; Y++)
+	{
+		for (int32 X = Box.MinX; X <= Box.MaxX; X++)
+		{
+			BufferA[Y * Width + X] = Map.GetLocalValueUnchecked(X, Y);
+		}
+	}
+
+	float* Front = BufferA.GetData();
+	float* Back = BufferB.GetData();
+	const uint8* OpenData = Open.GetData();
+
+	// Enough bands for a whole row or column
+	const int32 MaxBandCount = (FMath::Max(Width, Height) + BandHeight - 1) / BandHeight;
+	if (BlurPrefix.Num() < MaxBandCount)
+	{
+		BlurPrefix.SetNum(MaxBandCount);
+		BlurRunEnd.SetNum(MaxBandCount);
+	}
+
+	// Along X: each pass widens the box by Radius
+	for (int32 Pass = 0; Pass < BlurPasses; Pass++)
+	{
+		const FGridBox OutBox = FGridBox(Box.MinX - Radius, Box.MaxX + Radius, Box.MinY, Box.MaxY).GetOverlap(LocalBounds);
+		const int32 BandCount = (OutBox.GetHeight() + BandHeight - 1) / BandHeight;
+		ParallelFor(BandCount, [&](int32 BandIndex)
+		{
+			TArray<double>& Prefix = BlurPrefix[BandIndex];
+			TArray<int32>& RunEnd = BlurRunEnd[BandIndex];
+			const int32 StartY = OutBox.MinY + BandIndex * BandHeight;
+			const int32 EndY = FMath::Min(StartY + BandHeight, OutBox.MaxY + 1);
+			for (int32 Y = StartY; Y < EndY; Y++)
+			{
+				BoxFilterLine(Front + Y * Width, Back + Y * Width, OpenData + Y * Width, 1, Width,
+					Box.MinX, Box.MaxX, OutBox.MinX, OutBox.MaxX, Radius, Prefix, RunEnd);
+			}
+		}, (OutBox.GetCellCount() < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		Box = OutBox;
+		Swap(Front, Back);
+	}
+
+	// Then along Y, a column at a time
+	for (int32 Pass = 0; Pass < BlurPasses; Pass++)
+	{
+		const FGridBox OutBox = FGridBox(Box.MinX, Box.MaxX, Box.MinY - Radius, Box.MaxY + Radius).GetOverlap(LocalBounds);
+		const int32 BandCount = (OutBox.GetWidth() + BandHeight - 1) / BandHeight;
+		ParallelFor(BandCount, [&](int32 BandIndex)
+		{
+			TArray<double>& Prefix = BlurPrefix[BandIndex];
+			TArray<int32>& RunEnd = BlurRunEnd[BandIndex];
+			const int32 StartX = OutBox.MinX + BandIndex * BandHeight;
+			const int32 EndX = FMath::Min(StartX + BandHeight, OutBox.MaxX + 1);
+			for (int32 X = StartX; X < EndX; X++)
+			{
+				BoxFilterLine(Front + X, Back + X, OpenData + X, Width, Height,
+					Box.MinY, Box.MaxY, OutBox.MinY, OutBox.MaxY, Radius, Prefix, RunEnd);
+			}
+		}, (OutBox.GetCellCount() < MinCellsForParallel) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		Box = OutBox;
+		Swap(Front, Back);
+	}
+
+	// Front has the result, over FinalBox
+	check(Box == FinalBox);
+	for (int32 Y = FinalBox.MinY; Y <= FinalBox.MaxY; Y++)
+	{
+		for (int32 X = FinalBox.MinX; X <= FinalBox.MaxX; X++)
+		{
+			Map.GetLocalValueUnchecked(X, Y) = Front[Y * Width + X];
+		}
+	}
+
+	const FGridBox ChangedBox(FinalBox.MinX + MapBounds.MinX, FinalBox.MaxX + MapBounds.MinX, FinalBox.MinY + MapBounds.MinY, FinalBox.MaxY + MapBounds.MinY);
+	FinishActiveBox(Map, ChangedBox, NegligibleValue, ActiveBox);
+	return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "GAGridMap.h"
+
+
+// Repeated 3x3 diffusion over a grid map, as used to spread the target occupancy map:
+//
+//		Value' = (1 - Factor) * Value + Factor * (average of the traversable cells in the 3x3 block around the cell)
+//
+// Blocked cells (and cells off the map) don't take part: they hold 0 and aren't counted in the average, so
+// probability never bleeds into walls.
+//
+// Each step reads one buffer and writes the other (ping-pong), so the result doesn't depend on the order cells are
+// visited in. Everything that depends only on the grid -- the traversability mask and the 1 / neighbor count -- is
+// folded into two per-cell coefficients when the grid changes, which leaves the step itself branch free:
+//
+//		Value' = Keep * Value + Spread * (sum of the 3x3 block)
+//
+// The block sum is done separably (a column of three, then a row of three), four cells at a time with SIMD. Rows are
+// split into bands for ParallelFor; the top and bottom rows, which are missing a neighbor row, get their own pass.
+//
+// Everything outside the box the steps work on counts as 0, which lets Diffuse skip the parts of the map the
+// probability hasn't reached yet: with an active box, each step only covers that box grown by one cell.
+//
+// Keep one of these around per map: Prepare is cheap when nothing has changed, and the buffers are reused.
+
+class AGAGridActor;
+template<typename ValueType> struct TGAGridMap;
+
+class FGAGridDiffusion
+{
+public:
+	// Get ready to diffuse maps covering Bounds on Grid. Only does any work if the grid's cells (or any of the
+	// arguments) changed since last time, and if it's only the cells, only redoes the chunks they changed in.
+	// If bRespectTraversability is false, every cell in Bounds counts as open.
+	void Prepare(const AGAGridActor* Grid, const FGridBox& Bounds, float DiffusionFactor, bool bRespectTraversability = true);
+
+	// Run Iterations steps on Map. Map's bounds need to match the ones passed to Prepare.
+	// Marks the whole map dirty. Returns false (and leaves the map alone) if it isn't set up for this map.
+	bool Diffuse(FGAGridMap& Map, int32 Iterations);
+
+	// Same, but only over the part of the map that can hold any probability, so the cost goes with the area the
+	// values could have spread to rather than with the size of the map.
+	// On the way in, every cell of Map outside ActiveBox (grid coordinates) has to be 0. On the way out ActiveBox
+	// is the same for the new values: it's grown by one cell per step, then (if NegligibleValue >= 0) shrunk to the
+	// cells above NegligibleValue, with the cells it drops set to 0. Only the cells the steps reached are marked dirty.
+	bool Diffuse(FGAGridMap& Map, int32 Iterations, FGridBox& ActiveBox, float NegligibleValue);
+
+	// The same steps, with the same coefficients (so nothing leaks into walls either), on a compact map (see
+	// GATypedGridMap.h). Values are rounded to the map's precision after every step. This one is scalar and covers
+	// the whole map; what it saves is memory, not time. Defined for FFloat16, uint16 and uint8.
+	template<typename ValueType>
+	bool Diffuse(TGAGridMap<ValueType>& Map, int32 Iterations);
+
+	// The closed-form alternative to running Diffuse with lots of steps: one blur, close to a Gaussian, made of
+	// BlurPasses box filters of the given radius along X and then along Y. A box only averages cells in the same run
+	// of open cells, so nothing crosses a wall along either axis, and blocked cells come out 0. Each cell costs the
+	// same whatever the radius. ActiveBox and NegligibleValue work as for Diffuse; the box grows by BlurPasses * Radius.
+	bool Blur(FGAGridMap& Map, int32 Radius, FGridBox& ActiveBox, float NegligibleValue);
+
+	static constexpr int32 BlurPasses = 3;
+
+	// The variance (in cells squared, along each axis) a Blur of the given radius adds. A box of width 2R + 1 has a
+	// variance of ((2R + 1)^2 - 1) / 12, and there are three of them.
+	static float GetBlurVariance(int32 Radius) { return float(Radius * (Radius + 1)); }
+
+	// The biggest radius whose blur adds no more than Variance (0 if that's less than radius 1 does)
+	static int32 GetBlurRadius(float Variance);
+
+	bool IsPreparedFor(const FGAGridMap& Map) const;
+
+	// Free the buffers
+	void Reset();
+
+	// Maps with fewer cells than this are diffused on the calling thread; ParallelFor costs more than it saves
+	static constexpr int32 MinCellsForParallel = 128 * 128;
+
+	// Rows per ParallelFor task
+	static constexpr int32 BandHeight = 32;
+
+private:
+	// One step, from Source to Dest, over Box (local coordinates). Both are row-major, Width x Height.
+	// Cells outside Box are read as 0.
+	void Step(const float* Source, float* Dest, const FGridBox& Box) const;
+
+	// Fill in Open, then Keep and Spread, over Box (local coordinates). Keep and Spread read the mask one cell
+	// beyond Box, so anything that changes the mask has to redo them over the box grown by one.
+	void BuildOpen(const AGAGridActor* Grid, const FGridBox& Box);
+	void BuildCoefficients(const FGridBox& Box);
+
+	// Mark ChangedBox (grid coordinates) dirty, and make it the new active box, trimmed to the cells above NegligibleValue
+	static void FinishActiveBox(FGAGridMap& Map, const FGridBox& ChangedBox, float NegligibleValue, FGridBox& ActiveBox);
+
+	// Grid and settings the coefficients were built for
+	FObjectKey PreparedGrid;
+	int32 PreparedGridVersion = INDEX_NONE;
+	FGridBox PreparedBounds;
+	float PreparedFactor = -1.0f;
+	bool bPreparedRespectTraversability = false;
+
+	int32 Width = 0;
+	int32 Height = 0;
+
+	// 1 for the cells that take part, 0 for blocked ones, row-major
+	TArray<uint8> Open;
+
+	// Per-cell coefficients, row-major: Keep = 1 - Factor and Spread = Factor / (open cells in the 3x3 block)
+	// for open cells, 0 for blocked ones
+	TArray<float> Keep;
+	TArray<float> Spread;
+
+	// Ping-pong buffers, row-major. With the row-major grid layout the map's own Data serves as one of them.
+	TArray<float> BufferA;
+	TArray<float> BufferB;
+
+	// A row of zeros standing in for the rows above the top and below the bottom
+	TArray<float> ZeroRow;
+
+	// Per-band column sums, Width + 2 floats each (one zero of padding at either end takes care of the left and
+	// right edges). One extra slot for the border pass.
+	mutable TArray<float> Scratch;
+
+	// Per-band running sums and run ends for the blur's box filters, grown as needed
+	TArray<TArray<double>> BlurPrefix;
+	TArray<TArray<int32>> BlurRunEnd;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+// Memory layout for per-cell grid data: AGAGridActor's Data (and its derived per-cell arrays) and FGAGridMap's Data.
+// Everything goes through GAGridLayout::GetIndex, so the layout can be swapped at compile time by defining
+// GA_GRID_LAYOUT, e.g. in GameAI.Build.cs:
+//
+//		PublicDefinitions.Add("GA_GRID_LAYOUT=1");
+//
+// Row-major is the simplest, but a 3x3 stencil on a wide grid touches three rows that are far apart in memory.
+// The tiled layouts keep each 8x8 block of cells together (64 floats = 4 cache lines), so stencils and
+// neighbor lookups mostly stay within a tile.
+//
+// Note: grid data saved with one layout needs to be rebaked after switching to another.
+
+#define GA_GRID_LAYOUT_ROW_MAJOR	0		// X-major rows, i.e. (0, 0), (1, 0), (2, 0) ... (0, 1), (1, 1) ...
+#define GA_GRID_LAYOUT_TILED		1		// 8x8 tiles stored X-major, cells X-major within each tile
+#define GA_GRID_LAYOUT_MORTON		2		// 8x8 tiles stored X-major, cells in Z-order (Morton order) within each tile
+
+#ifndef GA_GRID_LAYOUT
+#define GA_GRID_LAYOUT GA_GRID_LAYOUT_ROW_MAJOR
+#endif
+
+
+namespace GAGridLayout
+{
+	constexpr int32 TileShift = 3;
+	constexpr int32 TileSize = 1 << TileShift;
+	constexpr int32 TileMask = TileSize - 1;
+
+	// True if each row of cells is one contiguous span of memory
+	constexpr bool bRowsAreContiguous = (GA_GRID_LAYOUT == GA_GRID_LAYOUT_ROW_MAJOR);
+
+	// Spread the low three bits of V out to every other bit, i.e. 0b abc -> 0b 0a0b0c
+	FORCEINLINE int32 SpreadBits3(int32 V)
+	{
+		V = (V | (V << 2)) & 0x33;
+		V = (V | (V << 1)) & 0x55;
+		return V;
+	}
+
+	// Number of elements to allocate for a Width x Height block of cells (the tiled layouts pad out to whole tiles)
+	FORCEINLINE int32 GetAllocatedCount(int32 Width, int32 Height)
+	{
+#if GA_GRID_LAYOUT == GA_GRID_LAYOUT_ROW_MAJOR
+		return Width * Height;
+#else
+		return ((Width + TileMask) & ~TileMask) * ((Height + TileMask) & ~TileMask);
+#endif
+	}
+
+	// Flattened index of cell (X, Y) in a block of cells that is Width wide
+	FORCEINLINE int32 GetIndex(int32 X, int32 Y, int32 Width)
+	{
+#if GA_GRID_LAYOUT == GA_GRID_LAYOUT_ROW_MAJOR
+		return Y * Width + X;
+#else
+		int32 TilesPerRow = (Width + TileMask) >> TileShift;
+		int32 TileIndex = (Y >> TileShift) * TilesPerRow + (X >> TileShift);
+	#if GA_GRID_LAYOUT == GA_GRID_LAYOUT_TILED
+		int32 InTileIndex = ((Y & TileMask) << TileShift) + (X & TileMask);
+	#else
+		int32 InTileIndex = (SpreadBits3(Y & TileMask) << 1) | SpreadBits3(X & TileMask);
+	#endif
+		return (TileIndex << (2 * TileShift)) + InTileIndex;
+#endif
+	}
+
+	// Number of cells, starting at (X, Y), that follow one another in memory along the row
+	// (i.e. cells X, X + 1, ... have consecutive indices). Never more than Width - X.
+	FORCEINLINE int32 GetContiguousRun(int32 X, int32 Width)
+	{
+#if GA_GRID_LAYOUT == GA_GRID_LAYOUT_ROW_MAJOR
+		return Width - X;
+#elif GA_GRID_LAYOUT == GA_GRID_LAYOUT_TILED
+		return FMath::Min(TileSize - (X & TileMask), Width - X);
+#else
+		// Z-order only keeps horizontal pairs together
+		return FMath::Min(2 - (X & 1), Width - X);
+#endif
+	}
+
+	// Human-readable name of the layout we were compiled with
+	FORCEINLINE const TCHAR* GetLayoutName()
+	{
+#if GA_GRID_LAYOUT == GA_GRID_LAYOUT_ROW_MAJOR
+		return TEXT("RowMajor");
+#elif GA_GRID_LAYOUT == GA_GRID_LAYOUT_TILED
+		return TEXT("Tiled8x8");
+#else
+		return TEXT("Morton8x8");
+#endif
+	}
+}
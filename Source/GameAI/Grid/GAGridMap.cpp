@@ -1,7 +1,7 @@
 #include "GAGridMap.h"
 #include "GAGridActor.h"
-
-UE_DISABLE_OPTIMIZATION
+#include "GAGridMapOps.h"
+#include <atomic>
 
 // --------------------- FGridBox ---------------------
 
@@ -46,6 +46,64 @@ FGAGridMap::FGAGridMap(const AGAGridActor* Grid, const FGridBox& GridBoxIn, floa
 	ResetData(InitialValue);
 }
 
+FGAGridMap::FGAGridMap(const FGAGridMap& Other)
+{
+	*this = Other;
+}
+
+FGAGridMap& FGAGridMap::operator=(const FGAGridMap& Other)
+{
+	if (this != &Other)
+	{
+		XCount = Other.XCount;
+		YCount = Other.YCount;
+		GridBounds = Other.GridBounds;
+		Data = Other.Data;
+
+		bTrackDirty = Other.bTrackDirty;
+		DirtyBox = Other.DirtyBox;
+		Pyramid = Other.Pyramid;
+
+		// A different map as far as anything copying from either of us is concerned
+		DirtyBoxVersion = GetNextDirtyBoxVersion();
+		LastCopySource = nullptr;
+		LastCopySourceVersion = 0;
+		ReleaseSnapshot();
+	}
+	return *this;
+}
+
+FGAGridMap::FGAGridMap(FGAGridMap&& Other)
+{
+	*this = MoveTemp(Other);
+}
+
+FGAGridMap& FGAGridMap::operator=(FGAGridMap&& Other)
+{
+	if (this != &Other)
+	{
+		XCount = Other.XCount;
+		YCount = Other.YCount;
+		GridBounds = Other.GridBounds;
+		Data = MoveTemp(Other.Data);
+
+		bTrackDirty = Other.bTrackDirty;
+		DirtyBox = Other.DirtyBox;
+		Pyramid = MoveTemp(Other.Pyramid);
+		Other.Pyramid.Reset();
+
+		DirtyBoxVersion = GetNextDirtyBoxVersion();
+		LastCopySource = nullptr;
+		LastCopySourceVersion = 0;
+		ReleaseSnapshot();
+
+		// Other no longer has the values its version stood for (anyone holding its snapshot keeps their copy)
+		Other.DirtyBoxVersion = GetNextDirtyBoxVersion();
+		Other.ReleaseSnapshot();
+	}
+	return *this;
+}
+
 void FGAGridMap::ResetData(float InitialValue)
 {
 	if (GridBounds.IsValid())
@@ -56,13 +114,10 @@ void FGAGridMap::ResetData(float InitialValue)
 		check(BoxWidth > 0);
 		check(BoxHeight > 0);
 
-		int32 CellCount = BoxWidth * BoxHeight;
-		Data.SetNum(CellCount);
+		int32 CellCount = GAGridLayout::GetAllocatedCount(BoxWidth, BoxHeight);
+		Data.SetNumUninitialized(CellCount, EAllowShrinking::No);
 
-		for (int32 Index = 0; Index < CellCount; Index++)
-		{
-			Data[Index] = InitialValue;
-		}
+		GAGridMapOps::Fill(*this, InitialValue);
 	}
 	else
 	{
@@ -70,6 +125,58 @@ void FGAGridMap::ResetData(float InitialValue)
 	}
 }
 
+void FGAGridMap::SetDirtyTracking(bool bEnable)
+{
+	bTrackDirty = bEnable;
+	DirtyBox = FGridBox();
+	DirtyBoxVersion = GetNextDirtyBoxVersion();
+}
+
+FGridBox FGAGridMap::ConsumeDirtyBox()
+{
+	FGridBox Result = DirtyBox;
+	DirtyBox = FGridBox();
+	DirtyBoxVersion = GetNextDirtyBoxVersion();
+	return Result;
+}
+
+uint32 FGAGridMap::GetNextDirtyBoxVersion()
+{
+	// Maps can be written (and so consume their dirty boxes) off the game thread
+	static std::atomic<uint32> NextVersion(0);
+	return ++NextVersion;
+}
+
+void FGAGridMap::CopyDirtyCellsFrom(FGAGridMap& Source)
+{
+	// Source's dirty box only says what changed since someone last consumed it. If that wasn't us, copying from
+	// Source, or we weren't tracking (so our own values may have been changed without a mark), it's not enough.
+	const bool bUpToDate = bTrackDirty && (LastCopySource == &Source) && (LastCopySourceVersion == Source.DirtyBoxVersion);
+
+	if (!bTrackDirty)
+	{
+		SetDirtyTracking(true);
+	}
+
+	if (bUpToDate && Source.bTrackDirty && IsValid() && Source.IsValid() && (GridBounds == Source.GridBounds))
+	{
+		// Copy marks what it writes
+		GAGridMapOps::Copy(*this, Source, Source.ConsumeDirtyBox());
+	}
+	else
+	{
+		XCount = Source.XCount;
+		YCount = Source.YCount;
+		GridBounds = Source.GridBounds;
+		Data = Source.Data;
+		Source.ConsumeDirtyBox();
+		MarkAllDirty();
+	}
+
+	LastCopySource = &Source;
+	LastCopySourceVersion = Source.DirtyBoxVersion;
+}
+
 
 bool FGAGridMap::CellRefToLocal(const FCellRef& Cell, int32& X, int32& Y) const
 {
@@ -99,7 +206,7 @@ bool FGAGridMap::GetValue(const FCellRef& Cell, float &ValueOut) const
 	int32 X, Y;
 	if (CellRefToLocal(Cell, X, Y))
 	{
-		int32 Index = GridBounds.GetWidth()* Y + X;
+		int32 Index = LocalToIndex(X, Y);
 		check(Data.IsValidIndex(Index));
 		ValueOut = Data[Index];
 		return true;
@@ -109,16 +216,14 @@ bool FGAGridMap::GetValue(const FCellRef& Cell, float &ValueOut) const
 
 bool FGAGridMap::GetMaxValue(float& MaxValueOut) const
 {
-	if (IsValid())
+	if (const FGAGridMapPyramid* MapPyramid = GetPyramid())
 	{
-		MaxValueOut = -UE_MAX_FLT;
-		for (int32 Index = 0; Index < Data.Num(); Index++)
-		{
-			MaxValueOut = FMath::Max(MaxValueOut, Data[Index]);
-		}
+		MaxValueOut = MapPyramid->GetNodeMax(*this, MapPyramid->GetTopLevel(), 0, 0);
 		return true;
 	}
-	return false;
+
+	float MinValue;
+	return GAGridMapOps::GetMinMax(*this, MinValue, MaxValueOut);
 }
 
 
@@ -127,13 +232,283 @@ bool FGAGridMap::SetValue(const FCellRef& Cell, float Value)
 	int32 X, Y;
 	if (CellRefToLocal(Cell, X, Y))
 	{
-		int32 Index = GridBounds.GetWidth()* Y + X;
+		int32 Index = LocalToIndex(X, Y);
 		check(Data.IsValidIndex(Index));
 		Data[Index] = Value;
+		MarkDirty(Cell.X, Cell.Y);
 		return true;
 	}
 	return false;
 }
 
 
-UE_DISABLE_OPTIMIZATION
+void FGAGridMap::SetPyramidEnabled(bool bEnable)
+{
+	Pyramid.Reset();
+	Pyramid.bEnabled = bEnable;
+}
+
+const FGAGridMapPyramid* FGAGridMap::GetPyramid() const
+{
+	if (Pyramid.bEnabled && IsValid())
+	{
+		Pyramid.Update(*this);
+		return &Pyramid;
+	}
+	return NULL;
+}
+
+FGAGridMapSnapshot FGAGridMap::GetSnapshot() const
+{
+	const bool bSameShape = Snapshot.IsValid() && (Snapshot->XCount == XCount) && (Snapshot->YCount == YCount) &&
+		(Snapshot->GridBounds == GridBounds) && (Snapshot->Data.Num() == Data.Num());
+
+	if (bSameShape && !SnapshotDirtyBox.IsValid())
+	{
+		// Nothing has changed since the last one
+	}
+	else if (bSameShape && Snapshot.IsUnique() && IsValid())
+	{
+		// Nobody else can see the old snapshot any more, so it's safe to bring it up to date in place
+		GAGridMapOps::Copy(*Snapshot, *this, SnapshotDirtyBox);
+	}
+	else
+	{
+		// Copy on write: whoever holds the old snapshot keeps it as it was
+		TSharedPtr<FGAGridMap, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FGAGridMap, ESPMode::ThreadSafe>();
+		NewSnapshot->XCount = XCount;
+		NewSnapshot->YCount = YCount;
+		NewSnapshot->GridBounds = GridBounds;
+		NewSnapshot->Data = Data;
+		Snapshot = NewSnapshot;
+	}
+
+	SnapshotDirtyBox = FGridBox();
+	return Snapshot.ToSharedRef();
+}
+
+void FGAGridMap::ReleaseSnapshot()
+{
+	Snapshot.Reset();
+	SnapshotDirtyBox = FGridBox();
+}
+
+
+// --------------------- FGAGridMapPyramid ---------------------
+
+void FGAGridMapPyramid::Reset()
+{
+	Levels.Empty();
+	BuiltBounds = FGridBox();
+	DirtyBox = FGridBox();
+}
+
+void FGAGridMapPyramid::Update(const FGAGridMap& Map)
+{
+	const FGridBox& Bounds = Map.GridBounds;
+	const int32 MapWidth = Bounds.GetWidth();
+	const int32 MapHeight = Bounds.GetHeight();
+
+	// The local cells whose nodes need redoing
+	FGridBox LocalBox;
+
+	if (BuiltBounds != Bounds)
+	{
+		// Halve (rounding up) until one node covers everything
+		Levels.Reset();
+		int32 Width = MapWidth;
+		int32 Height = MapHeight;
+		while ((Width > 1) || (Height > 1))
+		{
+			Width = (Width + 1) >> 1;
+			Height = (Height + 1) >> 1;
+
+			FLevel& Level = Levels.AddDefaulted_GetRef();
+			Level.Width = Width;
+			Level.Height = Height;
+			Level.Max.SetNumUninitialized(Width * Height);
+			Level.Sum.SetNumUninitialized(Width * Height);
+		}
+
+		BuiltBounds = Bounds;
+		LocalBox = FGridBox(0, MapWidth - 1, 0, MapHeight - 1);
+	}
+	else if (DirtyBox.IsValid())
+	{
+		LocalBox = FGridBox(DirtyBox.MinX - Bounds.MinX, DirtyBox.MaxX - Bounds.MinX, DirtyBox.MinY - Bounds.MinY, DirtyBox.MaxY - Bounds.MinY);
+	}
+
+	DirtyBox = FGridBox();
+
+	if (!LocalBox.IsValid())
+	{
+		return;
+	}
+
+	// Each level up, the box of nodes to redo halves
+	int32 ChildWidth = MapWidth;
+	int32 ChildHeight = MapHeight;
+
+	for (int32 LevelIndex = 0; LevelIndex < Levels.Num(); LevelIndex++)
+	{
+		FLevel& Level = Levels[LevelIndex];
+		LocalBox = FGridBox(LocalBox.MinX >> 1, LocalBox.MaxX >> 1, LocalBox.MinY >> 1, LocalBox.MaxY >> 1);
+
+		for (int32 Y = LocalBox.MinY; Y <= LocalBox.MaxY; Y++)
+		{
+			const int32 ChildMaxY = FMath::Min(2 * Y + 1, ChildHeight - 1);
+			for (int32 X = LocalBox.MinX; X <= LocalBox.MaxX; X++)
+			{
+				const int32 ChildMaxX = FMath::Min(2 * X + 1, ChildWidth - 1);
+
+				float MaxValue = -UE_MAX_FLT;
+				float Sum = 0.0f;
+				for (int32 ChildY = 2 * Y; ChildY <= ChildMaxY; ChildY++)
+				{
+					for (int32 ChildX = 2 * X; ChildX <= ChildMaxX; ChildX++)
+					{
+						MaxValue = FMath::Max(MaxValue, GetNodeMax(Map, LevelIndex, ChildX, ChildY));
+						Sum += GetNodeSum(Map, LevelIndex, ChildX, ChildY);
+					}
+				}
+
+				Level.Max[Y * Level.Width + X] = MaxValue;
+				Level.Sum[Y * Level.Width + X] = Sum;
+			}
+		}
+
+		ChildWidth = Level.Width;
+		ChildHeight = Level.Height;
+	}
+}
+
+float FGAGridMapPyramid::GetNodeMax(const FGAGridMap& Map, int32 Level, int32 X, int32 Y) const
+{
+	if (Level == 0)
+	{
+		return Map.GetLocalValueUnchecked(X, Y);
+	}
+	const FLevel& NodeLevel = Levels[Level - 1];
+	return NodeLevel.Max[Y * NodeLevel.Width + X];
+}
+
+float FGAGridMapPyramid::GetNodeSum(const FGAGridMap& Map, int32 Level, int32 X, int32 Y) const
+{
+	if (Level == 0)
+	{
+		return Map.GetLocalValueUnchecked(X, Y);
+	}
+	const FLevel& NodeLevel = Levels[Level - 1];
+	return NodeLevel.Sum[Y * NodeLevel.Width + X];
+}
+
+int32 FGAGridMapPyramid::FindTopCells(const FGAGridMap& Map, const FGridBox& LocalBox, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut) const
+{
+	CellsOut.Reset();
+	if (ValuesOut)
+	{
+		ValuesOut->Reset();
+	}
+
+	const int32 MapWidth = Map.GridBounds.GetWidth();
+	const int32 MapHeight = Map.GridBounds.GetHeight();
+
+	struct FNode
+	{
+		float Max;
+		int32 Level;
+		int32 X;
+		int32 Y;
+	};
+
+	// Best-first: a node's max is an upper bound on every cell under it, so when a cell comes off the top of the
+	// heap nothing left can beat it
+	TArray<FNode, TInlineAllocator<64>> Heap;
+	auto HigherMax = [](const FNode& A, const FNode& B) { return A.Max > B.Max; };
+
+	auto PushIfOverlapping = [&](int32 Level, int32 X, int32 Y)
+	{
+		const int32 NodeMinX = X << Level;
+		const int32 NodeMinY = Y << Level;
+		const int32 NodeMaxX = ((X + 1) << Level) - 1;
+		const int32 NodeMaxY = ((Y + 1) << Level) - 1;
+		if ((NodeMinX <= LocalBox.MaxX) && (NodeMaxX >= LocalBox.MinX) && (NodeMinY <= LocalBox.MaxY) && (NodeMaxY >= LocalBox.MinY))
+		{
+			Heap.HeapPush(FNode{ GetNodeMax(Map, Level, X, Y), Level, X, Y }, HigherMax);
+		}
+	};
+
+	if (Count > 0)
+	{
+		PushIfOverlapping(GetTopLevel(), 0, 0);
+	}
+
+	while ((Heap.Num() > 0) && (CellsOut.Num() < Count))
+	{
+		FNode Node;
+		Heap.HeapPop(Node, HigherMax, EAllowShrinking::No);
+
+		if (Node.Level == 0)
+		{
+			CellsOut.Add(FCellRef(Map.GridBounds.MinX + Node.X, Map.GridBounds.MinY + Node.Y));
+			if (ValuesOut)
+			{
+				ValuesOut->Add(Node.Max);
+			}
+			continue;
+		}
+
+		const int32 ChildLevel = Node.Level - 1;
+		const int32 ChildWidth = (ChildLevel == 0) ? MapWidth : Levels[ChildLevel - 1].Width;
+		const int32 ChildHeight = (ChildLevel == 0) ? MapHeight : Levels[ChildLevel - 1].Height;
+		for (int32 ChildY = 2 * Node.Y; ChildY <= FMath::Min(2 * Node.Y + 1, ChildHeight - 1); ChildY++)
+		{
+			for (int32 ChildX = 2 * Node.X; ChildX <= FMath::Min(2 * Node.X + 1, ChildWidth - 1); ChildX++)
+			{
+				PushIfOverlapping(ChildLevel, ChildX, ChildY);
+			}
+		}
+	}
+
+	return CellsOut.Num();
+}
+
+float FGAGridMapPyramid::GetSum(const FGAGridMap& Map, const FGridBox& LocalBox) const
+{
+	return SumNode(Map, LocalBox, GetTopLevel(), 0, 0);
+}
+
+float FGAGridMapPyramid::SumNode(const FGAGridMap& Map, const FGridBox& LocalBox, int32 Level, int32 X, int32 Y) const
+{
+	const int32 MapWidth = Map.GridBounds.GetWidth();
+	const int32 MapHeight = Map.GridBounds.GetHeight();
+
+	const int32 NodeMinX = X << Level;
+	const int32 NodeMinY = Y << Level;
+	const int32 NodeMaxX = FMath::Min(((X + 1) << Level) - 1, MapWidth - 1);
+	const int32 NodeMaxY = FMath::Min(((Y + 1) << Level) - 1, MapHeight - 1);
+
+	// Nodes entirely inside the box contribute their sum, ones straddling its edge are split further
+	if ((NodeMinX > LocalBox.MaxX) || (NodeMaxX < LocalBox.MinX) || (NodeMinY > LocalBox.MaxY) || (NodeMaxY < LocalBox.MinY))
+	{
+		return 0.0f;
+	}
+	if ((NodeMinX >= LocalBox.MinX) && (NodeMaxX <= LocalBox.MaxX) && (NodeMinY >= LocalBox.MinY) && (NodeMaxY <= LocalBox.MaxY))
+	{
+		return GetNodeSum(Map, Level, X, Y);
+	}
+
+	const int32 ChildLevel = Level - 1;
+	const int32 ChildWidth = (ChildLevel == 0) ? MapWidth : Levels[ChildLevel - 1].Width;
+	const int32 ChildHeight = (ChildLevel == 0) ? MapHeight : Levels[ChildLevel - 1].Height;
+
+	float Sum = 0.0f;
+	for (int32 ChildY = 2 * Y; ChildY <= FMath::Min(2 * Y + 1, ChildHeight - 1); ChildY++)
+	{
+		for (int32 ChildX = 2 * X; ChildX <= FMath::Min(2 * X + 1, ChildWidth - 1); ChildX++)
+		{
+			Sum += SumNode(Map, LocalBox, ChildLevel, ChildX, ChildY);
+		}
+	}
+	return Sum;
+}
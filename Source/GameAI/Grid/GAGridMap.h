@@ -2,11 +2,13 @@
 
 #include "CoreMinimal.h"
 #include "Math/MathFwd.h"
+#include "GAGridLayout.h"
 #include "GAGridMap.generated.h"
 
 
 // This allows us to define a set of floating point values over the grid defined by a AGAGridActor.
 // Note that it does not necessarily need to cover the entire grid
+// For maps that don't need full float precision, see TGAGridMap in GATypedGridMap.h
 
 class AGAGridActor;
 struct FCellRef;
@@ -48,9 +50,176 @@ struct FGridBox
 	int32 GetCellCount() const { return ((MaxX - MinX) + 1) * ((MaxY - MinY) + 1); }
 
 	bool IsValidCell(const FCellRef& Cell) const;
+
+	FORCEINLINE bool IsValidCell(int32 X, int32 Y) const
+	{
+		return (X >= MinX) && (X <= MaxX) && (Y >= MinY) && (Y <= MaxY);
+	}
+
+	bool operator==(const FGridBox& Other) const
+	{
+		return (MinX == Other.MinX) && (MaxX == Other.MaxX) && (MinY == Other.MinY) && (MaxY == Other.MaxY);
+	}
+
+	bool operator!=(const FGridBox& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	// The smallest box that holds both (either may be invalid, i.e. empty)
+	FGridBox GetUnion(const FGridBox& Other) const
+	{
+		if (!IsValid())
+		{
+			return Other;
+		}
+		if (!Other.IsValid())
+		{
+			return *this;
+		}
+		return FGridBox(FMath::Min(MinX, Other.MinX), FMath::Max(MaxX, Other.MaxX), FMath::Min(MinY, Other.MinY), FMath::Max(MaxY, Other.MaxY));
+	}
+
+	// The cells that are in both boxes (not valid if they don't overlap)
+	FGridBox GetOverlap(const FGridBox& Other) const
+	{
+		return FGridBox(FMath::Max(MinX, Other.MinX), FMath::Min(MaxX, Other.MaxX), FMath::Max(MinY, Other.MinY), FMath::Min(MaxY, Other.MaxY));
+	}
+};
+
+
+// One cell of a map, as handed out by the map's cell iterator. X and Y are grid (not local) cell coordinates.
+template<typename ValueType>
+struct TGAGridMapCell
+{
+	int32 X;
+	int32 Y;
+	ValueType& Value;
+};
+
+// Walks the cells of a box within a map, a row at a time (Y outer, X inner), whatever the memory layout.
+// Use via FGAGridMap::Cells(), e.g.
+//
+//		for (TGAGridMapCell<float> Cell : Map.Cells()) { Cell.Value *= 0.5f; }
+//
+template<typename ValueType>
+class TGAGridMapCellIterator
+{
+public:
+	TGAGridMapCellIterator(ValueType* InData, const FGridBox& InMapBounds, int32 InMinX, int32 InMaxX, int32 InX, int32 InY)
+		: Data(InData), MapMinX(InMapBounds.MinX), MapMinY(InMapBounds.MinY), MapWidth(InMapBounds.GetWidth()), MinX(InMinX), MaxX(InMaxX), X(InX), Y(InY)
+	{
+	}
+
+	FORCEINLINE TGAGridMapCell<ValueType> operator*() const
+	{
+		return { X, Y, Data[GAGridLayout::GetIndex(X - MapMinX, Y - MapMinY, MapWidth)] };
+	}
+
+	FORCEINLINE TGAGridMapCellIterator& operator++()
+	{
+		if (++X > MaxX)
+		{
+			X = MinX;
+			++Y;
+		}
+		return *this;
+	}
+
+	FORCEINLINE bool operator!=(const TGAGridMapCellIterator& Other) const
+	{
+		return (X != Other.X) || (Y != Other.Y);
+	}
+
+private:
+	ValueType* Data;
+	int32 MapMinX;
+	int32 MapMinY;
+	int32 MapWidth;
+	int32 MinX;
+	int32 MaxX;
+	int32 X;
+	int32 Y;
+};
+
+template<typename ValueType>
+struct TGAGridMapCellRange
+{
+	TGAGridMapCellRange(ValueType* InData, const FGridBox& InMapBounds, const FGridBox& InBox)
+		: Data(InData), MapBounds(InMapBounds), Box(InBox)
+	{
+	}
+
+	TGAGridMapCellIterator<ValueType> begin() const
+	{
+		return Box.IsValid() ? TGAGridMapCellIterator<ValueType>(Data, MapBounds, Box.MinX, Box.MaxX, Box.MinX, Box.MinY) : end();
+	}
+
+	TGAGridMapCellIterator<ValueType> end() const
+	{
+		return TGAGridMapCellIterator<ValueType>(Data, MapBounds, Box.MinX, Box.MaxX, Box.MinX, Box.MaxY + 1);
+	}
+
+	ValueType* Data;
+	FGridBox MapBounds;
+	FGridBox Box;
+};
+
+
+struct FGAGridMap;
+
+// Max and sum of the values under each 2x2, 4x4, 8x8 ... block of cells of a map, up to a single node covering
+// the whole map. Queries can then skip every block whose max is too low or which lies entirely inside (or outside)
+// a box: finding the max cell is a walk down from the top, and the top K cells come out best first.
+// Owned by the map it describes (see FGAGridMap::SetPyramidEnabled), and brought up to date lazily, redoing only
+// the nodes over the cells marked dirty since the last query.
+struct FGAGridMapPyramid
+{
+	struct FLevel
+	{
+		int32 Width = 0;
+		int32 Height = 0;
+		TArray<float> Max;
+		TArray<float> Sum;
+	};
+
+	bool bEnabled = false;
+
+	// Levels[N] has one node per 2^(N+1) x 2^(N+1) cells. (Level "0", one node per cell, is the map itself.)
+	TArray<FLevel> Levels;
+
+	// The map bounds the levels were built for
+	FGridBox BuiltBounds;
+
+	// Cells (in grid coordinates) changed since the last Update
+	FGridBox DirtyBox;
+
+	void Reset();
+
+	// Redo the nodes over DirtyBox, or everything if the map's bounds have changed
+	void Update(const FGAGridMap& Map);
+
+	// Node X, Y at the given level (0 = the map's own cells). Everything below is in local cell coordinates.
+	float GetNodeMax(const FGAGridMap& Map, int32 Level, int32 X, int32 Y) const;
+	float GetNodeSum(const FGAGridMap& Map, int32 Level, int32 X, int32 Y) const;
+
+	// Up to Count cells inside LocalBox, highest value first. Returns the number found.
+	int32 FindTopCells(const FGAGridMap& Map, const FGridBox& LocalBox, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut) const;
+
+	// Sum of the values inside LocalBox
+	float GetSum(const FGAGridMap& Map, const FGridBox& LocalBox) const;
+
+	int32 GetTopLevel() const { return Levels.Num(); }
+
+private:
+	float SumNode(const FGAGridMap& Map, const FGridBox& LocalBox, int32 Level, int32 X, int32 Y) const;
 };
 
 
+// A read-only copy of a grid map as it was at some point, shared by reference count (see FGAGridMap::GetSnapshot)
+typedef TSharedRef<const struct FGAGridMap, ESPMode::ThreadSafe> FGAGridMapSnapshot;
+
+
 USTRUCT(BlueprintType)
 struct FGAGridMap
 {
@@ -61,6 +230,13 @@ struct FGAGridMap
 	FGAGridMap(const AGAGridActor *Grid, float InitialValue);
 	FGAGridMap(const AGAGridActor* Grid, const FGridBox &GridBoxIn, float InitialValue);
 
+	// Copies get a DirtyBoxVersion of their own, and no record of a CopyDirtyCellsFrom source or of a snapshot.
+	// So do moves, which take Other's data and leave it empty.
+	FGAGridMap(const FGAGridMap& Other);
+	FGAGridMap& operator=(const FGAGridMap& Other);
+	FGAGridMap(FGAGridMap&& Other);
+	FGAGridMap& operator=(FGAGridMap&& Other);
+
 	void ResetData(float InitialValue);
 
 	// The XCount of the GridActor I'm built on
@@ -84,6 +260,13 @@ struct FGAGridMap
 
 	bool CellRefToLocal(const FCellRef& Cell, int32& X, int32& Y) const;
 
+	// Index into Data of the given local (i.e. relative to GridBounds.Min) coordinates
+	// The ordering of Data follows the compile-time grid layout (see GAGridLayout.h)
+	FORCEINLINE int32 LocalToIndex(int32 X, int32 Y) const
+	{
+		return GAGridLayout::GetIndex(X, Y, GridBounds.GetWidth());
+	}
+
 	bool LocalToCellRef(int32 X, int32 Y, FCellRef& Cell) const;
 
 	bool GetValue(const FCellRef& Cell, float& ValueOut) const;
@@ -93,8 +276,192 @@ struct FGAGridMap
 	bool SetValue(const FCellRef& Cell, float Value);
 
 
+	// Dirty tracking --------------------------------
+	// Optional. While it's on, SetValue, ResetData and the GAGridMapOps that write to the map grow DirtyBox to
+	// cover the cells they touch, so consumers (e.g. the debug texture) can redo only what changed.
+	// The unchecked accessors below don't track anything -- callers that write through them call MarkDirty.
+
+	void SetDirtyTracking(bool bEnable);
+
+	FORCEINLINE bool IsTrackingDirty() const { return bTrackDirty; }
+
+	FORCEINLINE void MarkDirty(int32 X, int32 Y)
+	{
+		if (bTrackDirty)
+		{
+			DirtyBox = DirtyBox.GetUnion(FGridBox(X, X, Y, Y));
+		}
+		if (Pyramid.bEnabled)
+		{
+			Pyramid.DirtyBox = Pyramid.DirtyBox.GetUnion(FGridBox(X, X, Y, Y));
+		}
+		if (Snapshot.IsValid())
+		{
+			SnapshotDirtyBox = SnapshotDirtyBox.GetUnion(FGridBox(X, X, Y, Y));
+		}
+	}
+
+	// Box is clipped to GridBounds
+	FORCEINLINE void MarkDirty(const FGridBox& Box)
+	{
+		if (bTrackDirty)
+		{
+			DirtyBox = DirtyBox.GetUnion(Box.GetOverlap(GridBounds));
+		}
+		if (Pyramid.bEnabled)
+		{
+			Pyramid.DirtyBox = Pyramid.DirtyBox.GetUnion(Box.GetOverlap(GridBounds));
+		}
+		if (Snapshot.IsValid())
+		{
+			SnapshotDirtyBox = SnapshotDirtyBox.GetUnion(Box.GetOverlap(GridBounds));
+		}
+	}
+
+	FORCEINLINE void MarkAllDirty() { MarkDirty(GridBounds); }
+
+	// Bounds of the cells changed since the last ConsumeDirtyBox. Not valid if nothing changed.
+	const FGridBox& GetDirtyBox() const { return DirtyBox; }
+
+	// Return the dirty box and start over with a clean map
+	FGridBox ConsumeDirtyBox();
+
+	// Make this map's values match Source's, copying only the cells that are dirty in Source (and consuming
+	// Source's dirty box). That's only safe when this map was already tracking, the last copy was from Source too,
+	// nothing else has consumed Source's dirty box since, and the bounds match; otherwise copies everything.
+	// Turns on tracking for this map, and marks whatever was copied dirty.
+	void CopyDirtyCellsFrom(FGAGridMap& Source);
+
+
+	// Reduction pyramid --------------------------------
+	// Optional (see FGAGridMapPyramid). With it, GetMaxValue and GAGridMapOps' ArgMax, FindTopCells and GetSum take
+	// roughly logarithmic time instead of a full scan. It's kept up to date from the same marks as dirty tracking
+	// (whether or not that is on), so writes through the unchecked accessors need a MarkDirty here too.
+
+	void SetPyramidEnabled(bool bEnable);
+
+	FORCEINLINE bool HasPyramid() const { return Pyramid.bEnabled; }
+
+	// The pyramid, brought up to date, or NULL if it's not enabled (or the map isn't valid)
+	const FGAGridMapPyramid* GetPyramid() const;
+
+
+	// Snapshots --------------------------------
+	// For handing the map's values to readers that shouldn't see it change under them, e.g. work on other threads
+	// (the grid actor fills its debug texture from one). A snapshot is an immutable FGAGridMap behind a thread-safe
+	// shared reference, so it costs nothing to pass around or hold on to, and any number of threads can read it.
+	//
+	// The map hangs on to the last snapshot it handed out. Asking again before anything is marked dirty returns that
+	// same snapshot, without a copy. After a change, if every reader has let go of the old snapshot, only the dirty
+	// cells are copied into it; otherwise (i.e. someone still holds the old view) the values are copied into a new one.
+	// So as with the pyramid, writes through the unchecked accessors need a MarkDirty.
+	//
+	// Snapshots have no dirty tracking or pyramid of their own. Call GetSnapshot from whichever thread writes the map.
+
+	FGAGridMapSnapshot GetSnapshot() const;
+
+	// Let go of the map's reference to its last snapshot (and the memory, if no one else holds it)
+	void ReleaseSnapshot();
+
+
 	FORCEINLINE bool IsValid() const
 	{
-		return GridBounds.IsValid() && (GridBounds.GetCellCount() == Data.Num());
+		return GridBounds.IsValid() && (GAGridLayout::GetAllocatedCount(GridBounds.GetWidth(), GridBounds.GetHeight()) == Data.Num());
+	}
+
+
+	// Unchecked access, for inner loops that have already made sure the map IsValid() and the cell is inside GridBounds.
+	// GetValue/SetValue redo both of those tests (plus a bounds check on Data) for every cell.
+
+	// X, Y are grid cell coordinates
+	FORCEINLINE float& GetValueUnchecked(int32 X, int32 Y)
+	{
+		checkSlow(GridBounds.IsValidCell(X, Y));
+		return Data.GetData()[LocalToIndex(X - GridBounds.MinX, Y - GridBounds.MinY)];
+	}
+
+	FORCEINLINE float GetValueUnchecked(int32 X, int32 Y) const
+	{
+		checkSlow(GridBounds.IsValidCell(X, Y));
+		return Data.GetData()[LocalToIndex(X - GridBounds.MinX, Y - GridBounds.MinY)];
 	}
+
+	FORCEINLINE void SetValueUnchecked(int32 X, int32 Y, float Value)
+	{
+		GetValueUnchecked(X, Y) = Value;
+	}
+
+	// X, Y are local coordinates (i.e. relative to GridBounds.Min)
+	FORCEINLINE float& GetLocalValueUnchecked(int32 X, int32 Y)
+	{
+		checkSlow((X >= 0) && (X < GridBounds.GetWidth()) && (Y >= 0) && (Y < GridBounds.GetHeight()));
+		return Data.GetData()[LocalToIndex(X, Y)];
+	}
+
+	FORCEINLINE float GetLocalValueUnchecked(int32 X, int32 Y) const
+	{
+		checkSlow((X >= 0) && (X < GridBounds.GetWidth()) && (Y >= 0) && (Y < GridBounds.GetHeight()));
+		return Data.GetData()[LocalToIndex(X, Y)];
+	}
+
+	// The values of row Y (a grid cell coordinate), from GridBounds.MinX to GridBounds.MaxX.
+	// Only the row-major layout keeps a row together, so this is only usable when GAGridLayout::bRowsAreContiguous --
+	// branch on that with if constexpr and fall back to Cells() (or the unchecked accessors) otherwise.
+	FORCEINLINE TArrayView<float> GetRow(int32 Y)
+	{
+		check(GAGridLayout::bRowsAreContiguous);
+		checkSlow(IsValid() && (Y >= GridBounds.MinY) && (Y <= GridBounds.MaxY));
+		return TArrayView<float>(Data.GetData() + LocalToIndex(0, Y - GridBounds.MinY), GridBounds.GetWidth());
+	}
+
+	FORCEINLINE TArrayView<const float> GetRow(int32 Y) const
+	{
+		check(GAGridLayout::bRowsAreContiguous);
+		checkSlow(IsValid() && (Y >= GridBounds.MinY) && (Y <= GridBounds.MaxY));
+		return TArrayView<const float>(Data.GetData() + LocalToIndex(0, Y - GridBounds.MinY), GridBounds.GetWidth());
+	}
+
+	// Iterate over (cell, value&) for every cell of the map, or just those in Box (clipped to GridBounds).
+	// Empty if the map isn't valid.
+	TGAGridMapCellRange<float> Cells()
+	{
+		return TGAGridMapCellRange<float>(Data.GetData(), GridBounds, IsValid() ? GridBounds : FGridBox());
+	}
+
+	TGAGridMapCellRange<const float> Cells() const
+	{
+		return TGAGridMapCellRange<const float>(Data.GetData(), GridBounds, IsValid() ? GridBounds : FGridBox());
+	}
+
+	TGAGridMapCellRange<float> Cells(const FGridBox& Box)
+	{
+		return TGAGridMapCellRange<float>(Data.GetData(), GridBounds, IsValid() ? Box.GetOverlap(GridBounds) : FGridBox());
+	}
+
+	TGAGridMapCellRange<const float> Cells(const FGridBox& Box) const
+	{
+		return TGAGridMapCellRange<const float>(Data.GetData(), GridBounds, IsValid() ? Box.GetOverlap(GridBounds) : FGridBox());
+	}
+
+private:
+	bool bTrackDirty = false;
+
+	FGridBox DirtyBox;
+
+	// Changes whenever DirtyBox is thrown away (and is unique across maps), so CopyDirtyCellsFrom can tell whether
+	// it has seen every change to its source
+	uint32 DirtyBoxVersion = 0;
+
+	// The map CopyDirtyCellsFrom last copied from, and that map's DirtyBoxVersion straight after
+	const FGAGridMap* LastCopySource = nullptr;
+	uint32 LastCopySourceVersion = 0;
+
+	static uint32 GetNextDirtyBoxVersion();
+
+	// Updated lazily by the (const) queries
+	mutable FGAGridMapPyramid Pyramid;
+
+	// The last snapshot handed out, and the cells changed since then
+	mutable TSharedPtr<FGAGridMap, ESPMode::ThreadSafe> Snapshot;
+	mutable FGridBox SnapshotDirtyBox;
 };
\ No newline at end of file
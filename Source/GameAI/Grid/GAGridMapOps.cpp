@@ -0,0 +1,522 @@
+#include "GAGridMapOps.h"
+#include "GAGridActor.h"
+#include "Math/VectorRegister.h"
+
+
+namespace GAGridMapOps
+{
+	// Intersect Box with Bounds. Returns false if they don't overlap.
+	static bool ClipBox(const FGridBox& Box, const FGridBox& Bounds, FGridBox& BoxOut)
+	{
+		BoxOut = Box.GetOverlap(Bounds);
+		return BoxOut.IsValid();
+	}
+
+	static bool IsWholeMap(const FGAGridMap& Map, const FGridBox& Box)
+	{
+		return (Box.MinX == Map.GridBounds.MinX) && (Box.MaxX == Map.GridBounds.MaxX) && (Box.MinY == Map.GridBounds.MinY) && (Box.MaxY == Map.GridBounds.MaxY);
+	}
+
+	// Call Body(Values, Count) for each run of cells inside Box (already clipped to Bounds) that are contiguous in memory
+	template<typename FloatType, typename BodyType>
+	static FORCEINLINE void ForEachRun(FloatType* Data, const FGridBox& Bounds, const FGridBox& Box, BodyType Body)
+	{
+		int32 Width = Bounds.GetWidth();
+		int32 LocalMaxX = Box.MaxX - Bounds.MinX;
+
+		for (int32 LocalY = Box.MinY - Bounds.MinY; LocalY <= Box.MaxY - Bounds.MinY; LocalY++)
+		{
+			int32 LocalX = Box.MinX - Bounds.MinX;
+			while (LocalX <= LocalMaxX)
+			{
+				int32 Count = FMath::Min(GAGridLayout::GetContiguousRun(LocalX, Width), LocalMaxX - LocalX + 1);
+				Body(Data + GAGridLayout::GetIndex(LocalX, LocalY, Width), Count);
+				LocalX += Count;
+			}
+		}
+	}
+
+	// Same, for a pair of maps. Box must already be clipped to both maps' bounds.
+	template<typename BodyType>
+	static FORCEINLINE void ForEachRunPair(float* Dest, const FGridBox& DestBounds, const float* Source, const FGridBox& SourceBounds, const FGridBox& Box, BodyType Body)
+	{
+		int32 DestWidth = DestBounds.GetWidth();
+		int32 SourceWidth = SourceBounds.GetWidth();
+
+		for (int32 Y = Box.MinY; Y <= Box.MaxY; Y++)
+		{
+			int32 X = Box.MinX;
+			while (X <= Box.MaxX)
+			{
+				int32 DestX = X - DestBounds.MinX;
+				int32 SourceX = X - SourceBounds.MinX;
+
+				// The two maps' tiles don't necessarily line up, so a run has to be contiguous in both
+				int32 Count = FMath::Min3(GAGridLayout::GetContiguousRun(DestX, DestWidth), GAGridLayout::GetContiguousRun(SourceX, SourceWidth), Box.MaxX - X + 1);
+
+				Body(Dest + GAGridLayout::GetIndex(DestX, Y - DestBounds.MinY, DestWidth),
+					Source + GAGridLayout::GetIndex(SourceX, Y - SourceBounds.MinY, SourceWidth),
+					Count);
+				X += Count;
+			}
+		}
+	}
+
+
+	// Kernels --------------------------------
+	// Each op works on a single float and on four at once, so the run loops can do the bulk with SIMD and mop up the tail
+
+	template<typename OpType>
+	static FORCEINLINE void UnaryRun(float* Values, int32 Count, const OpType& Op)
+	{
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			VectorStore(Op(VectorLoad(Values + Index)), Values + Index);
+		}
+		for (; Index < Count; Index++)
+		{
+			Values[Index] = Op(Values[Index]);
+		}
+	}
+
+	template<typename OpType>
+	static FORCEINLINE void BinaryRun(float* Dest, const float* Source, int32 Count, const OpType& Op)
+	{
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			VectorStore(Op(VectorLoad(Dest + Index), VectorLoad(Source + Index)), Dest + Index);
+		}
+		for (; Index < Count; Index++)
+		{
+			Dest[Index] = Op(Dest[Index], Source[Index]);
+		}
+	}
+
+	struct FFillOp
+	{
+		explicit FFillOp(float InValue) : Value(InValue), VValue(VectorSetFloat1(InValue)) {}
+		float Value;
+		VectorRegister4Float VValue;
+		FORCEINLINE float operator()(float) const { return Value; }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float&) const { return VValue; }
+	};
+
+	struct FScaleBiasOp
+	{
+		FScaleBiasOp(float InScale, float InBias) : Scale(InScale), Bias(InBias), VScale(VectorSetFloat1(InScale)), VBias(VectorSetFloat1(InBias)) {}
+		float Scale, Bias;
+		VectorRegister4Float VScale, VBias;
+		FORCEINLINE float operator()(float V) const { return V * Scale + Bias; }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& V) const { return VectorMultiplyAdd(V, VScale, VBias); }
+	};
+
+	struct FClampOp
+	{
+		FClampOp(float InMin, float InMax) : MinValue(InMin), MaxValue(InMax), VMin(VectorSetFloat1(InMin)), VMax(VectorSetFloat1(InMax)) {}
+		float MinValue, MaxValue;
+		VectorRegister4Float VMin, VMax;
+		FORCEINLINE float operator()(float V) const { return FMath::Clamp(V, MinValue, MaxValue); }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& V) const { return VectorMin(VectorMax(V, VMin), VMax); }
+	};
+
+	struct FCopyOp
+	{
+		FORCEINLINE float operator()(float, float B) const { return B; }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float&, const VectorRegister4Float& B) const { return B; }
+	};
+
+	struct FAddOp
+	{
+		FORCEINLINE float operator()(float A, float B) const { return A + B; }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& A, const VectorRegister4Float& B) const { return VectorAdd(A, B); }
+	};
+
+	struct FMultiplyOp
+	{
+		FORCEINLINE float operator()(float A, float B) const { return A * B; }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& A, const VectorRegister4Float& B) const { return VectorMultiply(A, B); }
+	};
+
+	struct FMinOp
+	{
+		FORCEINLINE float operator()(float A, float B) const { return FMath::Min(A, B); }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& A, const VectorRegister4Float& B) const { return VectorMin(A, B); }
+	};
+
+	struct FMaxOp
+	{
+		FORCEINLINE float operator()(float A, float B) const { return FMath::Max(A, B); }
+		FORCEINLINE VectorRegister4Float operator()(const VectorRegister4Float& A, const VectorRegister4Float& B) const { return VectorMax(A, B); }
+	};
+
+
+	// Drivers --------------------------------
+
+	template<typename OpType>
+	static void ApplyUnary(FGAGridMap& Map, const FGridBox& Box, const OpType& Op)
+	{
+		FGridBox ClippedBox;
+		if (!Map.IsValid() || !ClipBox(Box, Map.GridBounds, ClippedBox))
+		{
+			return;
+		}
+
+		if (IsWholeMap(Map, ClippedBox))
+		{
+			// Element-wise, so it doesn't matter what order the cells are in. Any layout padding goes along for the ride.
+			UnaryRun(Map.Data.GetData(), Map.Data.Num(), Op);
+		}
+		else
+		{
+			ForEachRun(Map.Data.GetData(), Map.GridBounds, ClippedBox, [&Op](float* Values, int32 Count) { UnaryRun(Values, Count, Op); });
+		}
+
+		Map.MarkDirty(ClippedBox);
+	}
+
+	template<typename OpType>
+	static void ApplyBinary(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box, const OpType& Op)
+	{
+		FGridBox DestBox, ClippedBox;
+		if (!Dest.IsValid() || !Source.IsValid() || !ClipBox(Box, Dest.GridBounds, DestBox) || !ClipBox(DestBox, Source.GridBounds, ClippedBox))
+		{
+			return;
+		}
+
+		if (IsWholeMap(Dest, ClippedBox) && IsWholeMap(Source, ClippedBox))
+		{
+			// Same bounds, same layout, so the arrays line up one to one
+			BinaryRun(Dest.Data.GetData(), Source.Data.GetData(), Dest.Data.Num(), Op);
+		}
+		else
+		{
+			ForEachRunPair(Dest.Data.GetData(), Dest.GridBounds, Source.Data.GetData(), Source.GridBounds, ClippedBox,
+				[&Op](float* DestValues, const float* SourceValues, int32 Count) { BinaryRun(DestValues, SourceValues, Count, Op); });
+		}
+
+		Dest.MarkDirty(ClippedBox);
+	}
+
+	// Call Body(Values, Count) over the cells of the map inside Box, skipping any layout padding
+	template<typename BodyType>
+	static bool ReduceRuns(const FGAGridMap& Map, const FGridBox& Box, BodyType Body)
+	{
+		FGridBox ClippedBox;
+		if (!Map.IsValid() || !ClipBox(Box, Map.GridBounds, ClippedBox))
+		{
+			return false;
+		}
+
+		if (GAGridLayout::bRowsAreContiguous && IsWholeMap(Map, ClippedBox))
+		{
+			Body(Map.Data.GetData(), Map.Data.Num());
+		}
+		else
+		{
+			ForEachRun(Map.Data.GetData(), Map.GridBounds, ClippedBox, Body);
+		}
+		return true;
+	}
+
+	static FORCEINLINE float HorizontalMin(const VectorRegister4Float& V)
+	{
+		MS_ALIGN(16) float Lanes[4] GCC_ALIGN(16);
+		VectorStoreAligned(V, Lanes);
+		return FMath::Min(FMath::Min(Lanes[0], Lanes[1]), FMath::Min(Lanes[2], Lanes[3]));
+	}
+
+	static FORCEINLINE float HorizontalMax(const VectorRegister4Float& V)
+	{
+		MS_ALIGN(16) float Lanes[4] GCC_ALIGN(16);
+		VectorStoreAligned(V, Lanes);
+		return FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+	}
+
+	static FORCEINLINE float HorizontalSum(const VectorRegister4Float& V)
+	{
+		MS_ALIGN(16) float Lanes[4] GCC_ALIGN(16);
+		VectorStoreAligned(V, Lanes);
+		return (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+	}
+
+
+	// Public --------------------------------
+
+	void Fill(FGAGridMap& Map, float Value)									{ ApplyUnary(Map, Map.GridBounds, FFillOp(Value)); }
+	void Fill(FGAGridMap& Map, const FGridBox& Box, float Value)			{ ApplyUnary(Map, Box, FFillOp(Value)); }
+
+	void Copy(FGAGridMap& Dest, const FGAGridMap& Source)					{ ApplyBinary(Dest, Source, Dest.GridBounds, FCopyOp()); }
+	void Add(FGAGridMap& Dest, const FGAGridMap& Source)					{ ApplyBinary(Dest, Source, Dest.GridBounds, FAddOp()); }
+	void Multiply(FGAGridMap& Dest, const FGAGridMap& Source)				{ ApplyBinary(Dest, Source, Dest.GridBounds, FMultiplyOp()); }
+	void Min(FGAGridMap& Dest, const FGAGridMap& Source)					{ ApplyBinary(Dest, Source, Dest.GridBounds, FMinOp()); }
+	void Max(FGAGridMap& Dest, const FGAGridMap& Source)					{ ApplyBinary(Dest, Source, Dest.GridBounds, FMaxOp()); }
+
+	void Copy(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box)		{ ApplyBinary(Dest, Source, Box, FCopyOp()); }
+	void Add(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box)		{ ApplyBinary(Dest, Source, Box, FAddOp()); }
+	void Multiply(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box)	{ ApplyBinary(Dest, Source, Box, FMultiplyOp()); }
+	void Min(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box)		{ ApplyBinary(Dest, Source, Box, FMinOp()); }
+	void Max(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box)		{ ApplyBinary(Dest, Source, Box, FMaxOp()); }
+
+	void ScaleBias(FGAGridMap& Map, float Scale, float Bias)						{ ApplyUnary(Map, Map.GridBounds, FScaleBiasOp(Scale, Bias)); }
+	void ScaleBias(FGAGridMap& Map, const FGridBox& Box, float Scale, float Bias)	{ ApplyUnary(Map, Box, FScaleBiasOp(Scale, Bias)); }
+
+	void Clamp(FGAGridMap& Map, float MinValue, float MaxValue)						{ ApplyUnary(Map, Map.GridBounds, FClampOp(MinValue, MaxValue)); }
+	void Clamp(FGAGridMap& Map, const FGridBox& Box, float MinValue, float MaxValue){ ApplyUnary(Map, Box, FClampOp(MinValue, MaxValue)); }
+
+
+	bool GetMinMax(const FGAGridMap& Map, float& MinOut, float& MaxOut)
+	{
+		return GetMinMax(Map, Map.GridBounds, MinOut, MaxOut);
+	}
+
+	bool GetMinMax(const FGAGridMap& Map, const FGridBox& Box, float& MinOut, float& MaxOut)
+	{
+		VectorRegister4Float VMin = VectorSetFloat1(UE_MAX_FLT);
+		VectorRegister4Float VMax = VectorSetFloat1(-UE_MAX_FLT);
+		float MinValue = UE_MAX_FLT;
+		float MaxValue = -UE_MAX_FLT;
+
+		bool bResult = ReduceRuns(Map, Box, [&](const float* Values, int32 Count)
+		{
+			int32 Index = 0;
+			for (; Index + 4 <= Count; Index += 4)
+			{
+				VectorRegister4Float V = VectorLoad(Values + Index);
+				VMin = VectorMin(VMin, V);
+				VMax = VectorMax(VMax, V);
+			}
+			for (; Index < Count; Index++)
+			{
+				MinValue = FMath::Min(MinValue, Values[Index]);
+				MaxValue = FMath::Max(MaxValue, Values[Index]);
+			}
+		});
+
+		if (bResult)
+		{
+			MinOut = FMath::Min(MinValue, HorizontalMin(VMin));
+			MaxOut = FMath::Max(MaxValue, HorizontalMax(VMax));
+		}
+		return bResult;
+	}
+
+
+	bool GetSum(const FGAGridMap& Map, float& SumOut)
+	{
+		return GetSum(Map, Map.GridBounds, SumOut);
+	}
+
+	// Box clipped to the map, in local coordinates, for the pyramid queries
+	static bool ClipBoxLocal(const FGAGridMap& Map, const FGridBox& Box, FGridBox& LocalBoxOut)
+	{
+		FGridBox ClippedBox;
+		if (!ClipBox(Box, Map.GridBounds, ClippedBox))
+		{
+			return false;
+		}
+		const FGridBox& Bounds = Map.GridBounds;
+		LocalBoxOut = FGridBox(ClippedBox.MinX - Bounds.MinX, ClippedBox.MaxX - Bounds.MinX, ClippedBox.MinY - Bounds.MinY, ClippedBox.MaxY - Bounds.MinY);
+		return true;
+	}
+
+	bool GetSum(const FGAGridMap& Map, const FGridBox& Box, float& SumOut)
+	{
+		if (const FGAGridMapPyramid* Pyramid = Map.GetPyramid())
+		{
+			FGridBox LocalBox;
+			if (!ClipBoxLocal(Map, Box, LocalBox))
+			{
+				return false;
+			}
+			SumOut = Pyramid->GetSum(Map, LocalBox);
+			return true;
+		}
+
+		VectorRegister4Float VSum = VectorZeroFloat();
+		float Sum = 0.0f;
+
+		bool bResult = ReduceRuns(Map, Box, [&](const float* Values, int32 Count)
+		{
+			int32 Index = 0;
+			for (; Index + 4 <= Count; Index += 4)
+			{
+				VSum = VectorAdd(VSum, VectorLoad(Values + Index));
+			}
+			for (; Index < Count; Index++)
+			{
+				Sum += Values[Index];
+			}
+		});
+
+		if (bResult)
+		{
+			SumOut = Sum + HorizontalSum(VSum);
+		}
+		return bResult;
+	}
+
+
+	bool ArgMax(const FGAGridMap& Map, FCellRef& CellOut, float& MaxOut)
+	{
+		return ArgMax(Map, Map.GridBounds, CellOut, MaxOut);
+	}
+
+	bool ArgMax(const FGAGridMap& Map, const FGridBox& Box, FCellRef& CellOut, float& MaxOut)
+	{
+		if (Map.HasPyramid())
+		{
+			TArray<FCellRef> Cells;
+			TArray<float> Values;
+			if (FindTopCells(Map, Box, 1, Cells, &Values) == 0)
+			{
+				return false;
+			}
+			CellOut = Cells[0];
+			MaxOut = Values[0];
+			return true;
+		}
+
+		float MinValue, MaxValue;
+		if (!GetMinMax(Map, Box, MinValue, MaxValue))
+		{
+			return false;
+		}
+
+		// Now we know the value, find the first cell that has it. This usually stops well short of the end.
+		FGridBox ClippedBox;
+		ClipBox(Box, Map.GridBounds, ClippedBox);
+
+		int32 Width = Map.GridBounds.GetWidth();
+		VectorRegister4Float VMax = VectorSetFloat1(MaxValue);
+
+		for (int32 LocalY = ClippedBox.MinY - Map.GridBounds.MinY; LocalY <= ClippedBox.MaxY - Map.GridBounds.MinY; LocalY++)
+		{
+			int32 LocalX = ClippedBox.MinX - Map.GridBounds.MinX;
+			int32 LocalMaxX = ClippedBox.MaxX - Map.GridBounds.MinX;
+
+			while (LocalX <= LocalMaxX)
+			{
+				int32 Count = FMath::Min(GAGridLayout::GetContiguousRun(LocalX, Width), LocalMaxX - LocalX + 1);
+				const float* Values = Map.Data.GetData() + GAGridLayout::GetIndex(LocalX, LocalY, Width);
+
+				int32 Index = 0;
+				int32 Found = INDEX_NONE;
+				for (; (Index + 4 <= Count) && (Found == INDEX_NONE); Index += 4)
+				{
+					int32 Mask = VectorMaskBits(VectorCompareEQ(VectorLoad(Values + Index), VMax));
+					if (Mask)
+					{
+						Found = Index + FMath::CountTrailingZeros(uint32(Mask));
+					}
+				}
+				for (; (Index < Count) && (Found == INDEX_NONE); Index++)
+				{
+					if (Values[Index] == MaxValue)
+					{
+						Found = Index;
+					}
+				}
+
+				if (Found != INDEX_NONE)
+				{
+					CellOut = FCellRef(Map.GridBounds.MinX + LocalX + Found, Map.GridBounds.MinY + LocalY);
+					MaxOut = MaxValue;
+					return true;
+				}
+
+				LocalX += Count;
+			}
+		}
+
+		// Only if the map holds NaNs
+		return false;
+	}
+
+
+	int32 FindTopCells(const FGAGridMap& Map, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut)
+	{
+		return FindTopCells(Map, Map.GridBounds, Count, CellsOut, ValuesOut);
+	}
+
+	int32 FindTopCells(const FGAGridMap& Map, const FGridBox& Box, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut)
+	{
+		CellsOut.Reset();
+		if (ValuesOut)
+		{
+			ValuesOut->Reset();
+		}
+
+		FGridBox LocalBox;
+		if (!Map.IsValid() || (Count <= 0) || !ClipBoxLocal(Map, Box, LocalBox))
+		{
+			return 0;
+		}
+
+		if (const FGAGridMapPyramid* Pyramid = Map.GetPyramid())
+		{
+			return Pyramid->FindTopCells(Map, LocalBox, Count, CellsOut, ValuesOut);
+		}
+
+		// No pyramid, so scan, keeping the best Count so far in a heap with the lowest on top
+		struct FEntry
+		{
+			float Value;
+			FCellRef Cell;
+		};
+		auto LowerValue = [](const FEntry& A, const FEntry& B) { return A.Value < B.Value; };
+
+		TArray<FEntry> Best;
+		Best.Reserve(Count + 1);
+		for (TGAGridMapCell<const float> Cell : Map.Cells(Box))
+		{
+			if (Best.Num() < Count)
+			{
+				Best.HeapPush(FEntry{ Cell.Value, FCellRef(Cell.X, Cell.Y) }, LowerValue);
+			}
+			else if (Cell.Value > Best.HeapTop().Value)
+			{
+				Best.HeapPopDiscard(LowerValue, EAllowShrinking::No);
+				Best.HeapPush(FEntry{ Cell.Value, FCellRef(Cell.X, Cell.Y) }, LowerValue);
+			}
+		}
+
+		Best.Sort([](const FEntry& A, const FEntry& B) { return A.Value > B.Value; });
+		for (const FEntry& Entry : Best)
+		{
+			CellsOut.Add(Entry.Cell);
+			if (ValuesOut)
+			{
+				ValuesOut->Add(Entry.Value);
+			}
+		}
+		return CellsOut.Num();
+	}
+
+
+	bool Normalize(FGAGridMap& Map)
+	{
+		return Normalize(Map, Map.GridBounds);
+	}
+
+	bool Normalize(FGAGridMap& Map, const FGridBox& Box)
+	{
+		float MinValue, MaxValue;
+		if (!GetMinMax(Map, Box, MinValue, MaxValue))
+		{
+			return false;
+		}
+
+		float Range = MaxValue - MinValue;
+		if (Range > 0.0f)
+		{
+			ScaleBias(Map, Box, 1.0f / Range, -MinValue / Range);
+		}
+		else
+		{
+			Fill(Map, Box, 0.0f);
+		}
+		return true;
+	}
+}
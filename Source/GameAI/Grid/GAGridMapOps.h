@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridMap.h"
+
+
+// Whole-map and sub-box operations on FGAGridMaps, vectorized four cells at a time.
+// Boxes are in grid cell coordinates (the same space as FGAGridMap::GridBounds), so maps with different
+// bounds line up by cell: a binary op only touches the cells both maps (and the box, if given) cover.
+// Everything works with any of the compile-time layouts (see GAGridLayout.h), but row-major is fastest,
+// since every row is then one contiguous run.
+// Ops that write to a map mark the cells they wrote dirty, if the map is tracking (see FGAGridMap::MarkDirty).
+
+namespace GAGridMapOps
+{
+	// Set every cell to Value
+	void Fill(FGAGridMap& Map, float Value);
+	void Fill(FGAGridMap& Map, const FGridBox& Box, float Value);
+
+	// Dest = Source, over the cells both maps cover
+	void Copy(FGAGridMap& Dest, const FGAGridMap& Source);
+	void Copy(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box);
+
+	// Dest = Dest op Source, over the cells both maps cover
+	void Add(FGAGridMap& Dest, const FGAGridMap& Source);
+	void Multiply(FGAGridMap& Dest, const FGAGridMap& Source);
+	void Min(FGAGridMap& Dest, const FGAGridMap& Source);
+	void Max(FGAGridMap& Dest, const FGAGridMap& Source);
+
+	// Same as above, restricted to Box
+	void Add(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box);
+	void Multiply(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box);
+	void Min(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box);
+	void Max(FGAGridMap& Dest, const FGAGridMap& Source, const FGridBox& Box);
+
+	// Value = Value * Scale + Bias
+	void ScaleBias(FGAGridMap& Map, float Scale, float Bias);
+	void ScaleBias(FGAGridMap& Map, const FGridBox& Box, float Scale, float Bias);
+
+	void Clamp(FGAGridMap& Map, float MinValue, float MaxValue);
+	void Clamp(FGAGridMap& Map, const FGridBox& Box, float MinValue, float MaxValue);
+
+	// Reductions. These return false (and leave the outputs alone) if the map, or its overlap with Box, is empty.
+	// GetSum (and the max queries below) go through the map's pyramid if it has one.
+	bool GetMinMax(const FGAGridMap& Map, float& MinOut, float& MaxOut);
+	bool GetMinMax(const FGAGridMap& Map, const FGridBox& Box, float& MinOut, float& MaxOut);
+
+	bool GetSum(const FGAGridMap& Map, float& SumOut);
+	bool GetSum(const FGAGridMap& Map, const FGridBox& Box, float& SumOut);
+
+	// The cell with the highest value. Ties go to the first cell in row order (or any of them, if the map has a pyramid).
+	bool ArgMax(const FGAGridMap& Map, FCellRef& CellOut, float& MaxOut);
+	bool ArgMax(const FGAGridMap& Map, const FGridBox& Box, FCellRef& CellOut, float& MaxOut);
+
+	// Up to Count cells with the highest values, best first. Returns how many were found.
+	// Best used on a map with a pyramid (see FGAGridMap::SetPyramidEnabled), which only visits the blocks that can
+	// hold one of the winners; otherwise it's a full scan.
+	int32 FindTopCells(const FGAGridMap& Map, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut = NULL);
+	int32 FindTopCells(const FGAGridMap& Map, const FGridBox& Box, int32 Count, TArray<FCellRef>& CellsOut, TArray<float>* ValuesOut = NULL);
+
+	// Remap values linearly so the lowest becomes 0 and the highest 1. If they're all the same, they all become 0.
+	bool Normalize(FGAGridMap& Map);
+	bool Normalize(FGAGridMap& Map, const FGridBox& Box);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridMap.h"
+#include "GATypedGridMap.h"
+
+
+// Recycled storage for short-lived grid maps.
+//
+// Perception and spatial reasoning build several full-grid temporaries per agent per frame. Rather than allocating
+// and freeing a TArray for each one, borrow a map through a TGAScopedGridMap: its Data comes out of a pool of
+// buffers and goes back when the handle goes out of scope, so once every size in use has been seen once there
+// are no more heap allocations.
+//
+//		FGAScopedGridMap DistanceMap(Grid, GridBox, FLT_MAX);
+//		PathComp->Dijkstra(StartPoint, *DistanceMap);
+//
+// Buffers are bucketed by power-of-two capacity, so a borrowed buffer may be up to twice the size it needs to be.
+// The pools are game thread only.
+
+template<typename ValueType>
+class TGAGridMapBufferPool
+{
+public:
+	static TGAGridMapBufferPool& Get()
+	{
+		static TGAGridMapBufferPool Pool;
+		return Pool;
+	}
+
+	// A buffer with Num() == Count. The contents are uninitialized.
+	TArray<ValueType> Acquire(int32 Count)
+	{
+		check(IsInGameThread());
+
+		TArray<ValueType> Buffer;
+		if (Count > 0)
+		{
+			const uint32 BucketIndex = FMath::CeilLogTwo(uint32(Count));
+			TArray<TArray<ValueType>>& Bucket = Buckets[BucketIndex];
+			if (Bucket.Num() > 0)
+			{
+				Buffer = Bucket.Pop(EAllowShrinking::No);
+				ReuseCount++;
+			}
+			else
+			{
+				Buffer.Reserve(1 << BucketIndex);
+				AllocationCount++;
+			}
+
+			Buffer.SetNumUninitialized(Count, EAllowShrinking::No);
+		}
+		return Buffer;
+	}
+
+	// Hand a buffer back. Buffer is left empty.
+	void Release(TArray<ValueType>& Buffer)
+	{
+		check(IsInGameThread());
+
+		const int32 Capacity = Buffer.Max();
+		if (Capacity > 0)
+		{
+			// Any buffer that holds at least 2^N elements can serve bucket N
+			TArray<TArray<ValueType>>& Bucket = Buckets[FMath::FloorLog2(uint32(Capacity))];
+			if (Bucket.Num() < MaxBuffersPerBucket)
+			{
+				Buffer.Reset();
+				Bucket.Add(MoveTemp(Buffer));
+			}
+		}
+		Buffer.Empty();
+	}
+
+	// Free every pooled buffer
+	void Trim()
+	{
+		check(IsInGameThread());
+
+		for (TArray<TArray<ValueType>>& Bucket : Buckets)
+		{
+			Bucket.Empty();
+		}
+	}
+
+	// Heap allocations made, and acquisitions served from the pool, since startup
+	int32 GetAllocationCount() const { return AllocationCount; }
+	int32 GetReuseCount() const { return ReuseCount; }
+
+	// Bytes currently sitting in the pool
+	SIZE_T GetPooledSize() const
+	{
+		SIZE_T Result = 0;
+		for (const TArray<TArray<ValueType>>& Bucket : Buckets)
+		{
+			for (const TArray<ValueType>& Buffer : Bucket)
+			{
+				Result += Buffer.GetAllocatedSize();
+			}
+		}
+		return Result;
+	}
+
+	// More than this many idle buffers of one size are freed rather than kept
+	static constexpr int32 MaxBuffersPerBucket = 16;
+
+private:
+	TArray<TArray<ValueType>> Buckets[32];
+
+	int32 AllocationCount = 0;
+	int32 ReuseCount = 0;
+};
+
+
+// A grid map (FGAGridMap or any TGAGridMap) whose storage is borrowed from TGAGridMapBufferPool for as long as
+// the handle is in scope. Use it like a pointer to the map. The map can be copied out if it needs to outlive the
+// handle; the copy gets its own storage.
+template<typename MapType>
+class TGAScopedGridMap
+{
+public:
+	typedef typename decltype(MapType::Data)::ElementType ValueType;
+	typedef TGAGridMapBufferPool<ValueType> PoolType;
+
+	// Values start out at InitialValue
+	TGAScopedGridMap(const AGAGridActor* Grid, float InitialValue)
+		: TGAScopedGridMap(Grid->XCount, Grid->YCount, FGridBox(0, Grid->XCount - 1, 0, Grid->YCount - 1))
+	{
+		Map.ResetData(InitialValue);
+	}
+
+	TGAScopedGridMap(const AGAGridActor* Grid, const FGridBox& GridBox, float InitialValue)
+		: TGAScopedGridMap(Grid->XCount, Grid->YCount, GridBox)
+	{
+		Map.ResetData(InitialValue);
+	}
+
+	// Values are uninitialized, for callers that are about to overwrite all of them
+	TGAScopedGridMap(int32 XCount, int32 YCount, const FGridBox& GridBox)
+	{
+		Map.XCount = XCount;
+		Map.YCount = YCount;
+		Map.GridBounds = GridBox;
+		if (GridBox.IsValid())
+		{
+			Map.Data = PoolType::Get().Acquire(GAGridLayout::GetAllocatedCount(GridBox.GetWidth(), GridBox.GetHeight()));
+		}
+	}
+
+	~TGAScopedGridMap()
+	{
+		PoolType::Get().Release(Map.Data);
+	}
+
+	TGAScopedGridMap(const TGAScopedGridMap&) = delete;
+	TGAScopedGridMap& operator=(const TGAScopedGridMap&) = delete;
+
+	MapType& Get() { return Map; }
+	const MapType& Get() const { return Map; }
+
+	MapType& operator*() { return Map; }
+	const MapType& operator*() const { return Map; }
+
+	MapType* operator->() { return &Map; }
+	const MapType* operator->() const { return &Map; }
+
+private:
+	MapType Map;
+};
+
+typedef TGAScopedGridMap<FGAGridMap> FGAScopedGridMap;
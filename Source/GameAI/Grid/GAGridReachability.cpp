@@ -0,0 +1,214 @@
+#include "GAGridReachability.h"
+#include "GAGridActor.h"
+#include "GAGridMapOps.h"
+
+
+// The least the distance map grows by, on every side, when the search gets to its edge
+static const int32 MinGrowCells = 16;
+
+
+void FGAGridReachability::Reset()
+{
+	SearchGrid = FObjectKey();
+	SearchGridVersion = INDEX_NONE;
+	Origin = FCellRef::Invalid;
+	ReachedDistance = -1.0f;
+	Distances = FGAGridMap();
+	Reported = TGAGridMap<uint8>();
+	TouchedBox = FGridBox();
+	ReachedBox = FGridBox();
+	ReportedBox = FGridBox();
+	OpenCells.Empty();
+}
+
+bool FGAGridReachability::Start(const AGAGridActor* Grid, const FCellRef& InOrigin)
+{
+	if (!Grid || !Grid->IsCellTraversable(InOrigin))
+	{
+		Reset();
+		return false;
+	}
+
+	// Same grid as last time: keep the maps, and only clear what the last search wrote
+	if ((SearchGrid == FObjectKey(Grid)) && Distances.IsValid() && (Distances.XCount == Grid->XCount) && (Distances.YCount == Grid->YCount))
+	{
+		const FGridBox ClearBox = ReportedBox.GetOverlap(Reported.GridBounds);
+		for (int32 Y = ClearBox.MinY; Y <= ClearBox.MaxY; Y++)
+		{
+			for (int32 X = ClearBox.MinX; X <= ClearBox.MaxX; X++)
+			{
+				Reported.GetStoredValueUnchecked(X, Y) = 0;
+			}
+		}
+	}
+	else
+	{
+		Distances = FGAGridMap();
+		Reported = TGAGridMap<uint8>();
+		TouchedBox = FGridBox();
+	}
+
+	SearchGrid = FObjectKey(Grid);
+	Origin = InOrigin;
+	ReportedBox = FGridBox();
+	Restart(Grid);
+	return true;
+}
+
+void FGAGridReachability::Restart(const AGAGridActor* Grid)
+{
+	GAGridMapOps::Fill(Distances, TouchedBox, FLT_MAX);
+
+	SearchGridVersion = Grid->GetGridVersion();
+	ReachedDistance = -1.0f;
+	ReachedBox = FGridBox();
+
+	if (!Distances.GridBounds.IsValidCell(Origin.X, Origin.Y))
+	{
+		GrowToCover(Grid, Origin);
+	}
+	Distances.SetValueUnchecked(Origin.X, Origin.Y, 0.0f);
+	TouchedBox = FGridBox(Origin.X, Origin.X, Origin.Y, Origin.Y);
+
+	OpenCells.Reset();
+	OpenCells.HeapPush(FOpenCell{ Origin, 0.0f });
+}
+
+void FGAGridReachability::GrowToCover(const AGAGridActor* Grid, const FCellRef& Cell)
+{
+	const FGridBox OldBounds = Distances.IsValid() ? Distances.GridBounds : FGridBox();
+	const FGridBox CellBox(Cell.X, Cell.X, Cell.Y, Cell.Y);
+	const FGridBox Needed = OldBounds.IsValid() ? OldBounds.GetUnion(CellBox) : CellBox;
+
+	// Half again the size on every side, so a search that keeps spreading only regrows a logarithmic number of times
+	const int32 Margin = FMath::Max(FMath::Max(Needed.GetWidth(), Needed.GetHeight()) / 2, MinGrowCells);
+	const FGridBox NewBounds = FGridBox(Needed.MinX - Margin, Needed.MaxX + Margin, Needed.MinY - Margin, Needed.MaxY + Margin)
+		.GetOverlap(FGridBox(0, Grid->XCount - 1, 0, Grid->YCount - 1));
+
+	FGAGridMap NewDistances(Grid, NewBounds, FLT_MAX);
+	TGAGridMap<uint8> NewReported(Grid, NewBounds, 0.0f);
+	if (OldBounds.IsValid())
+	{
+		GAGridMapOps::Copy(NewDistances, Distances);
+
+		const FGridBox CopyBox = ReportedBox.GetOverlap(OldBounds);
+		for (int32 Y = CopyBox.MinY; Y <= CopyBox.MaxY; Y++)
+		{
+			for (int32 X = CopyBox.MinX; X <= CopyBox.MaxX; X++)
+			{
+				NewReported.GetStoredValueUnchecked(X, Y) = Reported.GetStoredValueUnchecked(X, Y);
+			}
+		}
+	}
+
+	Distances = MoveTemp(NewDistances);
+	Reported = MoveTemp(NewReported);
+}
+
+void FGAGridReachability::Expand(const AGAGridActor* Grid, float MaxDistance, TArray<FCellRef>* NewCellsOut)
+{
+	if (!IsStarted() || !Grid)
+	{
+		return;
+	}
+
+	if (SearchGrid != FObjectKey(Grid))
+	{
+		if (!Start(Grid, FCellRef(Origin)))
+		{
+			return;
+		}
+	}
+	else if (SearchGridVersion != Grid->GetGridVersion())
+	{
+		// The old distances could be through cells that are blocked now (or the long way round ones that have opened
+		// up). Only the cells the search has looked at matter: those with a distance, and the blocked ones next to
+		// them. Anything further out gets looked at as it is when the search gets there.
+		const FGridBox CheckBox(TouchedBox.MinX - 1, TouchedBox.MaxX + 1, TouchedBox.MinY - 1, TouchedBox.MaxY + 1);
+		if (Grid->GetRegionVersion(FIntRect(CheckBox.MinX, CheckBox.MinY, CheckBox.MaxX, CheckBox.MaxY)) > SearchGridVersion)
+		{
+			if (!Grid->IsCellTraversable(Origin))
+			{
+				Reset();
+				return;
+			}
+			Restart(Grid);
+		}
+		SearchGridVersion = Grid->GetGridVersion();
+	}
+
+	if (Grid->HasTraversalCosts())
+	{
+		ExpandInternal<true>(Grid, MaxDistance, NewCellsOut);
+	}
+	else
+	{
+		ExpandInternal<false>(Grid, MaxDistance, NewCellsOut);
+	}
+}
+
+template<bool bWithCost>
+void FGAGridReachability::ExpandInternal(const AGAGridActor* Grid, float MaxDistance, TArray<FCellRef>* NewCellsOut)
+{
+	if (MaxDistance <= ReachedDistance)
+	{
+		return;
+	}
+
+	const float DiagonalDistance = UE_SQRT_2 * Grid->CellScale;
+	FCellNeighbors Neighbors;			// inline storage, so expanding a cell doesn't allocate
+
+	while ((OpenCells.Num() > 0) && (OpenCells.HeapTop().Distance <= MaxDistance))
+	{
+		FOpenCell Current;
+		OpenCells.HeapPop(Current, EAllowShrinking::No);
+
+		// A stale entry, the cell was pushed again with a shorter distance (and has been settled from that one)
+		if (Current.Distance > Distances.GetValueUnchecked(Current.Cell.X, Current.Cell.Y))
+		{
+			continue;
+		}
+
+		ReachedBox = ReachedBox.GetUnion(FGridBox(Current.Cell.X, Current.Cell.X, Current.Cell.Y, Current.Cell.Y));
+
+		// After a restart, most of what gets settled was handed out the first time round
+		uint8& bReported = Reported.GetStoredValueUnchecked(Current.Cell.X, Current.Cell.Y);
+		if (!bReported)
+		{
+			bReported = 1;
+			ReportedBox = ReportedBox.GetUnion(FGridBox(Current.Cell.X, Current.Cell.X, Current.Cell.Y, Current.Cell.Y));
+			if (NewCellsOut)
+			{
+				NewCellsOut->Add(Current.Cell);
+			}
+		}
+
+		Grid->GetNeighbors(Current.Cell, true, Neighbors);
+		for (const FCellRef& NCell : Neighbors)
+		{
+			const bool bDiagonal = (NCell.X != Current.Cell.X) && (NCell.Y != Current.Cell.Y);
+			float StepLength = bDiagonal ? DiagonalDistance : Grid->CellScale;
+			if constexpr (bWithCost)
+			{
+				StepLength *= Grid->GetTraversalCostMultiplier(Grid->CellRefToIndex(NCell));
+			}
+
+			// Neighbors are always on the grid, but not always on the part Distances covers yet
+			if (!Distances.GridBounds.IsValidCell(NCell.X, NCell.Y))
+			{
+				GrowToCover(Grid, NCell);
+			}
+
+			const float Distance = Current.Distance + StepLength;
+			float& BestDistance = Distances.GetValueUnchecked(NCell.X, NCell.Y);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				TouchedBox = TouchedBox.GetUnion(FGridBox(NCell.X, NCell.X, NCell.Y, NCell.Y));
+				OpenCells.HeapPush(FOpenCell{ NCell, Distance });
+			}
+		}
+	}
+
+	ReachedDistance = MaxDistance;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "GAGridMap.h"
+#include "GATypedGridMap.h"
+
+
+// A path distance field out from one cell that only ever gets as far as it's been asked to.
+//
+// It's the same search as UGAPathComponent::Dijkstra (same neighbors, same traversal costs), but the open list is
+// kept between calls: Expand(MaxDistance) settles every cell within MaxDistance of the origin and stops there, and
+// the next call with a bigger distance carries on from the same frontier. Growing the distance bit by bit (say, a
+// hidden target's max speed times the time since it was seen) costs about the same in total as one search out to
+// the final distance, and each call only touches the cells it settles and their neighbors.
+//
+//		Reachability.Start(Grid, LastSeenCell);
+//		...
+//		Reachability.Expand(MaxSpeed * TimeSinceSeen, &NewCells);
+//		if (Reachability.IsReached(X, Y)) ...
+//
+// Distances are in world units along the path. Cells a search never got to read as FLT_MAX.
+//
+// Memory goes with the area the search has covered, not the size of the grid: the distances live in a map over a
+// box that grows (by half again each time, so growing is cheap on average) as the frontier gets to its edge.
+
+class AGAGridActor;
+
+class FGAGridReachability
+{
+public:
+	// Start a new search out from Origin, forgetting the old one. Only the cells the old one touched get cleared.
+	// Returns false (and leaves nothing reached) if Origin isn't a traversable cell of Grid.
+	bool Start(const AGAGridActor* Grid, const FCellRef& Origin);
+
+	// Settle every cell within MaxDistance of the origin that isn't already. The cells settled for the first time
+	// since Start are added to NewCellsOut, if given, nearest first.
+	// If cells the search has looked at changed since the last call, the distances are worked out again from the
+	// origin. Cells that were handed out before aren't handed out again when the new search gets to them.
+	void Expand(const AGAGridActor* Grid, float MaxDistance, TArray<FCellRef>* NewCellsOut = nullptr);
+
+	bool IsStarted() const { return Origin.IsValid(); }
+	const FCellRef& GetOrigin() const { return Origin; }
+
+	// How far the search has got
+	float GetReachedDistance() const { return ReachedDistance; }
+
+	// Bounds of the settled cells (invalid if there aren't any)
+	const FGridBox& GetReachedBox() const { return ReachedBox; }
+
+	// Path distance from the origin to X, Y, if the search has settled it, or FLT_MAX
+	float GetDistance(int32 X, int32 Y) const
+	{
+		float Distance = FLT_MAX;
+		return (Distances.GetValue(FCellRef(X, Y), Distance) && (Distance <= ReachedDistance)) ? Distance : FLT_MAX;
+	}
+
+	bool IsReached(int32 X, int32 Y) const { return GetDistance(X, Y) != FLT_MAX; }
+
+	// Free everything
+	void Reset();
+
+private:
+	template<bool bWithCost>
+	void ExpandInternal(const AGAGridActor* Grid, float MaxDistance, TArray<FCellRef>* NewCellsOut);
+
+	// Throw the distances away and start the search again from the origin, keeping what's been handed out
+	void Restart(const AGAGridActor* Grid);
+
+	// Grow Distances and Reported to take in Cell, with room to spare
+	void GrowToCover(const AGAGridActor* Grid, const FCellRef& Cell);
+
+	struct FOpenCell
+	{
+		FCellRef Cell;
+		float Distance;
+
+		bool operator<(const FOpenCell& Other) const { return Distance < Other.Distance; }
+	};
+
+	// Grid the search runs on, and its version when the search was last checked against it
+	FObjectKey SearchGrid;
+	int32 SearchGridVersion = INDEX_NONE;
+
+	FCellRef Origin;
+	float ReachedDistance = -1.0f;
+
+	// Best distance found so far for every cell the search has touched (FLT_MAX elsewhere). Cells are only settled
+	// once everything nearer is, so a distance <= ReachedDistance is final; anything else is still on the frontier.
+	// Covers only part of the grid, see GrowToCover.
+	FGAGridMap Distances;
+
+	// 1 (stored) for the cells handed out through NewCellsOut since Start, 0 elsewhere. Same bounds as Distances.
+	TGAGridMap<uint8> Reported;
+
+	// Bounds of every cell with a distance in it, which is all a restart has to clear
+	FGridBox TouchedBox;
+	FGridBox ReachedBox;
+
+	// Bounds of the cells marked in Reported, which is all Start has to clear
+	FGridBox ReportedBox;
+
+	// The frontier. A cell can be on here more than once; only the entry matching its best distance counts.
+	TArray<FOpenCell> OpenCells;
+};
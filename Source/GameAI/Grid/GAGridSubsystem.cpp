@@ -0,0 +1,276 @@
+#include "GAGridSubsystem.h"
+#include "GAGridActor.h"
+#include "Engine/World.h"
+
+
+UGAGridSubsystem* UGAGridSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : NULL;
+	return World ? World->GetSubsystem<UGAGridSubsystem>() : NULL;
+}
+
+
+void UGAGridSubsystem::RegisterGrid(AGAGridActor* Grid)
+{
+	if (Grid && !Grids.Contains(Grid))
+	{
+		Grids.Add(Grid);
+		RebuildBuckets();
+	}
+}
+
+
+void UGAGridSubsystem::UnregisterGrid(AGAGridActor* Grid)
+{
+	if (Grids.Remove(Grid) > 0)
+	{
+		for (auto It = TransitionCache.CreateIterator(); It; ++It)
+		{
+			if ((It.Key().Key == Grid) || (It.Key().Value == Grid))
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		RebuildBuckets();
+	}
+}
+
+
+void UGAGridSubsystem::UpdateGrid(AGAGridActor* Grid)
+{
+	if (Grids.Contains(Grid))
+	{
+		RebuildBuckets();
+	}
+}
+
+
+FBox2D UGAGridSubsystem::ComputeGridBounds(const AGAGridActor* Grid) const
+{
+	const FGAGridAffine& Affine = Grid->GetGridAffine();
+	FBox2D Bounds(EForceInit::ForceInit);
+
+	Bounds += FVector2D(Affine.GridToWorld(FVector2D(0.0f, 0.0f)));
+	Bounds += FVector2D(Affine.GridToWorld(FVector2D(Grid->XCount, 0.0f)));
+	Bounds += FVector2D(Affine.GridToWorld(FVector2D(0.0f, Grid->YCount)));
+	Bounds += FVector2D(Affine.GridToWorld(FVector2D(Grid->XCount, Grid->YCount)));
+
+	return Bounds;
+}
+
+
+void UGAGridSubsystem::RebuildBuckets()
+{
+	// There are only ever a handful of grids, so just redo the lot
+	Grids.RemoveAll([](const TWeakObjectPtr<AGAGridActor>& Grid) { return !Grid.IsValid(); });
+
+	Buckets.Reset();
+	GridBounds.SetNum(Grids.Num());
+
+	for (int32 GridIndex = 0; GridIndex < Grids.Num(); GridIndex++)
+	{
+		FBox2D Bounds = ComputeGridBounds(Grids[GridIndex].Get());
+		GridBounds[GridIndex] = Bounds;
+
+		FIntPoint MinBucket(FMath::FloorToInt32(Bounds.Min.X / BucketSize), FMath::FloorToInt32(Bounds.Min.Y / BucketSize));
+		FIntPoint MaxBucket(FMath::FloorToInt32(Bounds.Max.X / BucketSize), FMath::FloorToInt32(Bounds.Max.Y / BucketSize));
+
+		for (int32 BucketY = MinBucket.Y; BucketY <= MaxBucket.Y; BucketY++)
+		{
+			for (int32 BucketX = MinBucket.X; BucketX <= MaxBucket.X; BucketX++)
+			{
+				Buckets.FindOrAdd(FIntPoint(BucketX, BucketY)).Add(GridIndex);
+			}
+		}
+	}
+}
+
+
+AGAGridActor* UGAGridSubsystem::FindGridAt(const FVector& Point) const
+{
+	const TArray<int32, TInlineAllocator<4>>* Bucket = Buckets.Find(FIntPoint(FMath::FloorToInt32(Point.X / BucketSize), FMath::FloorToInt32(Point.Y / BucketSize)));
+	if (!Bucket)
+	{
+		return NULL;
+	}
+
+	AGAGridActor* BestGrid = NULL;
+	float BestDistanceZ = FLT_MAX;
+
+	for (int32 GridIndex : *Bucket)
+	{
+		AGAGridActor* Grid = Grids[GridIndex].Get();
+		if (Grid && GridBounds[GridIndex].IsInsideOrOn(FVector2D(Point)))
+		{
+			FCellRef Cell = Grid->GetCellRef(Point);
+			if (Cell.IsValid())
+			{
+				float DistanceZ = FMath::Abs(Point.Z - Grid->GetCellFloorPosition(Cell).Z);
+				if (DistanceZ < BestDistanceZ)
+				{
+					BestDistanceZ = DistanceZ;
+					BestGrid = Grid;
+				}
+			}
+		}
+	}
+
+	return BestGrid;
+}
+
+
+AGAGridActor* UGAGridSubsystem::GetDefaultGrid() const
+{
+	for (const TWeakObjectPtr<AGAGridActor>& Grid : Grids)
+	{
+		if (Grid.IsValid())
+		{
+			return Grid.Get();
+		}
+	}
+
+	return NULL;
+}
+
+
+bool UGAGridSubsystem::FindGridRoute(const AGAGridActor* From, const AGAGridActor* To, TArray<const AGAGridActor*>& RouteOut) const
+{
+	int32 FromIndex = Grids.IndexOfByKey(From);
+	int32 ToIndex = Grids.IndexOfByKey(To);
+	if ((FromIndex == INDEX_NONE) || (ToIndex == INDEX_NONE))
+	{
+		return false;
+	}
+
+	// Breadth-first over the overlap graph. Fewest hops is good enough with this few grids.
+	TArray<int32> Previous;
+	Previous.Init(INDEX_NONE, Grids.Num());
+	Previous[FromIndex] = FromIndex;
+
+	TArray<int32> Queue;
+	Queue.Add(FromIndex);
+
+	for (int32 QueueIndex = 0; (QueueIndex < Queue.Num()) && (Previous[ToIndex] == INDEX_NONE); QueueIndex++)
+	{
+		int32 Current = Queue[QueueIndex];
+		for (int32 Other = 0; Other < Grids.Num(); Other++)
+		{
+			if ((Previous[Other] == INDEX_NONE) && Grids[Other].IsValid() && GridBounds[Current].Intersect(GridBounds[Other]))
+			{
+				Previous[Other] = Current;
+				Queue.Add(Other);
+			}
+		}
+	}
+
+	if (Previous[ToIndex] == INDEX_NONE)
+	{
+		return false;
+	}
+
+	RouteOut.Reset();
+	for (int32 Current = ToIndex; Current != FromIndex; Current = Previous[Current])
+	{
+		RouteOut.Insert(Grids[Current].Get(), 0);
+	}
+	RouteOut.Insert(From, 0);
+
+	return true;
+}
+
+
+// The cells of Grid under the world-space box Overlap (inclusive, clipped to the grid)
+static FIntRect GetCellRectUnder(const AGAGridActor* Grid, const FBox2D& Overlap)
+{
+	const FGAGridAffine& Affine = Grid->GetGridAffine();
+	FBox2D GridSpaceOverlap(EForceInit::ForceInit);
+	GridSpaceOverlap += Affine.WorldToGrid(FVector(Overlap.Min.X, Overlap.Min.Y, 0.0f));
+	GridSpaceOverlap += Affine.WorldToGrid(FVector(Overlap.Max.X, Overlap.Min.Y, 0.0f));
+	GridSpaceOverlap += Affine.WorldToGrid(FVector(Overlap.Min.X, Overlap.Max.Y, 0.0f));
+	GridSpaceOverlap += Affine.WorldToGrid(FVector(Overlap.Max.X, Overlap.Max.Y, 0.0f));
+
+	return FIntRect(
+		FMath::Max(FMath::FloorToInt32(GridSpaceOverlap.Min.X), 0), FMath::Max(FMath::FloorToInt32(GridSpaceOverlap.Min.Y), 0),
+		FMath::Min(FMath::FloorToInt32(GridSpaceOverlap.Max.X), Grid->XCount - 1), FMath::Min(FMath::FloorToInt32(GridSpaceOverlap.Max.Y), Grid->YCount - 1));
+}
+
+
+const UGAGridSubsystem::FTransitionCache& UGAGridSubsystem::GetTransitions(const AGAGridActor* From, const AGAGridActor* To) const
+{
+	FTransitionCache& Cache = TransitionCache.FindOrAdd(TPair<const AGAGridActor*, const AGAGridActor*>(From, To));
+
+	// Only the part of From that lies under To's bounds can possibly join up
+	FBox2D FromBounds = ComputeGridBounds(From);
+	FBox2D ToBounds = ComputeGridBounds(To);
+	if (!FromBounds.Intersect(ToBounds))
+	{
+		Cache.FromRect = Cache.ToRect = FIntRect();
+		Cache.FromVersion = Cache.ToVersion = INDEX_NONE;
+		Cache.Points.Reset();
+		return Cache;
+	}
+
+	FBox2D Overlap(FVector2D::Max(FromBounds.Min, ToBounds.Min), FVector2D::Min(FromBounds.Max, ToBounds.Max));
+	const FIntRect FromRect = GetCellRectUnder(From, Overlap);
+	const FIntRect ToRect = GetCellRectUnder(To, Overlap);
+
+	// Changes anywhere else on either grid (say, an obstacle moving about in the middle of one) don't matter
+	const int32 FromVersion = From->GetRegionVersion(FromRect);
+	const int32 ToVersion = To->GetRegionVersion(ToRect);
+	if ((Cache.FromRect == FromRect) && (Cache.ToRect == ToRect) && (Cache.FromVersion == FromVersion) && (Cache.ToVersion == ToVersion))
+	{
+		return Cache;
+	}
+
+	Cache.FromRect = FromRect;
+	Cache.ToRect = ToRect;
+	Cache.FromVersion = FromVersion;
+	Cache.ToVersion = ToVersion;
+	Cache.Points.Reset();
+
+	for (int32 Y = FromRect.Min.Y; Y <= FromRect.Max.Y; Y++)
+	{
+		for (int32 X = FromRect.Min.X; X <= FromRect.Max.X; X++)
+		{
+			FCellRef FromCell(X, Y);
+			if (!From->IsCellTraversable(FromCell))
+			{
+				continue;
+			}
+
+			FVector FloorPosition = From->GetCellFloorPosition(FromCell);
+			FCellRef ToCell = To->GetCellRef(FloorPosition);
+			if (To->IsCellTraversable(ToCell) && (FMath::Abs(To->GetCellFloorPosition(ToCell).Z - FloorPosition.Z) <= MaxTransitionStepHeight))
+			{
+				Cache.Points.Add(FloorPosition);
+			}
+		}
+	}
+
+	return Cache;
+}
+
+
+bool UGAGridSubsystem::FindTransitionPoint(const AGAGridActor* From, const AGAGridActor* To, const FVector& Near, FVector& PointOut) const
+{
+	if (!From || !To || (From == To))
+	{
+		return false;
+	}
+
+	const FTransitionCache& Cache = GetTransitions(From, To);
+
+	float BestDistanceSquared = FLT_MAX;
+	for (const FVector& Point : Cache.Points)
+	{
+		float DistanceSquared = FVector::DistSquared(Point, Near);
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			PointOut = Point;
+		}
+	}
+
+	return BestDistanceSquared < FLT_MAX;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GAGridSubsystem.generated.h"
+
+
+class AGAGridActor;
+
+// Keeps track of every AGAGridActor in the world, and answers "which grid is this point on?"
+// Grids register themselves when their components are registered, so this works in the editor as well as in game.
+// Lookups go through a coarse 2D bucket index over the grids' world-space bounds, so they never iterate over actors.
+// Grids can overlap -- stacked floors of a building, or neighboring zones that share a strip of cells -- and
+// FindGridRoute / FindTransitionPoint let a path cross from one to the next where they do.
+
+UCLASS()
+class UGAGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UGAGridSubsystem* Get(const UObject* WorldContextObject);
+
+	void RegisterGrid(AGAGridActor* Grid);
+	void UnregisterGrid(AGAGridActor* Grid);
+
+	// Re-index a grid after it moves or changes size
+	void UpdateGrid(AGAGridActor* Grid);
+
+	// Return the grid that contains the given world point, or NULL if there isn't one.
+	// If several grids contain it (stacked floors), the one whose floor is nearest in Z wins.
+	UFUNCTION(BlueprintCallable)
+	AGAGridActor* FindGridAt(const FVector& Point) const;
+
+	// The first grid registered, for callers that have no position to go on (or are off every grid)
+	UFUNCTION(BlueprintCallable)
+	AGAGridActor* GetDefaultGrid() const;
+
+	const TArray<TWeakObjectPtr<AGAGridActor>>& GetAllGrids() const { return Grids; }
+
+	// Return the sequence of grids to cross to get from one grid to another, including both ends.
+	// Grids are connected if their bounds overlap. Returns false if there is no such route.
+	bool FindGridRoute(const AGAGridActor* From, const AGAGridActor* To, TArray<const AGAGridActor*>& RouteOut) const;
+
+	// Find a point where an agent can step straight from one grid onto another: a traversable cell on From
+	// whose floor is also on a traversable cell of To, at about the same height. Of those, picks the one closest to Near.
+	bool FindTransitionPoint(const AGAGridActor* From, const AGAGridActor* To, const FVector& Near, FVector& PointOut) const;
+
+	// Side length of a bucket in the spatial index, in world units
+	static constexpr float BucketSize = 5000.0f;
+
+	// How far apart in Z two floors can be and still count as joined in FindTransitionPoint
+	static constexpr float MaxTransitionStepHeight = 50.0f;
+
+private:
+	TArray<TWeakObjectPtr<AGAGridActor>> Grids;
+
+	// World-space 2D bounds of each grid, parallel to Grids
+	TArray<FBox2D> GridBounds;
+
+	// Bucket -> indices into Grids
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<4>>> Buckets;
+
+	// Every transition point between a pair of grids, worked out on demand and thrown away when the cells where they
+	// overlap change on either grid (or the overlap itself moves)
+	struct FTransitionCache
+	{
+		FIntRect FromRect;
+		FIntRect ToRect;
+		int32 FromVersion = INDEX_NONE;
+		int32 ToVersion = INDEX_NONE;
+		TArray<FVector> Points;
+	};
+
+	mutable TMap<TPair<const AGAGridActor*, const AGAGridActor*>, FTransitionCache> TransitionCache;
+
+	const FTransitionCache& GetTransitions(const AGAGridActor* From, const AGAGridActor* To) const;
+
+	FBox2D ComputeGridBounds(const AGAGridActor* Grid) const;
+	void RebuildBuckets();
+};
@@ -0,0 +1,175 @@
+#include "GAParticleFilter.h"
+#include "GAGridActor.h"
+#include "GAGridMapOps.h"
+
+
+// How fast a particle's heading wanders, in radians per second either way
+static const float ParticleTurnRate = UE_HALF_PI;
+
+// The furthest a particle moves (in cells) before checking the cell it's moving into, so it can't skip over a wall
+static const float ParticleMaxStep = 0.5f;
+
+
+void FGAParticleFilter::Reset()
+{
+	Particles.Empty();
+	CellCounts.Empty();
+	CellVisibility.Empty();
+}
+
+FVector2f FGAParticleFilter::GetRandomVelocity(float MaxSpeed, FRandomStream& Random)
+{
+	const float Angle = Random.FRand() * UE_TWO_PI;
+	return FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * (Random.FRand() * MaxSpeed);
+}
+
+void FGAParticleFilter::Seed(const AGAGridActor* Grid, const FVector& Position, int32 Count, float MaxSpeed, FRandomStream& Random)
+{
+	Particles.Reset();
+
+	const FCellRef Cell = Grid ? Grid->GetCellRef(Position) : FCellRef::Invalid;
+	if (!Cell.IsValid() || !Grid->IsCellTraversable(Cell) || (Grid->CellScale <= 0.0f))
+	{
+		return;
+	}
+
+	const float MaxSpeedInCells = MaxSpeed / Grid->CellScale;
+	Particles.SetNumUninitialized(FMath::Max(Count, 0), EAllowShrinking::No);
+	for (FParticle& Particle : Particles)
+	{
+		// Anywhere in the cell, but not quite on its far edges, which belong to the next cells over
+		Particle.Position = FVector2f(Cell.X + FMath::Min(Random.FRand(), 0.999f), Cell.Y + FMath::Min(Random.FRand(), 0.999f));
+		Particle.Velocity = GetRandomVelocity(MaxSpeedInCells, Random);
+	}
+}
+
+void FGAParticleFilter::Predict(const AGAGridActor* Grid, float DeltaTime, FRandomStream& Random)
+{
+	if (!Grid || (DeltaTime <= 0.0f))
+	{
+		return;
+	}
+
+	const float MaxTurn = ParticleTurnRate * DeltaTime;
+	for (FParticle& Particle : Particles)
+	{
+		// Wander a bit
+		const float Turn = Random.FRandRange(-MaxTurn, MaxTurn);
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, Turn);
+		Particle.Velocity = FVector2f(Cos * Particle.Velocity.X - Sin * Particle.Velocity.Y, Sin * Particle.Velocity.X + Cos * Particle.Velocity.Y);
+
+		const FVector2f Move = Particle.Velocity * DeltaTime;
+		const int32 StepCount = FMath::Max(FMath::CeilToInt32(Move.Size() / ParticleMaxStep), 1);
+		const FVector2f Step = Move / float(StepCount);
+		for (int32 StepIndex = 0; StepIndex < StepCount; StepIndex++)
+		{
+			const FVector2f NewPosition = Particle.Position + Step;
+			const FCellRef OldCell = GetParticleCell(Particle);
+			const FCellRef NewCell(FMath::FloorToInt32(NewPosition.X), FMath::FloorToInt32(NewPosition.Y));
+
+			// Crossing into a diagonal neighbor goes through a corner, which is only open if both cells either side are
+			const bool bDiagonal = (NewCell.X != OldCell.X) && (NewCell.Y != OldCell.Y);
+			if (!Grid->IsCellTraversable(NewCell) ||
+				(bDiagonal && (!Grid->IsCellTraversable(FCellRef(NewCell.X, OldCell.Y)) || !Grid->IsCellTraversable(FCellRef(OldCell.X, NewCell.Y)))))
+			{
+				// Bounce off in some other direction, at the same speed, and try again next tick
+				const float Angle = Random.FRand() * UE_TWO_PI;
+				Particle.Velocity = FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * Particle.Velocity.Size();
+				break;
+			}
+			Particle.Position = NewPosition;
+		}
+	}
+}
+
+void FGAParticleFilter::Resample(const AGAGridActor* Grid, int32 Count, float MaxSpeed, FRandomStream& Random)
+{
+	const int32 SurvivorCount = Particles.Num();
+	if ((SurvivorCount == 0) || (Count <= SurvivorCount) || !Grid || (Grid->CellScale <= 0.0f))
+	{
+		return;
+	}
+
+	// Every survivor is as likely as any other (the culling is all or nothing), so the copies are spread evenly over
+	// them, starting from a random offset. That's systematic resampling with equal weights.
+	const float MaxSpeedInCells = MaxSpeed / Grid->CellScale;
+	const int32 CopyCount = Count - SurvivorCount;
+	const float Stride = float(SurvivorCount) / float(CopyCount);
+	float Source = Random.FRand() * Stride;
+
+	Particles.Reserve(Count);
+	for (int32 CopyIndex = 0; CopyIndex < CopyCount; CopyIndex++, Source += Stride)
+	{
+		FParticle Copy = Particles[FMath::Min(FMath::FloorToInt32(Source), SurvivorCount - 1)];
+
+		// A different heading and speed, so the copies don't all just follow the original around
+		const float Turn = Random.FRandRange(-UE_QUARTER_PI, UE_QUARTER_PI);
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, Turn);
+		const float Speed = FMath::Min(Copy.Velocity.Size() * Random.FRandRange(0.8f, 1.2f), MaxSpeedInCells);
+		Copy.Velocity = FVector2f(Cos * Copy.Velocity.X - Sin * Copy.Velocity.Y, Sin * Copy.Velocity.X + Cos * Copy.Velocity.Y).GetSafeNormal() * Speed;
+		Particles.Add(Copy);
+	}
+}
+
+void FGAParticleFilter::CountParticles()
+{
+	CellCounts.Reset();
+	for (const FParticle& Particle : Particles)
+	{
+		CellCounts.FindOrAdd(GetParticleCell(Particle))++;
+	}
+}
+
+FCellRef FGAParticleFilter::GetDensestCell()
+{
+	CountParticles();
+
+	FCellRef Result = FCellRef::Invalid;
+	int32 MaxCount = 0;
+	for (const TPair<FCellRef, int32>& CellCount : CellCounts)
+	{
+		if (CellCount.Value > MaxCount)
+		{
+			MaxCount = CellCount.Value;
+			Result = CellCount.Key;
+		}
+	}
+	return Result;
+}
+
+void FGAParticleFilter::Rasterize(FGAGridMap& Map, FGridBox& ActiveBox)
+{
+	// Clear what the last one wrote (and mark it dirty)
+	GAGridMapOps::Fill(Map, ActiveBox, 0.0f);
+	ActiveBox = FGridBox();
+
+	if (!Map.IsValid())
+	{
+		return;
+	}
+
+	CountParticles();
+
+	int32 MaxCount = 0;
+	for (const TPair<FCellRef, int32>& CellCount : CellCounts)
+	{
+		MaxCount = FMath::Max(MaxCount, CellCount.Value);
+	}
+
+	for (const TPair<FCellRef, int32>& CellCount : CellCounts)
+	{
+		const FCellRef& Cell = CellCount.Key;
+		if (Map.GridBounds.IsValidCell(Cell.X, Cell.Y))
+		{
+			Map.SetValueUnchecked(Cell.X, Cell.Y, float(CellCount.Value) / float(MaxCount));
+			ActiveBox = ActiveBox.GetUnion(FGridBox(Cell.X, Cell.X, Cell.Y, Cell.Y));
+		}
+	}
+
+	if (ActiveBox.IsValid())
+	{
+		Map.MarkDirty(ActiveBox);
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridMap.h"
+
+
+// Tracks where a hidden target might be with a cloud of particles rather than a probability per grid cell.
+//
+// Each particle is one guess at where the target is, with a heading and a speed. Every tick:
+//
+//		Predict		each particle walks on along its heading (turning a little at random), and bounces off in a new
+//					direction when its next step would take it into (or diagonally past the corner of) a blocked cell
+//		Cull		particles in cells a perceiver can see are dropped -- the target isn't there
+//		Resample	the survivors are copied (with a bit of jitter) to bring the count back up, so the particles
+//					gather in the places the target could still be
+//
+// All of that is O(particles), whatever the size of the grid, and a few hundred to a few thousand particles is
+// plenty. Turn the particles into a grid map (Rasterize) only when something needs one, like the debug view or a
+// spatial function reading the target's occupancy.
+
+class AGAGridActor;
+
+class FGAParticleFilter
+{
+public:
+	struct FParticle
+	{
+		// In normalized grid space, where cell (X, Y) covers [X, X + 1) x [Y, Y + 1)
+		FVector2f Position;
+
+		// Cells per second
+		FVector2f Velocity;
+	};
+
+	// Put Count particles in Position's cell (spread across it), heading every which way at up to MaxSpeed (cm/s)
+	void Seed(const AGAGridActor* Grid, const FVector& Position, int32 Count, float MaxSpeed, FRandomStream& Random);
+
+	// Move every particle DeltaTime's worth. Particles never step into a blocked cell or off the grid, or squeeze
+	// diagonally between two blocked cells.
+	void Predict(const AGAGridActor* Grid, float DeltaTime, FRandomStream& Random);
+
+	// Drop the particles in cells IsCellVisible(const FCellRef&) says a perceiver can see. It's asked at most once
+	// per cell. If that would drop every particle, none are dropped: the target is somewhere the particles didn't
+	// think of, and losing the whole cloud would tell us even less. Returns the number of particles dropped.
+	template<typename IsCellVisibleType>
+	int32 Cull(IsCellVisibleType IsCellVisible);
+
+	// Bring the particle count back up to Count, by copying random survivors and nudging the copies' velocities.
+	// MaxSpeed is in cm/s, as for Seed.
+	void Resample(const AGAGridActor* Grid, int32 Count, float MaxSpeed, FRandomStream& Random);
+
+	// The cell with the most particles in it (invalid if there aren't any)
+	FCellRef GetDensestCell();
+
+	// Write the particle density into Map, scaled so the densest cell is 1. On the way in, every cell of Map outside
+	// ActiveBox has to be 0; on the way out ActiveBox is the bounds of the cells with particles in them, and
+	// everything else is 0. Only the cells in the old and new boxes are touched.
+	void Rasterize(FGAGridMap& Map, FGridBox& ActiveBox);
+
+	const TArray<FParticle>& GetParticles() const { return Particles; }
+	int32 Num() const { return Particles.Num(); }
+
+	void Reset();
+
+private:
+	// Fill CellCounts with the number of particles in each cell
+	void CountParticles();
+
+	static FORCEINLINE FCellRef GetParticleCell(const FParticle& Particle)
+	{
+		return FCellRef(FMath::FloorToInt32(Particle.Position.X), FMath::FloorToInt32(Particle.Position.Y));
+	}
+
+	// A random velocity of up to MaxSpeed cells per second
+	static FVector2f GetRandomVelocity(float MaxSpeed, FRandomStream& Random);
+
+	TArray<FParticle> Particles;
+
+	// Scratch, kept around so a tick doesn't allocate
+	TMap<FCellRef, int32> CellCounts;
+	TMap<FCellRef, bool> CellVisibility;
+};
+
+
+template<typename IsCellVisibleType>
+int32 FGAParticleFilter::Cull(IsCellVisibleType IsCellVisible)
+{
+	// Particles share cells, so the (expensive) visibility test is done once per cell
+	CellVisibility.Reset();
+	int32 SurvivorCount = 0;
+	for (int32 Index = 0; Index < Particles.Num(); Index++)
+	{
+		const FCellRef Cell = GetParticleCell(Particles[Index]);
+		bool* Visible = CellVisibility.Find(Cell);
+		if (!Visible)
+		{
+			Visible = &CellVisibility.Add(Cell, IsCellVisible(Cell));
+		}
+
+		if (!*Visible)
+		{
+			// Survivors are packed at the front, in their original order
+			Particles[SurvivorCount++] = Particles[Index];
+		}
+	}
+
+	if (SurvivorCount == 0)
+	{
+		// Nothing packed over anything, so the cloud is still intact
+		return 0;
+	}
+
+	const int32 DroppedCount = Particles.Num() - SurvivorCount;
+	Particles.SetNum(SurvivorCount, EAllowShrinking::No);
+	return DroppedCount;
+}
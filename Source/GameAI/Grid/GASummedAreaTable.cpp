@@ -0,0 +1,88 @@
+#include "GASummedAreaTable.h"
+#include "GAGridActor.h"
+#include "Async/ParallelFor.h"
+
+
+// Rows (or columns) per ParallelFor task
+static const int32 SummedAreaBandSize = 64;
+
+
+void FGASummedAreaTable::Reset()
+{
+	Bounds = FGridBox();
+	Sums.Reset();
+}
+
+// GetValue(X, Y) returns the source value at grid cell X, Y. It's called from worker threads.
+template<typename GetValueType>
+void FGASummedAreaTable::BuildInternal(const FGridBox& SourceBounds, GetValueType GetValue)
+{
+	Bounds = SourceBounds;
+
+	const int32 Width = Bounds.GetWidth();
+	const int32 Height = Bounds.GetHeight();
+	const int32 Stride = Width + 1;
+
+	// Not Init, which would throw away the allocation from last time
+	Sums.SetNumUninitialized(Stride * (Height + 1), EAllowShrinking::No);
+	double* SumData = Sums.GetData();
+	FMemory::Memzero(SumData, Stride * sizeof(double));
+
+	// The source is only read once, here: each row gets its running sum, a band of rows per task
+	const int32 RowBandCount = (Height + SummedAreaBandSize - 1) / SummedAreaBandSize;
+	ParallelFor(RowBandCount, [&](int32 BandIndex)
+	{
+		const int32 EndY = FMath::Min((BandIndex + 1) * SummedAreaBandSize, Height);
+		for (int32 LocalY = BandIndex * SummedAreaBandSize; LocalY < EndY; LocalY++)
+		{
+			double* Row = SumData + (LocalY + 1) * Stride;
+			double RunningSum = 0.0;
+			Row[0] = 0.0;
+			for (int32 LocalX = 0; LocalX < Width; LocalX++)
+			{
+				RunningSum += GetValue(Bounds.MinX + LocalX, Bounds.MinY + LocalY);
+				Row[LocalX + 1] = RunningSum;
+			}
+		}
+	});
+
+	// Then the row sums are accumulated down the table, a strip of columns per task, which keeps each task
+	// walking forward through memory
+	const int32 ColumnBandCount = (Stride + SummedAreaBandSize - 1) / SummedAreaBandSize;
+	ParallelFor(ColumnBandCount, [&](int32 BandIndex)
+	{
+		const int32 StartX = BandIndex * SummedAreaBandSize;
+		const int32 EndX = FMath::Min(StartX + SummedAreaBandSize, Stride);
+		for (int32 Y = 2; Y <= Height; Y++)
+		{
+			double* Row = SumData + Y * Stride;
+			const double* PreviousRow = Row - Stride;
+			for (int32 X = StartX; X < EndX; X++)
+			{
+				Row[X] += PreviousRow[X];
+			}
+		}
+	});
+}
+
+void FGASummedAreaTable::Build(const FGAGridMap& Map)
+{
+	if (!Map.IsValid())
+	{
+		Reset();
+		return;
+	}
+
+	BuildInternal(Map.GridBounds, [&Map](int32 X, int32 Y) { return double(Map.GetValueUnchecked(X, Y)); });
+}
+
+void FGASummedAreaTable::BuildTraversability(const AGAGridActor* Grid)
+{
+	if (!Grid || (Grid->XCount <= 0) || (Grid->YCount <= 0))
+	{
+		Reset();
+		return;
+	}
+
+	BuildInternal(FGridBox(0, Grid->XCount - 1, 0, Grid->YCount - 1), [Grid](int32 X, int32 Y) { return Grid->IsCellTraversable(FCellRef(X, Y)) ? 1.0 : 0.0; });
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridMap.h"
+
+
+// A summed-area table (a.k.a. integral image) over a grid map, or over the grid's traversability.
+//
+// Every entry holds the sum of all the source cells above and to the left of it, so the sum over any box comes out
+// of four lookups no matter how big the box is. That makes windowed aggregates -- "how much occupancy is within 5m",
+// "what fraction of the 7x7 cells around me are blocked" -- cost the same at any radius:
+//
+//		const FGASummedAreaTable& Open = Grid->GetTraversableSumTable();
+//		FGridBox Window = FGASummedAreaTable::GetWindow(X, Y, 3);
+//		float OpenFraction = float(Open.GetSum(Window)) / float(Window.GetCellCount());
+//
+// The table is a snapshot of its source; rebuild it when the source changes. Sums are kept as doubles so that small
+// values don't get rounded away on big tables.
+
+class AGAGridActor;
+
+struct FGASummedAreaTable
+{
+	// The source cells the table covers, in grid coordinates
+	FGridBox Bounds;
+
+	// (Width + 1) x (Height + 1) entries, a row at a time whatever GAGridLayout says. Entry (X, Y) is the sum of the
+	// source cells at local coordinates less than (X, Y), so the first row and column are all zero.
+	TArray<double> Sums;
+
+	void Reset();
+
+	bool IsValid() const
+	{
+		return Bounds.IsValid() && (Sums.Num() == (Bounds.GetWidth() + 1) * (Bounds.GetHeight() + 1));
+	}
+
+	// Build from the values of Map, over Map's bounds
+	void Build(const FGAGridMap& Map);
+
+	// Build from Grid's traversability (1 for traversable cells, 0 for blocked ones), over the whole grid.
+	// Dynamic obstacles count as blocked.
+	void BuildTraversability(const AGAGridActor* Grid);
+
+	// Sum of the source cells in Box (grid coordinates). Whatever part of Box is outside Bounds counts as 0.
+	FORCEINLINE double GetSum(const FGridBox& Box) const
+	{
+		const FGridBox Clipped = Box.GetOverlap(Bounds);
+		if (!Clipped.IsValid() || !IsValid())
+		{
+			return 0.0;
+		}
+
+		const int32 X0 = Clipped.MinX - Bounds.MinX;
+		const int32 X1 = Clipped.MaxX - Bounds.MinX + 1;
+		const int32 Y0 = Clipped.MinY - Bounds.MinY;
+		const int32 Y1 = Clipped.MaxY - Bounds.MinY + 1;
+		return GetEntry(X1, Y1) - GetEntry(X0, Y1) - GetEntry(X1, Y0) + GetEntry(X0, Y0);
+	}
+
+	// The square of cells within Radius cells of (X, Y) along each axis. Not clipped to anything.
+	static FORCEINLINE FGridBox GetWindow(int32 X, int32 Y, int32 Radius)
+	{
+		return FGridBox(X - Radius, X + Radius, Y - Radius, Y + Radius);
+	}
+
+private:
+	FORCEINLINE double GetEntry(int32 X, int32 Y) const
+	{
+		return Sums.GetData()[Y * (Bounds.GetWidth() + 1) + X];
+	}
+
+	template<typename GetValueType>
+	void BuildInternal(const FGridBox& SourceBounds, GetValueType GetValue);
+};
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GAGridMap.h"
+#include "GAGridActor.h"
+#include "GATypedGridMap.generated.h"
+
+
+// Grid maps with a choice of storage type. FGAGridMap is the Blueprint-facing float map, and most things still
+// use it; TGAGridMap<ValueType> holds the same data more compactly for maps that don't need 32 bits per cell:
+//
+//		float		Same as FGAGridMap
+//		FFloat16	Half float. Good for scores and probabilities (about 3 significant digits, max 65504)
+//		uint16		Fixed point, [0, 1] in steps of 1/65535. Values outside that range are clamped
+//		uint8		Fixed point, [0, 1] in steps of 1/255. Flags (0 or 1) survive exactly
+//
+// The accessors take and return floats, so the same kernel code can be instantiated for FGAGridMap and for any
+// TGAGridMap (see e.g. the occupancy map diffusion in GATargetComponent.cpp). The data is laid out exactly like
+// FGAGridMap's (see GAGridLayout.h), so converting between the two is a straight element-wise pass.
+
+UENUM(BlueprintType)
+enum class EGAGridMapPrecision : uint8
+{
+	Float32			UMETA(DisplayName = "Float (32 bit)"),
+	Float16			UMETA(DisplayName = "Half float (16 bit)"),
+	Unorm16			UMETA(DisplayName = "Fixed point 0-1 (16 bit)"),
+	Unorm8			UMETA(DisplayName = "Fixed point 0-1 (8 bit)"),
+};
+
+
+// How each storage type converts to and from float
+template<typename ValueType>
+struct TGAGridMapValueTraits;
+
+template<>
+struct TGAGridMapValueTraits<float>
+{
+	static constexpr EGAGridMapPrecision Precision = EGAGridMapPrecision::Float32;
+	static FORCEINLINE float Encode(float Value) { return Value; }
+	static FORCEINLINE float Decode(float Value) { return Value; }
+};
+
+template<>
+struct TGAGridMapValueTraits<FFloat16>
+{
+	static constexpr EGAGridMapPrecision Precision = EGAGridMapPrecision::Float16;
+	static FORCEINLINE FFloat16 Encode(float Value) { return FFloat16(Value); }
+	static FORCEINLINE float Decode(FFloat16 Value) { return Value.GetFloat(); }
+};
+
+template<>
+struct TGAGridMapValueTraits<uint16>
+{
+	static constexpr EGAGridMapPrecision Precision = EGAGridMapPrecision::Unorm16;
+	static FORCEINLINE uint16 Encode(float Value) { return uint16(FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * 65535.0f)); }
+	static FORCEINLINE float Decode(uint16 Value) { return float(Value) * (1.0f / 65535.0f); }
+};
+
+template<>
+struct TGAGridMapValueTraits<uint8>
+{
+	static constexpr EGAGridMapPrecision Precision = EGAGridMapPrecision::Unorm8;
+	static FORCEINLINE uint8 Encode(float Value) { return uint8(FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * 255.0f)); }
+	static FORCEINLINE float Decode(uint8 Value) { return float(Value) * (1.0f / 255.0f); }
+};
+
+
+template<typename ValueType>
+struct TGAGridMap
+{
+	typedef TGAGridMapValueTraits<ValueType> Traits;
+
+	TGAGridMap() : XCount(INDEX_NONE), YCount(INDEX_NONE), GridBounds()
+	{
+		// we are empty
+	}
+
+	TGAGridMap(const AGAGridActor* Grid, float InitialValue)
+		: XCount(Grid->XCount), YCount(Grid->YCount), GridBounds(0, Grid->XCount - 1, 0, Grid->YCount - 1)
+	{
+		ResetData(InitialValue);
+	}
+
+	TGAGridMap(const AGAGridActor* Grid, const FGridBox& GridBoxIn, float InitialValue)
+		: XCount(Grid->XCount), YCount(Grid->YCount), GridBounds(GridBoxIn)
+	{
+		ResetData(InitialValue);
+	}
+
+	// Same bounds and (converted) values as Source
+	explicit TGAGridMap(const FGAGridMap& Source)
+	{
+		CopyFrom(Source);
+	}
+
+	// The XCount and YCount of the GridActor I'm built on
+	int32 XCount;
+	int32 YCount;
+
+	// The bounds over which I am defined
+	FGridBox GridBounds;
+
+	TArray<ValueType> Data;
+
+
+	void ResetData(float InitialValue)
+	{
+		if (GridBounds.IsValid())
+		{
+			// Not Data.Init, which would throw away a larger allocation (e.g. one borrowed from GAGridMapPool.h)
+			Data.SetNumUninitialized(GAGridLayout::GetAllocatedCount(GridBounds.GetWidth(), GridBounds.GetHeight()), EAllowShrinking::No);
+
+			const ValueType EncodedValue = Traits::Encode(InitialValue);
+			for (ValueType& Value : Data)
+			{
+				Value = EncodedValue;
+			}
+		}
+		else
+		{
+			Data.Empty();
+		}
+	}
+
+	FORCEINLINE bool IsValid() const
+	{
+		return GridBounds.IsValid() && (GAGridLayout::GetAllocatedCount(GridBounds.GetWidth(), GridBounds.GetHeight()) == Data.Num());
+	}
+
+	// Index into Data of the given local (i.e. relative to GridBounds.Min) coordinates
+	FORCEINLINE int32 LocalToIndex(int32 X, int32 Y) const
+	{
+		return GAGridLayout::GetIndex(X, Y, GridBounds.GetWidth());
+	}
+
+	// Size of the cell data, for comparing against the float version
+	SIZE_T GetDataSize() const
+	{
+		return Data.Num() * sizeof(ValueType);
+	}
+
+
+	// Checked access, as in FGAGridMap
+
+	bool GetValue(const FCellRef& Cell, float& ValueOut) const
+	{
+		if (IsValid() && GridBounds.IsValidCell(Cell.X, Cell.Y))
+		{
+			ValueOut = GetValueUnchecked(Cell.X, Cell.Y);
+			return true;
+		}
+		return false;
+	}
+
+	bool SetValue(const FCellRef& Cell, float Value)
+	{
+		if (IsValid() && GridBounds.IsValidCell(Cell.X, Cell.Y))
+		{
+			SetValueUnchecked(Cell.X, Cell.Y, Value);
+			return true;
+		}
+		return false;
+	}
+
+
+	// Unchecked access, as in FGAGridMap. X, Y are grid cell coordinates.
+	// Unlike FGAGridMap there's no float& version, since the stored value isn't a float -- use SetValueUnchecked.
+
+	FORCEINLINE float GetValueUnchecked(int32 X, int32 Y) const
+	{
+		return Traits::Decode(GetStoredValueUnchecked(X, Y));
+	}
+
+	FORCEINLINE void SetValueUnchecked(int32 X, int32 Y, float Value)
+	{
+		GetStoredValueUnchecked(X, Y) = Traits::Encode(Value);
+	}
+
+	// The stored (encoded) value
+	FORCEINLINE ValueType& GetStoredValueUnchecked(int32 X, int32 Y)
+	{
+		checkSlow(GridBounds.IsValidCell(X, Y));
+		return Data.GetData()[LocalToIndex(X - GridBounds.MinX, Y - GridBounds.MinY)];
+	}
+
+	FORCEINLINE const ValueType& GetStoredValueUnchecked(int32 X, int32 Y) const
+	{
+		checkSlow(GridBounds.IsValidCell(X, Y));
+		return Data.GetData()[LocalToIndex(X - GridBounds.MinX, Y - GridBounds.MinY)];
+	}
+
+	// The stored values of row Y. Row-major layout only, as with FGAGridMap::GetRow
+	FORCEINLINE TArrayView<ValueType> GetRow(int32 Y)
+	{
+		check(GAGridLayout::bRowsAreContiguous);
+		checkSlow(IsValid() && (Y >= GridBounds.MinY) && (Y <= GridBounds.MaxY));
+		return TArrayView<ValueType>(Data.GetData() + LocalToIndex(0, Y - GridBounds.MinY), GridBounds.GetWidth());
+	}
+
+	FORCEINLINE TArrayView<const ValueType> GetRow(int32 Y) const
+	{
+		check(GAGridLayout::bRowsAreContiguous);
+		checkSlow(IsValid() && (Y >= GridBounds.MinY) && (Y <= GridBounds.MaxY));
+		return TArrayView<const ValueType>(Data.GetData() + LocalToIndex(0, Y - GridBounds.MinY), GridBounds.GetWidth());
+	}
+
+	// Iterate over (cell, stored value&). Use Traits::Decode / Traits::Encode on the value.
+	TGAGridMapCellRange<ValueType> Cells()
+	{
+		return TGAGridMapCellRange<ValueType>(Data.GetData(), GridBounds, IsValid() ? GridBounds : FGridBox());
+	}
+
+	TGAGridMapCellRange<const ValueType> Cells() const
+	{
+		return TGAGridMapCellRange<const ValueType>(Data.GetData(), GridBounds, IsValid() ? GridBounds : FGridBox());
+	}
+
+
+	// Conversion to and from the Blueprint-facing float map. Both take on the other map's bounds.
+
+	void CopyFrom(const FGAGridMap& Source)
+	{
+		XCount = Source.XCount;
+		YCount = Source.YCount;
+		GridBounds = Source.GridBounds;
+
+		const int32 Count = Source.Data.Num();
+		Data.SetNumUninitialized(Count, EAllowShrinking::No);
+
+		const float* SourceData = Source.Data.GetData();
+		ValueType* DestData = Data.GetData();
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			DestData[Index] = Traits::Encode(SourceData[Index]);
+		}
+	}
+
+	void CopyTo(FGAGridMap& Dest) const
+	{
+		Dest.XCount = XCount;
+		Dest.YCount = YCount;
+		Dest.GridBounds = GridBounds;
+
+		const int32 Count = Data.Num();
+		Dest.Data.SetNumUninitialized(Count, EAllowShrinking::No);
+
+		const ValueType* SourceData = Data.GetData();
+		float* DestData = Dest.Data.GetData();
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			DestData[Index] = Traits::Decode(SourceData[Index]);
+		}
+	}
+};
+
+typedef TGAGridMap<FFloat16> FGAGridMapHalf;
+typedef TGAGridMap<uint16> FGAGridMapUnorm16;
+typedef TGAGridMap<uint8> FGAGridMapUnorm8;
+
+// The stored value type of FGAGridMap or a TGAGridMap, for code templated over the map type that works on the
+// stored values directly (GetRow, Cells())
+template<typename MapType>
+struct TGAGridMapStorage;
+
+template<>
+struct TGAGridMapStorage<FGAGridMap>
+{
+	typedef float ValueType;
+	typedef TGAGridMapValueTraits<float> Traits;
+};
+
+template<typename InValueType>
+struct TGAGridMapStorage<TGAGridMap<InValueType>>
+{
+	typedef InValueType ValueType;
+	typedef TGAGridMapValueTraits<InValueType> Traits;
+};
@@ -1,6 +1,6 @@
 #include "GAPathComponent.h"
 #include "GameFramework/NavMovementComponent.h"
-#include "Kismet/GameplayStatics.h"
+#include "GameAI/Grid/GAGridSubsystem.h"
 
 UE_DISABLE_OPTIMIZATION
 
@@ -10,6 +10,8 @@ UGAPathComponent::UGAPathComponent(const FObjectInitializer& ObjectInitializer)
 	State = GAPS_None;
 	bDestinationValid = false;
 	ArrivalDistance = 100.0f;
+	AgentRadius = 0.0f;
+	GridHeightTolerance = 200.0f;
 
 	// A bit of Unreal magic to make TickComponent below get called
 	PrimaryComponentTick.bCanEverTick = true;
@@ -18,30 +20,48 @@ UGAPathComponent::UGAPathComponent(const FObjectInitializer& ObjectInitializer)
 
 const AGAGridActor* UGAPathComponent::GetGridActor() const
 {
-	if (GridActor.Get())
+	AGAGridActor* Result = GridActor.Get();
+	APawn* Pawn = GetOwnerPawn();
+
+	if (Result)
 	{
-		return GridActor.Get();
+		if (!Pawn)
+		{
+			return Result;
+		}
+
+		// Still on it?
+		FVector PawnLocation = Pawn->GetActorLocation();
+		FCellRef Cell = Result->GetCellRef(PawnLocation);
+		if (Cell.IsValid() && (FMath::Abs(PawnLocation.Z - Result->GetCellFloorPosition(Cell).Z) <= GridHeightTolerance))
+		{
+			return Result;
+		}
 	}
-	else
+
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+	if (GridSubsystem)
 	{
-		AGAGridActor* Result = NULL;
-		AActor *GenericResult = UGameplayStatics::GetActorOfClass(this, AGAGridActor::StaticClass());
-		if (GenericResult)
+		AGAGridActor* FoundGrid = Pawn ? GridSubsystem->FindGridAt(Pawn->GetActorLocation()) : NULL;
+		if (!FoundGrid && !Result)
 		{
-			Result = Cast<AGAGridActor>(GenericResult);
-			if (Result)
-			{
-				// Cache the result
-				// Note, GridActor is marked as mutable in the header, which is why this is allowed in a const method
-				GridActor = Result;
-			}
+			// Off every grid. Better some grid than none.
+			FoundGrid = GridSubsystem->GetDefaultGrid();
 		}
 
-		return Result;
+		if (FoundGrid)
+		{
+			// Cache the result
+			// Note, GridActor is marked as mutable in the header, which is why this is allowed in a const method
+			GridActor = FoundGrid;
+			Result = FoundGrid;
+		}
 	}
+
+	return Result;
 }
 
-APawn* UGAPathComponent::GetOwnerPawn()
+APawn* UGAPathComponent::GetOwnerPawn() const
 {
 	AActor* Owner = GetOwner();
 	if (Owner)
@@ -108,6 +128,8 @@ EGAPathState UGAPathComponent::RefreshPath()
 	{
 		TArray<FPathStep> UnsmoothedSteps;
 
+		RefreshCurrentGoal(StartPoint);
+
 		// Replan the path!
 		State = AStar(StartPoint, UnsmoothedSteps);
 		// Debugging A*
@@ -124,6 +146,49 @@ EGAPathState UGAPathComponent::RefreshPath()
 }
 
 
+void UGAPathComponent::RefreshCurrentGoal(const FVector& StartPoint)
+{
+	const AGAGridActor* Grid = GetGridActor();
+	UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+
+	CurrentGoal = Destination;
+
+	if (Grid && GridSubsystem)
+	{
+		const AGAGridActor* DestinationGrid = GridSubsystem->FindGridAt(Destination);
+		TArray<const AGAGridActor*> Route;
+
+		if (DestinationGrid && (DestinationGrid != Grid) && GridSubsystem->FindGridRoute(Grid, DestinationGrid, Route))
+		{
+			FVector TransitionPoint;
+			if (GridSubsystem->FindTransitionPoint(Grid, Route[1], Destination, TransitionPoint))
+			{
+				if (FVector::Dist2D(StartPoint, TransitionPoint) <= ArrivalDistance)
+				{
+					// Made it to the crossing. Step over onto the next grid and carry on from there.
+					GridActor = const_cast<AGAGridActor*>(Route[1]);
+					Grid = Route[1];
+
+					if ((Route.Num() > 2) && GridSubsystem->FindTransitionPoint(Grid, Route[2], Destination, TransitionPoint))
+					{
+						CurrentGoal = TransitionPoint;
+					}
+				}
+				else
+				{
+					CurrentGoal = TransitionPoint;
+				}
+			}
+		}
+	}
+
+	if (Grid)
+	{
+		DestinationCell = Grid->GetCellRef(CurrentGoal);
+	}
+}
+
+
 struct FCellRecord
 {
 	FCellRecord(const FCellRef& CellIn, const FCellRef &PrevCellIn, float CumulativeDistanceIn, float TotalScoreIn) : 
@@ -145,6 +210,22 @@ struct FCellRecord
 	}
 };
 
+// Cost of stepping into NCell, given the length of the step
+// Without a cost channel this is just the length, and the lookup compiles away entirely
+template<bool bWithCost>
+static FORCEINLINE float GetStepCost(const AGAGridActor* Grid, const FCellRef& NCell, float StepLength)
+{
+	if constexpr (bWithCost)
+	{
+		return StepLength * Grid->GetTraversalCostMultiplier(Grid->CellRefToIndex(NCell));
+	}
+	else
+	{
+		return StepLength;
+	}
+}
+
+
 EGAPathState UGAPathComponent::AStar(const FVector &StartPoint, TArray<FPathStep> &StepsOut)
 {
 	const AGAGridActor* Grid = GetGridActor();
@@ -153,11 +234,24 @@ EGAPathState UGAPathComponent::AStar(const FVector &StartPoint, TArray<FPathStep
 		return GAPS_Invalid;
 	}
 
+	// Pick the search once, up front, so the uniform-cost case doesn't pay for cost lookups in its inner loop
+	if (Grid->HasTraversalCosts())
+	{
+		return AStarInternal<true>(Grid, StartPoint, StepsOut);
+	}
+	return AStarInternal<false>(Grid, StartPoint, StepsOut);
+}
+
+
+template<bool bWithCost>
+EGAPathState UGAPathComponent::AStarInternal(const AGAGridActor* Grid, const FVector& StartPoint, TArray<FPathStep>& StepsOut)
+{
 	FCellRef StartCellRef = Grid->GetCellRef(StartPoint);
 	if (StartCellRef.IsValid())
 	{
 		TArray<FCellRecord> Heap;
 		TMap<FCellRef, FCellRecord> Closed;
+		FCellNeighbors Neighbors;			// inline storage, so expanding a node doesn't allocate
 
 		float StartDistance = StartCellRef.Distance(DestinationCell);
 
@@ -198,15 +292,13 @@ EGAPathState UGAPathComponent::AStar(const FVector &StartPoint, TArray<FPathStep
 				// minor tweak -- set the last cell position to the destination point, rather than the cell point
 				if (StepsOut.Num() > 0)
 				{
-					StepsOut.Last().Point = FVector2D(Destination);
+					StepsOut.Last().Point = FVector2D(CurrentGoal);
 				}
 
 				return GAPS_Active;
 			}
 			else
 			{
-				TArray<FCellRef> Neighbors;
-
 				Grid->GetNeighbors(CurrentRecord.Cell, true, Neighbors);
 
 				for (FCellRef& NCell : Neighbors)
@@ -216,7 +308,8 @@ EGAPathState UGAPathComponent::AStar(const FVector &StartPoint, TArray<FPathStep
 						int32 DX = FMath::Abs(CurrentRecord.Cell.X - NCell.X);
 						int32 DY = FMath::Abs(CurrentRecord.Cell.Y - NCell.Y);
 
-						float ParentD = ((DX > 0) && (DY > 0)) ? UE_SQRT_2 : 1.0f;
+						// Costs only ever scale steps up, so the straight-line heuristic stays admissible
+						float ParentD = GetStepCost<bWithCost>(Grid, NCell, ((DX > 0) && (DY > 0)) ? UE_SQRT_2 : 1.0f);
 						float H = NCell.Distance(DestinationCell);
 						float TotalScore = CurrentRecord.CumulativeDistance + ParentD + H;
 
@@ -259,19 +352,33 @@ EGAPathState UGAPathComponent::AStar(const FVector &StartPoint, TArray<FPathStep
 
 bool UGAPathComponent::Dijkstra(const FVector& StartPoint, FGAGridMap& DistanceMapOut) const
 {
-	bool Result = false;
-
 	const AGAGridActor* Grid = GetGridActor();
 	if (!Grid)
 	{
 		return false;
 	}
 
+	if (Grid->HasTraversalCosts())
+	{
+		return DijkstraInternal<true>(Grid, StartPoint, DistanceMapOut);
+	}
+	return DijkstraInternal<false>(Grid, StartPoint, DistanceMapOut);
+}
+
+
+template<bool bWithCost>
+bool UGAPathComponent::DijkstraInternal(const AGAGridActor* Grid, const FVector& StartPoint, FGAGridMap& DistanceMapOut) const
+{
+	bool Result = false;
+
 	FCellRef StartCellRef = Grid->GetCellRef(StartPoint);
-	if (StartCellRef.IsValid())
+	if (StartCellRef.IsValid() && DistanceMapOut.IsValid())
 	{
+		// The map has been validated, so the inner loop only needs to test cells against its bounds
+		const FGridBox& MapBounds = DistanceMapOut.GridBounds;
 		FCellRecord StartRecord(StartCellRef, FCellRef::Invalid, 0.0f, 0.0f);
 		TArray<FCellRecord> Heap;
+		FCellNeighbors Neighbors;			// inline storage, so expanding a node doesn't allocate
 		float DiagonalDistance = UE_SQRT_2 * Grid->CellScale;
 
 		Result = true;
@@ -283,25 +390,24 @@ bool UGAPathComponent::Dijkstra(const FVector& StartPoint, FGAGridMap& DistanceM
 			FCellRecord CurrentRecord;
 			Heap.HeapPop(CurrentRecord);
 
-			DistanceMapOut.SetValue(CurrentRecord.Cell, CurrentRecord.CumulativeDistance);
-
+			if (MapBounds.IsValidCell(CurrentRecord.Cell.X, CurrentRecord.Cell.Y))
 			{
-				TArray<FCellRef> Neighbors;
+				DistanceMapOut.SetValueUnchecked(CurrentRecord.Cell.X, CurrentRecord.Cell.Y, CurrentRecord.CumulativeDistance);
+			}
 
+			{
 				Grid->GetNeighbors(CurrentRecord.Cell, true, Neighbors);
 
 				for (FCellRef& NCell : Neighbors)
 				{
-					float CurrentDistanceInMap;
-
-					if (DistanceMapOut.GetValue(NCell, CurrentDistanceInMap))
+					if (MapBounds.IsValidCell(NCell.X, NCell.Y))
 					{
-						if (CurrentDistanceInMap == FLT_MAX)
+						if (DistanceMapOut.GetValueUnchecked(NCell.X, NCell.Y) == FLT_MAX)
 						{
 							int32 DX = FMath::Abs(CurrentRecord.Cell.X - NCell.X);
 							int32 DY = FMath::Abs(CurrentRecord.Cell.Y - NCell.Y);
 
-							float ParentD = ((DX > 0) && (DY > 0)) ? DiagonalDistance : Grid->CellScale;
+							float ParentD = GetStepCost<bWithCost>(Grid, NCell, ((DX > 0) && (DY > 0)) ? DiagonalDistance : Grid->CellScale);
 							float CumulativeDistance = CurrentRecord.CumulativeDistance + ParentD;
 							float TotalScore = CumulativeDistance;			// could also add penalties here
 
@@ -345,6 +451,7 @@ bool UGAPathComponent::BuildPathFromDistanceMap(const FVector& StartPoint, const
 {
 	bool Result = false;
 	TArray<FCellRef> Cells;
+	FCellNeighbors Neighbors;
 	FCellRef CurrentCell = CellRef;
 	const AGAGridActor* Grid = GetGridActor();
 
@@ -369,7 +476,6 @@ bool UGAPathComponent::BuildPathFromDistanceMap(const FVector& StartPoint, const
 		{
 			float D;
 
-			TArray<FCellRef> Neighbors;
 			FVector CurrentPosition = Grid->GetCellPosition(CurrentCell);
 
 			Cells.Add(CurrentCell);
@@ -459,7 +565,11 @@ EGAPathState UGAPathComponent::SmoothPath(const FVector& StartPoint, const TArra
 			FVector CellPoint = Grid->GetCellPosition(UnsmoothedSteps[StepIndex].CellRef);
 			FVector HitLocation;
 
-			if (Grid->TraceLine(LastPoint, CellPoint, HitLocation))
+			bool bHit = (AgentRadius > 0.0f) ?
+				Grid->TraceLineWithRadius(LastPoint, CellPoint, AgentRadius, HitLocation) :
+				Grid->TraceLine(LastPoint, CellPoint, HitLocation);
+
+			if (bHit)
 			{
 				// we hit something
 				const FPathStep& StepToAdd = UnsmoothedSteps[StepIndex - 1];
@@ -525,8 +635,12 @@ EGAPathState UGAPathComponent::SetDestination(const FVector &DestinationPoint)
 	const AGAGridActor* Grid = GetGridActor();
 	if (Grid)
 	{
+		// The destination might be on another grid, in which case RefreshPath heads for the crossing instead
+		UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+		const AGAGridActor* DestinationGrid = GridSubsystem ? GridSubsystem->FindGridAt(Destination) : NULL;
+
 		FCellRef CellRef = Grid->GetCellRef(Destination);
-		if (CellRef.IsValid())
+		if (CellRef.IsValid() || (DestinationGrid && (DestinationGrid != Grid)))
 		{
 			DestinationCell = CellRef;
 			bDestinationValid = true;
@@ -50,16 +50,21 @@ class UGAPathComponent : public UActorComponent
 	GENERATED_UCLASS_BODY()
 
 	// Note just a cached pointer
+	// This is the grid we're currently on. We stay on it until we leave it, and then ask the grid subsystem where we are.
 	UPROPERTY()
 	mutable TSoftObjectPtr<AGAGridActor> GridActor;
 
 	UFUNCTION(BlueprintCallable)
 	const AGAGridActor *GetGridActor() const;
 
+	// We count as still on our current grid while we're over it and within this height of its floor
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float GridHeightTolerance;
+
 	// It is super easy to forget: this component will usually be attached to the CONTROLLER, not the pawn it's controlling
 	// A lot of times we want access to the pawn (e.g. when sending signals to its movement component).
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	APawn *GetOwnerPawn();
+	APawn *GetOwnerPawn() const;
 
 
 	// State Update ------------------------
@@ -72,6 +77,13 @@ class UGAPathComponent : public UActorComponent
 
 	bool Dijkstra(const FVector& StartPoint, FGAGridMap &DistanceMapOut) const;
 
+	// The searches themselves. bWithCost says whether the grid has a traversal cost channel to read.
+	template<bool bWithCost>
+	EGAPathState AStarInternal(const AGAGridActor* Grid, const FVector& StartPoint, TArray<FPathStep>& StepsOut);
+
+	template<bool bWithCost>
+	bool DijkstraInternal(const AGAGridActor* Grid, const FVector& StartPoint, FGAGridMap& DistanceMapOut) const;
+
 	bool BuildPathFromDistanceMap(const FVector& StartPoint, const FCellRef& CellRef, const FGAGridMap& DistanceMap);
 
 	EGAPathState SmoothPath(const FVector &StartPoint, const TArray<FPathStep> &UnsmoothedSteps, TArray<FPathStep>& SmoothedStepsOut);
@@ -86,6 +98,11 @@ class UGAPathComponent : public UActorComponent
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	float ArrivalDistance;
 
+	// Radius of the agent, used when smoothing the path so that we don't clip corners.
+	// If this is 0, the agent is treated as a point.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float AgentRadius;
+
 	// Destination ------------------------
 
 	UFUNCTION(BlueprintCallable)
@@ -103,6 +120,14 @@ class UGAPathComponent : public UActorComponent
 	UPROPERTY(BlueprintReadOnly)
 	FCellRef DestinationCell;
 
+	// Where the current leg of the path is headed. This is Destination, unless Destination is on another grid,
+	// in which case it's the point where we cross over to the next grid on the way.
+	UPROPERTY(BlueprintReadOnly)
+	FVector CurrentGoal;
+
+	// Work out CurrentGoal and DestinationCell for the grid we're on. Crosses over to the next grid if we've reached the transition.
+	void RefreshCurrentGoal(const FVector& StartPoint);
+
 	// State ------------------------
 
 	UPROPERTY(BlueprintReadOnly)
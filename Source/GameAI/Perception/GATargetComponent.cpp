@@ -1,6 +1,8 @@
 #include "GATargetComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameAI/Grid/GAGridActor.h"
+#include "GameAI/Grid/GAGridSubsystem.h"
+#include "GameAI/Grid/GAGridMapOps.h"
 #include "GAPerceptionSystem.h"
 #include "ProceduralMeshComponent.h"
 #include "WorldCollision.h"
@@ -8,6 +10,20 @@
 #include "DrawDebugHelpers.h"
 
 
+// Fraction of a cell's probability that goes to its neighbors on each diffusion step. The blur and reachability
+// modes pass it to FGAGridDiffusion::Prepare too, even though the blur doesn't use it, so switching modes doesn't
+// make the coefficients rebuild.
+static const float OccupancyDiffusionFactor = 0.4f;
+
+// Below this, probability is dropped, which stops the active box from creeping out over the whole map.
+// (The map is normalized to a max of 1 every update.)
+static const float OccupancyNegligibleProbability = 1e-6f;
+
+// Standard deviation, along each axis, of where a target that left at speed 1 in a random direction is after one
+// second: a point on the unit circle has a variance of 1/2 in X and in Y
+static const float OccupancyBlurSpreadScale = UE_INV_SQRT_2;
+
+
 UGATargetComponent::UGATargetComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -18,6 +34,18 @@ UGATargetComponent::UGATargetComponent(const FObjectInitializer& ObjectInitializ
 
 	// Generate a new guid
 	TargetGuid = FGuid::NewGuid();
+
+	OccupancyPropagation = EGAOccupancyPropagation::Diffusion;
+	ExpectedTargetSpeed = 300.0f;
+	PendingBlurVariance = 0.0f;
+	MaxTargetSpeed = 600.0f;
+	LastSeenTime = 0.0f;
+	bOccupancyReachabilityStarted = false;
+	ParticleCount = 1000;
+	ParticleRandom.Initialize(int32(GetTypeHash(TargetGuid)));
+	bOccupancyMapStale = false;
+	OccupancyMapVersion = 0;
+	OccupancySumTableVersion = INDEX_NONE;
 }
 
 
@@ -30,10 +58,17 @@ AGAGridActor* UGATargetComponent::GetGridActor() const
 	}
 	else
 	{
-		AActor* GenericResult = UGameplayStatics::GetActorOfClass(this, AGAGridActor::StaticClass());
-		if (GenericResult)
+		// The occupancy map is tied to one grid, so we look it up once (by where we are) and then stick with it
+		UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+		if (GridSubsystem)
 		{
-			Result = Cast<AGAGridActor>(GenericResult);
+			AActor* Owner = GetOwner();
+			Result = Owner ? GridSubsystem->FindGridAt(Owner->GetActorLocation()) : NULL;
+			if (!Result)
+			{
+				Result = GridSubsystem->GetDefaultGrid();
+			}
+
 			if (Result)
 			{
 				// Cache the result
@@ -57,13 +92,24 @@ void UGATargetComponent::OnRegister()
 		PerceptionSystem->RegisterTargetComponent(this);
 	}
 
+	// The particle filter only needs the map if something asks for it
 	const AGAGridActor* Grid = GetGridActor();
-	if (Grid)
+	if (Grid && (OccupancyPropagation != EGAOccupancyPropagation::ParticleFilter))
 	{
-		OccupancyMap = FGAGridMap(Grid, 0.0f);
+		InitOccupancyMap(Grid);
+		OccupancyMapVersion++;
 	}
 }
 
+void UGATargetComponent::InitOccupancyMap(const AGAGridActor* Grid) const
+{
+	OccupancyMap = FGAGridMap(Grid, 0.0f);
+	OccupancyMap.SetDirtyTracking(true);
+	OccupancyMap.SetPyramidEnabled(true);
+	OccupancyMap.MarkAllDirty();
+	OccupancyActiveBox = FGridBox();
+}
+
 void UGATargetComponent::OnUnregister()
 {
 	Super::OnUnregister();
@@ -122,18 +168,33 @@ void UGATargetComponent::TickComponent(float DeltaTime, enum ELevelTick TickType
 	if (LastKnownState.State == GATS_Hidden)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("IsHidden!"));
-		OccupancyMapUpdate();
+		if (OccupancyPropagation == EGAOccupancyPropagation::ParticleFilter)
+		{
+			OccupancyParticlesUpdate();
+		}
+		else
+		{
+			OccupancyMapUpdate();
+		}
 	}
 
 	if (IsKnown())
 	{
-		OccupancyMapDiffuse();
+		OccupancyMapPropagate(DeltaTime);
 	}
 
 	if (bDebugOccupancyMap)
 	{
 		AGAGridActor* Grid = GetGridActor();
-		Grid->DebugGridMap = OccupancyMap;
+		// Only the cells that changed since last frame get copied (and redrawn). The pyramid keeps the
+		// debug texture's max value lookup from scanning the whole map.
+		if (!Grid->DebugGridMap.HasPyramid())
+		{
+			Grid->DebugGridMap.SetPyramidEnabled(true);
+		}
+		// GetOccupancyMap brings the map up to date; the copy consumes its dirty box, so it takes the map itself
+		GetOccupancyMap();
+		Grid->DebugGridMap.CopyDirtyCellsFrom(OccupancyMap);
 		GridActor->RefreshDebugTexture();
 		GridActor->DebugMeshComponent->SetVisibility(true);
 	}
@@ -146,18 +207,72 @@ void UGATargetComponent::OccupancyMapSetPosition(const FVector& Position)
 	const AGAGridActor* Grid = GetGridActor();
 	bDebugOccupancyMap = true;
 
+	if (OccupancyPropagation == EGAOccupancyPropagation::ParticleFilter)
+	{
+		// All the particles go back to where the target is. The map catches up when it's next asked for.
+		if (Grid)
+		{
+			OccupancyParticles.Seed(Grid, Position, ParticleCount, MaxTargetSpeed, ParticleRandom);
+			LastSeenCell = Grid->GetCellRef(Position);
+			LastSeenTime = GetWorld()->GetTimeSeconds();
+			bOccupancyMapStale = true;
+			OccupancyMapVersion++;
+		}
+		return;
+	}
+
+	// The grid may not have been registered yet when we were
+	if (!OccupancyMap.IsValid() && Grid)
+	{
+		InitOccupancyMap(Grid);
+	}
+
 	if (!OccupancyMap.IsValid())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Occupancy map is not valid."));
 		return;
 	}
 
-	// Reset the occupancy map to 0.0
-	OccupancyMap.ResetData(0.0f);
+	// Reset the occupancy map to 0.0. Only the active box can have anything else in it.
+	GAGridMapOps::Fill(OccupancyMap, OccupancyActiveBox, 0.0f);
 
 	// Set the probability of the cell corresponding to the given position to 1.0
 	const FCellRef OccupiedTile = Grid->GetCellRef(Position);
-	OccupancyMap.SetValue(OccupiedTile, 1.0f);
+	OccupancyActiveBox = OccupancyMap.SetValue(OccupiedTile, 1.0f) ? FGridBox(OccupiedTile.X, OccupiedTile.X, OccupiedTile.Y, OccupiedTile.Y) : FGridBox();
+	PendingBlurVariance = 0.0f;
+	LastSeenCell = OccupiedTile;
+	LastSeenTime = GetWorld()->GetTimeSeconds();
+	bOccupancyReachabilityStarted = false;
+	OccupancyMapVersion++;
+}
+
+const FGAGridMap& UGATargetComponent::GetOccupancyMap() const
+{
+	if (bOccupancyMapStale && (OccupancyPropagation == EGAOccupancyPropagation::ParticleFilter))
+	{
+		const AGAGridActor* Grid = GetGridActor();
+		if (Grid && !OccupancyMap.IsValid())
+		{
+			InitOccupancyMap(Grid);
+		}
+
+		// Note, OccupancyMap, OccupancyActiveBox and OccupancyParticles are mutable, which is why this is allowed in
+		// a const method.
+		// The version was bumped when the particles changed, so nothing else needs to know.
+		OccupancyParticles.Rasterize(OccupancyMap, OccupancyActiveBox);
+		bOccupancyMapStale = false;
+	}
+	return OccupancyMap;
+}
+
+const FGASummedAreaTable& UGATargetComponent::GetOccupancySumTable() const
+{
+	if ((OccupancySumTableVersion != OccupancyMapVersion) || (OccupancySumTable.IsValid() != OccupancyMap.IsValid()))
+	{
+		OccupancySumTable.Build(GetOccupancyMap());
+		OccupancySumTableVersion = OccupancyMapVersion;
+	}
+	return OccupancySumTable;
 }
 
 // Helper function to check if a location is blocked
@@ -180,9 +295,8 @@ bool UGATargetComponent::IsLocationBlocked(const FVector& Location)
 void UGATargetComponent::OccupancyMapUpdate()
 {
 	const AGAGridActor* Grid = GetGridActor();
-	if (Grid)
+	if (Grid && OccupancyMap.IsValid())
 	{
-		FGAGridMap VisibilityMap(Grid, 0.0f);
 		float minVal = FLT_MAX;
 		float maxVal = -FLT_MAX;
 
@@ -194,8 +308,11 @@ void UGATargetComponent::OccupancyMapUpdate()
 		if (PerceptionSystem)
 		{
 			TArray<TObjectPtr<UGAPerceptionComponent>>& PerceptionComponents = PerceptionSystem->GetAllPerceptionComponents();
-			for (int x = 0; x < Grid->XCount; ++x) {
-				for (int y = 0; y < Grid->YCount; ++y) {
+			// Everything outside the active box is 0, so only the active box needs looking at. It's clipped to the
+			// occupancy map's own bounds, so the unchecked accesses below stay inside the map.
+			const FGridBox Bounds = OccupancyActiveBox.GetOverlap(OccupancyMap.GridBounds);
+			for (int x = Bounds.MinX; x <= Bounds.MaxX; ++x) {
+				for (int y = Bounds.MinY; y <= Bounds.MaxY; ++y) {
 					FCellRef cellReference = FCellRef(x, y);
 
 					for (UGAPerceptionComponent* PerceptionComponent : PerceptionComponents) {
@@ -206,8 +323,7 @@ void UGATargetComponent::OccupancyMapUpdate()
 						else {
 							hiddenCells.Add(cellReference);
 							allCells.Add(cellReference);
-							float valueAt;
-							OccupancyMap.GetValue(cellReference, valueAt);
+							float valueAt = OccupancyMap.GetValueUnchecked(x, y);
 
 							minVal = FMath::Min(minVal, valueAt);
 							maxVal = FMath::Max(maxVal, valueAt);
@@ -217,61 +333,55 @@ void UGATargetComponent::OccupancyMapUpdate()
 			}
 		}
 
+		// The cells we skipped are all 0, whether they're visible or hidden
+		if (OccupancyActiveBox.GetOverlap(OccupancyMap.GridBounds) != OccupancyMap.GridBounds)
+		{
+			minVal = FMath::Min(minVal, 0.0f);
+		}
+
 		for (FCellRef ref : visibleCells) {
-			OccupancyMap.SetValue(ref, 0.0f);
+			OccupancyMap.SetValueUnchecked(ref.X, ref.Y, 0.0f);
+			OccupancyMap.MarkDirty(ref.X, ref.Y);
 			minVal = 0.0f;
 		}
 
-		FCellRef HighestLikelihoodCell;
-		float MaxLikelihood = -1.0f;
-		FVector CellPosition;
-
 		float NormalizationFactor = maxVal - minVal;
 		if (NormalizationFactor != 0.0f)
 		{
 			for (FCellRef cellReference : hiddenCells)
 			{
-				float valueAt;
-				OccupancyMap.GetValue(cellReference, valueAt);
-				float value = FMath::Clamp((valueAt - minVal) / NormalizationFactor, 0.0f, 1.0f);
-				OccupancyMap.SetValue(cellReference, value);
-				if (value > MaxLikelihood)
-				{
-					FCellRef tempCell = HighestLikelihoodCell;
-					float tempLikelihood = MaxLikelihood;
-					HighestLikelihoodCell = cellReference;
-					MaxLikelihood = value;
-
-					if (Grid->IsValidCell(HighestLikelihoodCell)) {
-						CellPosition = Grid->GetCellPosition(HighestLikelihoodCell) + FVector(0.0f, 0.0f, 100.0f);
-
-						// Clamp the X and Y coordinates within the valid range
-						HighestLikelihoodCell.X = FMath::Clamp(HighestLikelihoodCell.X, 0, 99);
-						HighestLikelihoodCell.Y = FMath::Clamp(HighestLikelihoodCell.Y, 0, 99);
-
-						// Recalculate the position based on the clamped coordinates
-						CellPosition = Grid->GetCellPosition(HighestLikelihoodCell) + FVector(0.0f, 0.0f, 100.0f);
-
-						// Create a sphere collider
-						FCollisionShape SphereShape = FCollisionShape::MakeSphere(50.0f);
-						FCollisionQueryParams Params;
-						Params.AddIgnoredActor(GetOwner());
+				float& valueAt = OccupancyMap.GetValueUnchecked(cellReference.X, cellReference.Y);
+				valueAt = FMath::Clamp((valueAt - minVal) / NormalizationFactor, 0.0f, 1.0f);
+				OccupancyMap.MarkDirty(cellReference.X, cellReference.Y);
+			}
+		}
 
-						// Check if location is blocked using our helper function
-						if (IsLocationBlocked(CellPosition))
-						{
-							HighestLikelihoodCell = tempCell;
-							MaxLikelihood = tempLikelihood;
+		// The most likely cell that isn't blocked. The map's pyramid hands the candidates back best first, so this
+		// only visits the parts of the map that hold them, and we usually only need to test the first one or two.
+		const int32 MaxCandidates = 8;
+		TArray<FCellRef> Candidates;
+		GAGridMapOps::FindTopCells(OccupancyMap, MaxCandidates, Candidates);
 
-							FVector debugCellPos = Grid->GetCellPosition(HighestLikelihoodCell);
-						}
-					}
-				}
+		FCellRef HighestLikelihoodCell;
+		FVector CellPosition = LastKnownState.Position;
+		for (const FCellRef& Candidate : Candidates)
+		{
+			FVector CandidatePosition = Grid->GetCellPosition(Candidate) + FVector(0.0f, 0.0f, 100.0f);
+			if (!IsLocationBlocked(CandidatePosition))
+			{
+				HighestLikelihoodCell = Candidate;
+				CellPosition = CandidatePosition;
+				break;
 			}
 		}
 
+		OccupancyMapVersion++;
+
 		LastKnownState.Set(CellPosition, LastKnownState.Velocity);
-		DrawDebugSphere(GetWorld(), Grid->GetCellPosition(HighestLikelihoodCell), 50, 1, FColor::Green, true, 10, 1, .5f);
+		if (HighestLikelihoodCell.IsValid())
+		{
+			DrawDebugSphere(GetWorld(), Grid->GetCellPosition(HighestLikelihoodCell), 50, 1, FColor::Green, true, 10, 1, .5f);
+		}
 	}
 
 }
@@ -281,71 +391,198 @@ void UGATargetComponent::OccupancyMapDiffuse()
 {
 	// TODO PART 4
 	// Diffuse the probability in the OMAP
-	AGAGridActor* Grid = GetGridActor();
 	if (!OccupancyMap.IsValid())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Occupancy map is not valid."));
 		return;
 	}
 
-	const int XCount = Grid->XCount;
-	const int YCount = Grid->YCount;
+	const int32 Iterations = 20;
+
+	// Only rebuilds its coefficients when the grid changes, so probability never diffuses into walls
+	OccupancyDiffusion.Prepare(GetGridActor(), OccupancyMap.GridBounds, OccupancyDiffusionFactor);
+
+	// Works on (and updates) the active box, so right after the target was seen this only touches the few cells it
+	// could have reached
+	if (!OccupancyDiffusion.Diffuse(OccupancyMap, Iterations, OccupancyActiveBox, OccupancyNegligibleProbability))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Occupancy map diffusion isn't set up for this map."));
+		return;
+	}
+	OccupancyMapVersion++;
+}
+
+
+void UGATargetComponent::OccupancyMapBlur(float DeltaTime)
+{
+	const AGAGridActor* Grid = GetGridActor();
+	if (!Grid || !OccupancyMap.IsValid() || (Grid->CellScale <= 0.0f))
+	{
+		return;
+	}
+
+	// t seconds after the target was seen, it's spread out with a standard deviation of
+	//
+	//		Sigma(t) = OccupancyBlurSpreadScale * Speed * t
+	//
+	// along each axis (in cells). Blurs add variances, so this tick owes Sigma(t)^2 - Sigma(t - DeltaTime)^2, and
+	// however the time is split into ticks the blurs add up to Sigma(t)^2.
+	const float SpeedInCells = ExpectedTargetSpeed / Grid->CellScale;
+	const float TimeSinceSeen = FMath::Max(GetWorld()->GetTimeSeconds() - LastSeenTime, 0.0f);
+	const float Sigma = OccupancyBlurSpreadScale * SpeedInCells * TimeSinceSeen;
+	const float LastSigma = OccupancyBlurSpreadScale * SpeedInCells * FMath::Max(TimeSinceSeen - DeltaTime, 0.0f);
+	PendingBlurVariance += Sigma * Sigma - LastSigma * LastSigma;
+
+	const int32 Radius = FGAGridDiffusion::GetBlurRadius(PendingBlurVariance);
+	if (Radius <= 0)
+	{
+		// Not enough yet for the smallest blur
+		return;
+	}
+
+	OccupancyDiffusion.Prepare(Grid, OccupancyMap.GridBounds, OccupancyDiffusionFactor);
+	if (OccupancyDiffusion.Blur(OccupancyMap, Radius, OccupancyActiveBox, OccupancyNegligibleProbability))
+	{
+		PendingBlurVariance -= FGAGridDiffusion::GetBlurVariance(Radius);
+		OccupancyMapVersion++;
+	}
+}
 
-	FGAGridMap diffusionMap(Grid, 0.0f);
-	diffusionMap = OccupancyMap;
 
-	// Diffusion parameters
-	const float DiffusionFactor = 0.4f; 
-	const float InverseDiffusionFactor = 1.0f - DiffusionFactor;
+void UGATargetComponent::OccupancyMapReach()
+{
+	const AGAGridActor* Grid = GetGridActor();
+	if (!Grid || !OccupancyMap.IsValid())
+	{
+		return;
+	}
 
-	// Diffuse the probability from each cell to its neighboring cells
-	for (int i = 0; i < 20; ++i) {
-		for (int X = 0; X < XCount; ++X)
+	// The search starts once per sighting, from where the target was seen. Every tick after that only carries it on
+	// over the cells the target could have got to since the last one.
+	if (!bOccupancyReachabilityStarted)
+	{
+		OccupancyReachability.Start(Grid, LastSeenCell);
+		bOccupancyReachabilityStarted = true;
+	}
+	if (!OccupancyReachability.IsStarted())
+	{
+		// Seen somewhere off the grid (or in a blocked cell), so there's nothing to go on
+		return;
+	}
+
+	const float TimeSinceSeen = GetWorld()->GetTimeSeconds() - LastSeenTime;
+	const float MaxDistance = MaxTargetSpeed * TimeSinceSeen;
+
+	// Everywhere that's just become reachable is as likely as anywhere else the target hasn't been ruled out of.
+	// (The update normalizes the map to a max of 1.) Each cell only comes up once per sighting, even if the search
+	// has to start over because the grid changed, so this never undoes what the perceivers have cleared.
+	TArray<FCellRef> NewCells;
+	OccupancyReachability.Expand(Grid, MaxDistance, &NewCells);
+	for (const FCellRef& Cell : NewCells)
+	{
+		if (OccupancyMap.GridBounds.IsValidCell(Cell.X, Cell.Y))
 		{
-			for (int Y = 0; Y < YCount; ++Y)
-			{
-				int adjacentNeighbors = 0;
-				float totalValues = 0.0f;
+			OccupancyMap.SetValueUnchecked(Cell.X, Cell.Y, 1.0f);
+			OccupancyMap.MarkDirty(Cell.X, Cell.Y);
+			OccupancyActiveBox = OccupancyActiveBox.GetUnion(FGridBox(Cell.X, Cell.X, Cell.Y, Cell.Y));
+		}
+	}
 
-				// Iterate over neighboring cells (including diagonals)
-				for (int dX = -1; dX <= 1; ++dX)
+	// Cells the perceivers have cleared fill back in from their neighbors, since the target could have walked into
+	// them after they were looked at. A couple of steps of the usual diffusion do that, and then anything it pushed
+	// past the reachable cells is taken back out, so the work stays within the box the target could be in.
+	const int32 RefillIterations = 2;
+	OccupancyDiffusion.Prepare(Grid, OccupancyMap.GridBounds, OccupancyDiffusionFactor);
+	if (OccupancyDiffusion.Diffuse(OccupancyMap, RefillIterations, OccupancyActiveBox, OccupancyNegligibleProbability))
+	{
+		const FGridBox ActiveBox = OccupancyActiveBox;
+		for (int32 Y = ActiveBox.MinY; Y <= ActiveBox.MaxY; Y++)
+		{
+			for (int32 X = ActiveBox.MinX; X <= ActiveBox.MaxX; X++)
+			{
+				if (!OccupancyReachability.IsReached(X, Y))
 				{
-					for (int dY = -1; dY <= 1; ++dY)
-					{
-						int NeighborX = X + dX;
-						int NeighborY = Y + dY;
-						FCellRef neighbor;
-						neighbor.X = NeighborX;
-						neighbor.Y = NeighborY;
-
-						// Ensure the neighbor is within bounds
-						if (Grid->IsValidCell(neighbor))
-						{
-
-							float NeighborValue;
-							diffusionMap.GetValue(neighbor, NeighborValue);
-							totalValues += NeighborValue;
-							++adjacentNeighbors;
-
-						}
-					}
+					OccupancyMap.SetValueUnchecked(X, Y, 0.0f);
 				}
-				FCellRef currCell;
-				currCell.X = X;
-				currCell.Y = Y;
+			}
+		}
+		OccupancyActiveBox = ActiveBox.GetOverlap(OccupancyReachability.GetReachedBox());
+	}
 
-				float currVal;
-				diffusionMap.GetValue(currCell, currVal);
+	OccupancyMapVersion++;
+}
 
-				float diffusion = (InverseDiffusionFactor)*currVal + (DiffusionFactor / adjacentNeighbors) * totalValues;
 
-				diffusionMap.SetValue(currCell, diffusion);
+void UGATargetComponent::OccupancyParticlesUpdate()
+{
+	const AGAGridActor* Grid = GetGridActor();
+	UGAPerceptionSystem* PerceptionSystem = UGAPerceptionSystem::GetPerceptionSystem(this);
+	if (!Grid || !PerceptionSystem || (OccupancyParticles.Num() == 0))
+	{
+		return;
+	}
 
+	// The target isn't anywhere a perceiver can see. Only the cells with particles in them get tested, once each,
+	// so this goes with the number of particles rather than the size of the map.
+	TArray<TObjectPtr<UGAPerceptionComponent>>& PerceptionComponents = PerceptionSystem->GetAllPerceptionComponents();
+	OccupancyParticles.Cull([&](const FCellRef& Cell)
+	{
+		const FVector CellPosition = Grid->GetCellPosition(Cell) + FVector::UpVector * 50.0f;
+		for (UGAPerceptionComponent* PerceptionComponent : PerceptionComponents)
+		{
+			if (PerceptionComponent->IsPerceived(CellPosition))
+			{
+				return true;
 			}
 		}
+		return false;
+	});
+	OccupancyParticles.Resample(Grid, ParticleCount, MaxTargetSpeed, ParticleRandom);
+
+	// Particles only ever sit in traversable cells, so the densest one needs no further checks
+	const FCellRef DensestCell = OccupancyParticles.GetDensestCell();
+	if (DensestCell.IsValid())
+	{
+		LastKnownState.Set(Grid->GetCellPosition(DensestCell) + FVector(0.0f, 0.0f, 100.0f), LastKnownState.Velocity);
 	}
 
+	bOccupancyMapStale = true;
+	OccupancyMapVersion++;
+}
+
 
-	// Update the occupancy map with the diffused values
-	OccupancyMap = diffusionMap;
-}
\ No newline at end of file
+void UGATargetComponent::OccupancyParticlesPredict(float DeltaTime)
+{
+	const AGAGridActor* Grid = GetGridActor();
+	if (!Grid || (OccupancyParticles.Num() == 0))
+	{
+		return;
+	}
+
+	OccupancyParticles.Predict(Grid, DeltaTime, ParticleRandom);
+	bOccupancyMapStale = true;
+	OccupancyMapVersion++;
+}
+
+
+void UGATargetComponent::OccupancyMapPropagate(float DeltaTime)
+{
+	switch (OccupancyPropagation)
+	{
+	case EGAOccupancyPropagation::GaussianBlur:
+		OccupancyMapBlur(DeltaTime);
+		break;
+
+	case EGAOccupancyPropagation::Reachability:
+		OccupancyMapReach();
+		break;
+
+	case EGAOccupancyPropagation::ParticleFilter:
+		OccupancyParticlesPredict(DeltaTime);
+		break;
+
+	default:
+		OccupancyMapDiffuse();
+		break;
+	}
+}
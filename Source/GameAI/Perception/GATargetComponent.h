@@ -3,6 +3,10 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "GameAI/Grid/GAGridMap.h"
+#include "GameAI/Grid/GASummedAreaTable.h"
+#include "GameAI/Grid/GAGridDiffusion.h"
+#include "GameAI/Grid/GAGridReachability.h"
+#include "GameAI/Grid/GAParticleFilter.h"
 #include "GATargetComponent.generated.h"
 
 
@@ -17,6 +21,25 @@ enum ETargetState
 };
 
 
+// How the occupancy map spreads the target's probability out over time while it's hidden
+UENUM(BlueprintType)
+enum class EGAOccupancyPropagation : uint8
+{
+	// A fixed number of 3x3 diffusion steps every tick (see GAGridDiffusion.h)
+	Diffusion			UMETA(DisplayName = "Diffusion"),
+
+	// One obstacle-aware Gaussian blur, sized from how far the target could have wandered since the last one
+	GaussianBlur		UMETA(DisplayName = "Gaussian blur"),
+
+	// Only the cells the target could have got to along a path since it was last seen, at MaxTargetSpeed
+	Reachability		UMETA(DisplayName = "Reachability"),
+
+	// A cloud of particles instead of a probability per cell (see GAParticleFilter.h). OccupancyMap is only filled
+	// in from them when something asks for it.
+	ParticleFilter		UMETA(DisplayName = "Particle filter"),
+};
+
+
 // Cached information about a target
 USTRUCT(BlueprintType)
 struct FTargetCache
@@ -59,12 +82,41 @@ class UGATargetComponent : public UActorComponent
 	
 	// Occupancy Map
 
-	UPROPERTY(BlueprintReadOnly)
-	FGAGridMap OccupancyMap;
+	// With the particle filter this is only brought up to date when it's asked for, through GetOccupancyMap, which
+	// is why it (and the active box) are mutable. Blueprints read it through GetOccupancyMap too, so they never see
+	// it stale.
+	UPROPERTY()
+	mutable FGAGridMap OccupancyMap;
+
+	// Goes up by one every time OccupancyMap changes
+	int32 OccupancyMapVersion;
+
+	// Bounds of the cells of OccupancyMap that aren't 0. Diffusion and the update only work inside it.
+	mutable FGridBox OccupancyActiveBox;
 
 	UPROPERTY(BlueprintReadOnly)
 	bool bDebugOccupancyMap;
 
+	// How the occupancy map spreads out while the target is hidden
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameAI|Target")
+	EGAOccupancyPropagation OccupancyPropagation;
+
+	// How fast the target is assumed to move (cm/s) when OccupancyPropagation is GaussianBlur. It's taken to head off
+	// at this speed in a direction we know nothing about, so t seconds after it was last seen the probability is
+	// spread over about ExpectedTargetSpeed * t cm (a standard deviation of that over sqrt(2) along each axis),
+	// whatever the frame rate.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameAI|Target", meta = (ClampMin = "0"))
+	float ExpectedTargetSpeed;
+
+	// The fastest the target can move (cm/s) when OccupancyPropagation is Reachability. Cells further along a path
+	// from where it was last seen than this times the time since then never get any probability.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameAI|Target", meta = (ClampMin = "0"))
+	float MaxTargetSpeed;
+
+	// Number of particles when OccupancyPropagation is ParticleFilter. They move at up to MaxTargetSpeed.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GameAI|Target", meta = (ClampMin = "1"))
+	int32 ParticleCount;
+
 
 	// Cached pointer to the grid actor
 	UPROPERTY()
@@ -85,6 +137,14 @@ class UGATargetComponent : public UActorComponent
 	UFUNCTION(BlueprintCallable)
 	AGAGridActor *GetGridActor() const;
 
+	// OccupancyMap, filled in from the particles first if need be
+	UFUNCTION(BlueprintPure, Category = "GameAI|Target")
+	const FGAGridMap& GetOccupancyMap() const;
+
+	// Summed-area table of OccupancyMap, for the probability of the target being in any box in constant time
+	// (see GASummedAreaTable.h). Rebuilt on demand the first time it's asked for after the map changes.
+	const FGASummedAreaTable& GetOccupancySumTable() const;
+
 	// Return TRUE if at least ONE AI has reach Awareness == 1 for this target
 	bool IsKnown() const
 	{
@@ -104,5 +164,41 @@ class UGATargetComponent : public UActorComponent
 	void OccupancyMapSetPosition(const FVector &Position);
 	void OccupancyMapUpdate();
 	void OccupancyMapDiffuse();
+	void OccupancyMapBlur(float DeltaTime);
+	void OccupancyMapReach();
+	void OccupancyParticlesUpdate();
+	void OccupancyParticlesPredict(float DeltaTime);
+
+	// Spread the occupancy map out by DeltaTime's worth, the way OccupancyPropagation says
+	void OccupancyMapPropagate(float DeltaTime);
+
+private:
+	// Allocate OccupancyMap for Grid, all zeros
+	void InitOccupancyMap(const AGAGridActor* Grid) const;
+
+	mutable FGASummedAreaTable OccupancySumTable;
+	mutable int32 OccupancySumTableVersion;
+
+	FGAGridDiffusion OccupancyDiffusion;
+
+	// Variance (in cells squared, along each axis) the blur still owes the map: blurs come in whole radii, so
+	// whatever a tick's worth doesn't cover is carried over to the next one
+	float PendingBlurVariance;
+
+	// Where and when (world time) the target was last seen
+	FCellRef LastSeenCell;
+	float LastSeenTime;
+
+	// Path distances out from LastSeenCell, as far as the target could have got so far. Started the first time
+	// they're needed after each sighting.
+	FGAGridReachability OccupancyReachability;
+	bool bOccupancyReachabilityStarted;
+
+	// Mutable only for the scratch space Rasterize uses, see GetOccupancyMap
+	mutable FGAParticleFilter OccupancyParticles;
+	FRandomStream ParticleRandom;
+
+	// Set when the particles have moved on since OccupancyMap was last filled in from them
+	mutable bool bOccupancyMapStale;
 
 };
\ No newline at end of file
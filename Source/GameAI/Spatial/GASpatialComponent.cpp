@@ -1,6 +1,11 @@
 #include "GASpatialComponent.h"
 #include "GameAI/Pathfinding/GAPathComponent.h"
 #include "GameAI/Grid/GAGridMap.h"
+#include "GameAI/Grid/GATypedGridMap.h"
+#include "GameAI/Grid/GAGridMapPool.h"
+#include "GameAI/Grid/GASummedAreaTable.h"
+#include "GameAI/Perception/GATargetComponent.h"
+#include "GameAI/Grid/GAGridSubsystem.h"
 #include "Kismet/GameplayStatics.h"
 #include "Math/MathFwd.h"
 #include "GASpatialFunction.h"
@@ -14,19 +19,33 @@ UGASpatialComponent::UGASpatialComponent(const FObjectInitializer& ObjectInitial
 {
     // Initialize the sampling range for evaluating the spatial function
     SampleDimensions = 8000.0f;
+    bHalfPrecisionScores = false;
 }
 
 // Retrieves and caches the grid actor instance in the world
 const AGAGridActor* UGASpatialComponent::GetGridActor() const
 {
+    // Score on whichever grid our path component is on, so our distance maps and its paths agree
+    const UGAPathComponent* PathComp = GetPathComponent();
+    if (PathComp)
+    {
+        if (const AGAGridActor* PathGrid = PathComp->GetGridActor())
+            return PathGrid;
+    }
+
     AGAGridActor* Result = GridActor.Get();
     if (Result)
     {
         return Result;
     }
-    // Locate and cache the grid actor
-    AActor* GenericResult = UGameplayStatics::GetActorOfClass(this, AGAGridActor::StaticClass());
-    Result = Cast<AGAGridActor>(GenericResult);
+    // Locate and cache the grid actor we're standing on
+    UGAGridSubsystem* GridSubsystem = UGAGridSubsystem::Get(this);
+    if (!GridSubsystem)
+        return nullptr;
+    const APawn* OwnerPawn = GetOwnerPawn();
+    Result = OwnerPawn ? GridSubsystem->FindGridAt(OwnerPawn->GetActorLocation()) : nullptr;
+    if (!Result)
+        Result = GridSubsystem->GetDefaultGrid();
     if (Result)
     {
         GridActor = Result;
@@ -100,11 +119,42 @@ bool UGASpatialComponent::ChoosePosition(bool PathfindToPosition, bool Debug)
         return false;
 
     FGridBox GridBox(CellRect);
-    FGAGridMap GridMap(Grid, GridBox, 0.0f);
-    FGAGridMap DistanceMap(Grid, GridBox, FLT_MAX);
+    FGAScopedGridMap DistanceMap(Grid, GridBox, FLT_MAX);
 
     // Step 1: gather reachable cells via Dijkstra
-    PathComp->Dijkstra(PawnLoc3D, DistanceMap);
+    PathComp->Dijkstra(PawnLoc3D, *DistanceMap);
+
+    // Steps 2 and 3: score the reachable cells and pick the best one
+    FCellRef Chosen = bHalfPrecisionScores
+        ? ScorePositions<FGAGridMapHalf>(Grid, SpatialFunc, *DistanceMap)
+        : ScorePositions<FGAGridMap>(Grid, SpatialFunc, *DistanceMap);
+    BestCell = Chosen;
+    Result = BestCell.IsValid();
+
+    // Step 4: optionally pathfind to chosen cell
+    if (PathfindToPosition)
+    {
+        if (BestCell.IsValid())
+            PathComp->BuildPathFromDistanceMap(PawnLoc3D, BestCell, *DistanceMap);
+        else
+            PathComp->ClearPath();
+    }
+    return Result;
+}
+
+/**
+ * Scores every reachable cell of DistanceMap with the spatial function and returns the best one.
+ * ScoreMapType is FGAGridMap, or a TGAGridMap for lower precision scores.
+ */
+template<typename ScoreMapType>
+FCellRef UGASpatialComponent::ScorePositions(const AGAGridActor* Grid, const UGASpatialFunction* SpatialFunc, const FGAGridMap& DistanceMap) const
+{
+    typedef typename TGAGridMapStorage<ScoreMapType>::ValueType ScoreValueType;
+    typedef typename TGAGridMapStorage<ScoreMapType>::Traits ScoreTraits;
+
+    const FGridBox& GridBox = DistanceMap.GridBounds;
+    TGAScopedGridMap<ScoreMapType> ScopedGridMap(Grid, GridBox, 0.0f);
+    ScoreMapType& GridMap = *ScopedGridMap;
     GridMap.SetValue(BestCell, SpatialFunc->LastCellBonus);
 
     // Step 2: evaluate each spatial function layer
@@ -114,47 +164,58 @@ bool UGASpatialComponent::ChoosePosition(bool PathfindToPosition, bool Debug)
     }
 
     // Step 3: select best-scoring cell
+    // Both maps cover GridBox, so we can walk them without per-cell checks
     float BestScore = -FLT_MAX;
     FCellRef Chosen = FCellRef::Invalid;
-    for (int32 Y = GridBox.MinY; Y <= GridBox.MaxY; ++Y)
+    if (DistanceMap.IsValid() && GridMap.IsValid())
     {
-        for (int32 X = GridBox.MinX; X <= GridBox.MaxX; ++X)
+        for (int32 Y = GridBox.MinY; Y <= GridBox.MaxY; ++Y)
         {
-            FCellRef Cell(X, Y);
-            float Dist;
-            if (DistanceMap.GetValue(Cell, Dist) && Dist < FLT_MAX)
+            if constexpr (GAGridLayout::bRowsAreContiguous)
             {
-                float Score;
-                GridMap.GetValue(Cell, Score);
-                if (Score > BestScore)
+                TArrayView<const float> DistanceRow = DistanceMap.GetRow(Y);
+                TArrayView<const ScoreValueType> ScoreRow = static_cast<const ScoreMapType&>(GridMap).GetRow(Y);
+                for (int32 LocalX = 0; LocalX < ScoreRow.Num(); ++LocalX)
                 {
-                    BestScore = Score;
-                    Chosen = Cell;
+                    if (DistanceRow[LocalX] < FLT_MAX)
+                    {
+                        float Score = ScoreTraits::Decode(ScoreRow[LocalX]);
+                        if (Score > BestScore)
+                        {
+                            BestScore = Score;
+                            Chosen = FCellRef(GridBox.MinX + LocalX, Y);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                for (int32 X = GridBox.MinX; X <= GridBox.MaxX; ++X)
+                {
+                    if (DistanceMap.GetValueUnchecked(X, Y) < FLT_MAX)
+                    {
+                        float Score = GridMap.GetValueUnchecked(X, Y);
+                        if (Score > BestScore)
+                        {
+                            BestScore = Score;
+                            Chosen = FCellRef(X, Y);
+                        }
+                    }
                 }
             }
         }
     }
-    BestCell = Chosen;
-    Result = BestCell.IsValid();
-
-    // Step 4: optionally pathfind to chosen cell
-    if (PathfindToPosition)
-    {
-        if (BestCell.IsValid())
-            PathComp->BuildPathFromDistanceMap(PawnLoc3D, BestCell, DistanceMap);
-        else
-            PathComp->ClearPath();
-    }
-    return Result;
+    return Chosen;
 }
 
 /**
  * Evaluates a single layer of the spatial function for each traversable cell.
  */
+template<typename ScoreMapType>
 void UGASpatialComponent::EvaluateLayer(
     const FFunctionLayer& Layer,
     const FGAGridMap& DistanceMap,
-    FGAGridMap& GridMap
+    ScoreMapType& GridMap
 ) const
 {
     // Get world, grid, and target info
@@ -163,56 +224,98 @@ void UGASpatialComponent::EvaluateLayer(
     APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
     FTargetCache TC;
     FTargetData TD;
-    if (!GetOwner()->GetComponentByClass<UGAPerceptionComponent>()
-        ->GetCurrentTargetState(TC, TD))
+    const UGAPerceptionComponent* PerceptionComp = GetOwner()->GetComponentByClass<UGAPerceptionComponent>();
+    if (!PerceptionComp->GetCurrentTargetState(TC, TD))
         return;
     FVector TargetPos = TC.Position;
     FVector Offset(0, 0, 60);
 
+    // The windowed inputs sum over a box around each cell. They read a summed-area table, so that's four
+    // lookups per cell whatever the window size.
+    const FGASummedAreaTable* WindowTable = nullptr;
+    const int32 WindowCells = (Grid->CellScale > 0.f) ? FMath::Max(0, FMath::RoundToInt(Layer.WindowRadius / Grid->CellScale)) : 0;
+    if (Layer.Input == SI_OccupancyMass)
+    {
+        // The occupancy map is in the target's grid's cells, so it only means anything if that's our grid too
+        const UGATargetComponent* Target = PerceptionComp->GetCurrentTarget();
+        if (Target && (Target->GetGridActor() == Grid))
+            WindowTable = &Target->GetOccupancySumTable();
+    }
+    else if (Layer.Input == SI_BlockedFraction)
+    {
+        WindowTable = &Grid->GetTraversableSumTable();
+    }
+
+    typedef typename TGAGridMapStorage<ScoreMapType>::ValueType ScoreValueType;
+    typedef typename TGAGridMapStorage<ScoreMapType>::Traits ScoreTraits;
+
     // Loop through each cell in the sampling box
-    for (int32 Y = GridMap.GridBounds.MinY; Y <= GridMap.GridBounds.MaxY; ++Y)
-        for (int32 X = GridMap.GridBounds.MinX; X <= GridMap.GridBounds.MaxX; ++X)
-        {
-            FCellRef C(X, Y);
-            ECellData CD = Grid->GetCellData(C);
-            if (!EnumHasAllFlags(CD, ECellData::CellDataTraversable)) continue;
+    // Both maps cover the same box, so only the maps themselves need checking
+    if (!GridMap.IsValid() || !DistanceMap.IsValid())
+        return;
+    for (TGAGridMapCell<ScoreValueType> Cell : GridMap.Cells())
+    {
+        const int32 X = Cell.X;
+        const int32 Y = Cell.Y;
+        FCellRef C(X, Y);
+        ECellData CD = Grid->GetCellData(C);
+        if (!EnumHasAllFlags(CD, ECellData::CellDataTraversable)) continue;
 
-            float Dist;
-            if (!DistanceMap.GetValue(C, Dist) || Dist >= FLT_MAX) continue;
+        float Dist = DistanceMap.GetValueUnchecked(X, Y);
+        if (Dist >= FLT_MAX) continue;
 
-            // Compute raw layer input
-            float Raw = 0;
-            FVector CellWorld = Grid->GetCellPosition(C);
-            switch (Layer.Input)
-            {
-            case SI_None: break;
-            case SI_TargetRange: Raw = FVector::Dist(CellWorld, TargetPos); break;
-            case SI_PathDistance: Raw = Dist; break;
-            case SI_LOS:
-            {
-                FVector Start = CellWorld + Offset;
-                FHitResult Hit;
-                FCollisionQueryParams P;
-                P.AddIgnoredActor(PlayerPawn);
-                P.AddIgnoredActor(GetOwnerPawn());
-                bool bHit = World->LineTraceSingleByChannel(Hit, Start, TargetPos, ECollisionChannel::ECC_Visibility, P);
-                Raw = bHit ? 0.f : 1.f;
-                break;
-            }
-            }
+        // Compute raw layer input
+        float Raw = 0;
+        FVector CellWorld = Grid->GetCellPosition(C);
+        switch (Layer.Input)
+        {
+        case SI_None: break;
+        case SI_TargetRange: Raw = FVector::Dist(CellWorld, TargetPos); break;
+        case SI_PathDistance: Raw = Dist; break;
+        case SI_LOS:
+        {
+            FVector Start = CellWorld + Offset;
+            FHitResult Hit;
+            FCollisionQueryParams P;
+            P.AddIgnoredActor(PlayerPawn);
+            P.AddIgnoredActor(GetOwnerPawn());
+            bool bHit = World->LineTraceSingleByChannel(Hit, Start, TargetPos, ECollisionChannel::ECC_Visibility, P);
+            Raw = bHit ? 0.f : 1.f;
+            break;
+        }
+        case SI_Cover:
+        {
+            // Baked at grid build time, so no traces here
+            FVector2D ToTarget = Grid->GetGridAffine().WorldToGrid(TargetPos) - FVector2D(X + 0.5f, Y + 0.5f);
+            int32 NeighborIndex = AGAGridActor::GetNeighborIndexForDirection(ToTarget);
+            Raw = ((NeighborIndex != INDEX_NONE) && (Grid->GetCellCoverDirections(C) & (1 << NeighborIndex))) ? 1.f : 0.f;
+            break;
+        }
+        case SI_Height: Raw = Grid->GetCellFloorPosition(C).Z - TargetPos.Z; break;
+        case SI_TraversalCost: Raw = Grid->GetCellTraversalCost(C); break;
+        case SI_OccupancyMass:
+            Raw = WindowTable ? float(WindowTable->GetSum(FGASummedAreaTable::GetWindow(X, Y, WindowCells))) : 0.f;
+            break;
+        case SI_BlockedFraction:
+        {
+            // Cells off the edge of the grid count as blocked
+            FGridBox Window = FGASummedAreaTable::GetWindow(X, Y, WindowCells);
+            Raw = 1.f - float(WindowTable->GetSum(Window)) / float(Window.GetCellCount());
+            break;
+        }
+        }
 
-            // Apply response curve and combine
-            float EvalVal = Layer.ResponseCurve.GetRichCurveConst()->Eval(Raw, Raw);
-            float Curr = 0, Out = 0;
-            GridMap.GetValue(C, Curr);
-            switch (Layer.Op)
-            {
-            case SO_None:     Out = Curr;                break;
-            case SO_Add:      Out = Curr + EvalVal;        break;
-            case SO_Multiply: Out = Curr * EvalVal;        break;
-            }
-            GridMap.SetValue(C, Out);
+        // Apply response curve and combine
+        float EvalVal = Layer.ResponseCurve.GetRichCurveConst()->Eval(Raw, Raw);
+        float Curr = ScoreTraits::Decode(Cell.Value), Out = 0;
+        switch (Layer.Op)
+        {
+        case SO_None:     Out = Curr;                break;
+        case SO_Add:      Out = Curr + EvalVal;        break;
+        case SO_Multiply: Out = Curr * EvalVal;        break;
         }
+        Cell.Value = ScoreTraits::Encode(Out);
+    }
 }
 
 UE_ENABLE_OPTIMIZATION
@@ -55,7 +55,17 @@ class UGASpatialComponent : public UActorComponent
 	UFUNCTION(BlueprintCallable)
 	bool ChoosePosition(bool PathfindToPosition, bool Debug);
 
-	void EvaluateLayer(const FFunctionLayer& Layer, const FGAGridMap& DistanceMap, FGAGridMap& GridMap) const;
+	// Accumulate the spatial function scores in half floats rather than full floats. Halves the memory traffic
+	// of the layer passes; scores keep about 3 significant digits.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	bool bHalfPrecisionScores;
+
+	// ScoreMapType is FGAGridMap or a TGAGridMap (see GATypedGridMap.h)
+	template<typename ScoreMapType>
+	FCellRef ScorePositions(const AGAGridActor* Grid, const UGASpatialFunction* SpatialFunc, const FGAGridMap& DistanceMap) const;
+
+	template<typename ScoreMapType>
+	void EvaluateLayer(const FFunctionLayer& Layer, const FGAGridMap& DistanceMap, ScoreMapType& GridMap) const;
 
 
 };
\ No newline at end of file
@@ -13,7 +13,12 @@ enum ESpatialInput
 	SI_None				UMETA(DisplayName = "None"),
 	SI_TargetRange		UMETA(DisplayName = "Target Range"),
 	SI_PathDistance		UMETA(DisplayName = "PathDistance"),
-	SI_LOS				UMETA(DisplayName = "Line Of Sight")
+	SI_LOS				UMETA(DisplayName = "Line Of Sight"),
+	SI_Cover			UMETA(DisplayName = "Cover From Target"),		// 1 if the cell has baked cover facing the target, else 0
+	SI_Height			UMETA(DisplayName = "Height Above Target"),		// cell floor height minus the target's height
+	SI_TraversalCost	UMETA(DisplayName = "Traversal Cost"),			// the cell's step cost multiplier (1 = normal)
+	SI_OccupancyMass	UMETA(DisplayName = "Occupancy Mass"),			// total target occupancy probability within WindowRadius
+	SI_BlockedFraction	UMETA(DisplayName = "Blocked Fraction")			// fraction (0-1) of the cells within WindowRadius that are blocked
 	// Add others if you want!
 };
 
@@ -38,7 +43,7 @@ struct FFunctionLayer
 {
 	GENERATED_USTRUCT_BODY()
 
-	FFunctionLayer() : Input(SI_None), Op(SO_None) {}
+	FFunctionLayer() : Input(SI_None), Op(SO_None), WindowRadius(500.0f) {}
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere)
 	TEnumAsByte<ESpatialInput> Input;
@@ -49,6 +54,11 @@ struct FFunctionLayer
 	UPROPERTY(BlueprintReadOnly, EditAnywhere)
 	TEnumAsByte<ESpatialOp> Op;
 
+	// For the windowed inputs (Occupancy Mass, Blocked Fraction): half the side of the square around the cell
+	// that gets summed up, in world units. Rounded to whole cells. Any size costs the same.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, meta = (ClampMin = "0"))
+	float WindowRadius;
+
 };
 
 